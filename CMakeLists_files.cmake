@@ -164,8 +164,10 @@ list (APPEND PUBLIC_HEADER_FILES
              opm/models/io/dgfvanguard.hh
              opm/models/io/vtkscalarfunction.hh
              opm/models/io/vtkenergymodule.hh
+             opm/models/io/preprocessingcache.hh
              opm/models/io/restart.hh
              opm/models/io/cubegridvanguard.hh
+             opm/models/io/distributedcubegridfactory.hh
              opm/models/io/baseoutputwriter.hh
              opm/models/io/vtkmultiwriter.hh
              opm/models/io/vtkmultiphasemodule.hh
@@ -199,12 +201,16 @@ list (APPEND PUBLIC_HEADER_FILES
              opm/models/nonlinear/nullconvergencewriter.hh
              opm/models/nonlinear/newtonmethod.hh
              opm/models/nonlinear/newtonmethodproperties.hh
+             opm/models/nonlinear/newtonsubdomain.hh
+             opm/models/nonlinear/newtontelemetrywriter.hh
              opm/models/parallel/mpiutil.hh
              opm/models/parallel/tasklets.hh
              opm/models/parallel/threadmanager.hh
+             opm/models/parallel/firsttouchallocator.hh
              opm/models/parallel/gridcommhandles.hh
              opm/models/parallel/mpibuffer.hh
              opm/models/parallel/threadedentityiterator.hh
+             opm/models/parallel/weightedloadbalancing.hh
              opm/models/pvs/pvsboundaryratevector.hh
              opm/models/pvs/pvsratevector.hh
              opm/models/pvs/pvsindices.hh
@@ -231,11 +237,14 @@ list (APPEND PUBLIC_HEADER_FILES
              opm/models/utils/propertysystemmacros.hh
              opm/models/utils/pffgridvector.hh
              opm/models/utils/prefetch.hh
+             opm/models/utils/profiler.hh
              opm/models/utils/parametersystem.hh
              opm/models/utils/simulator.hh
              opm/models/utils/quadraturegeometries.hh
              opm/models/utils/alignedallocator.hh
+             opm/models/utils/allocationcounter.hh
              opm/models/utils/timer.hh
+             opm/models/utils/pidtimestepcontrol.hh
              opm/models/utils/signum.hh
              opm/models/utils/genericguard.hh
              opm/models/utils/basicproperties.hh
@@ -264,6 +273,13 @@ list (APPEND PUBLIC_HEADER_FILES
              opm/simulators/linalg/istlsolverwrappers.hh
              opm/simulators/linalg/overlaptypes.hh
              opm/simulators/linalg/overlappingpreconditioner.hh
+             opm/simulators/linalg/reorderedpreconditioner.hh
+             opm/simulators/linalg/sparsitypatterntracker.hh
+             opm/simulators/linalg/multicoloramgsmoother.hh
+             opm/simulators/linalg/multicolorpreconditioner.hh
+             opm/simulators/linalg/cprpreconditioner.hh
+             opm/simulators/linalg/amgcoarsencriterion.hh
+             opm/simulators/linalg/amgindexset.hh
              opm/simulators/linalg/domesticoverlapfrombcrsmatrix.hh
              opm/simulators/linalg/fixpointcriterion.hh
              opm/simulators/linalg/parallelamgbackend.hh
@@ -52,6 +52,7 @@
 
 #include <dune/common/fmatrix.hh>
 
+#include <array>
 #include <cstring>
 #include <utility>
 
@@ -348,12 +349,14 @@ public:
         paramCache.updateAll(fluidState_);
 
         // compute the phase densities and transform the phase permeabilities into mobilities
+        // (this is done for every cell, so the list of mobilities must not be allocated
+        // on the heap.)
         int nmobilities = 1;
-        std::vector<std::array<Evaluation,numPhases>*> mobilities = {&mobility_};
+        std::array<std::array<Evaluation,numPhases>*, 4> mobilities = {&mobility_};
         if (dirMob_) {
             for (int i=0; i<3; i++) {
+                mobilities[nmobilities] = &(dirMob_->getArray(i));
                 nmobilities += 1;
-                mobilities.push_back(&(dirMob_->getArray(i)));
             }
         }
         for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
@@ -40,8 +40,12 @@
 
 #include <dune/common/fvector.hh>
 #include <dune/common/fmatrix.hh>
+#include <dune/grid/common/rangegenerators.hh>
 
 #include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <vector>
 
 namespace Opm {
 template <class TypeTag>
@@ -75,12 +79,40 @@ struct ForchheimerFluxModule
  * \ingroup FluxModules
  * \brief Provides the defaults for the parameters required by the
  *        Forchheimer velocity approach.
+ *
+ * Besides this, the class stores the Forchheimer velocities of the interior faces of
+ * all elements which were obtained by their most recent evaluation for the unperturbed
+ * solution. These are used as the initial guess for the iterative solution of the
+ * Forchheimer equation. It also records how many iterations were required for this.
+ * The storage for this is set up by updateFluxModuleCaches() whenever the grid changes,
+ * so no memory gets allocated during the linearization.
  */
 template <class TypeTag>
 class ForchheimerBaseProblem
 {
     using Scalar = GetPropType<TypeTag, Properties::Scalar>;
     using Evaluation = GetPropType<TypeTag, Properties::Evaluation>;
+    using GridView = GetPropType<TypeTag, Properties::GridView>;
+    using ElementContext = GetPropType<TypeTag, Properties::ElementContext>;
+    using ThreadManager = GetPropType<TypeTag, Properties::ThreadManager>;
+
+    enum { dimWorld = GridView::dimensionworld };
+    enum { numPhases = getPropValue<TypeTag, Properties::NumPhases>() };
+
+    using DimVector = Dune::FieldVector<Scalar, dimWorld>;
+
+    struct CachedVelocity_
+    {
+        DimVector velocity;
+        bool valid = false;
+    };
+
+    // avoid false sharing of the counters of different threads
+    struct alignas(64) ThreadStatistics_
+    {
+        std::size_t numSolves = 0;
+        std::size_t numIterations = 0;
+    };
 
 public:
     /*!
@@ -119,6 +151,147 @@ public:
     {
         return 1.0 / context.intensiveQuantities(spaceIdx, timeIdx).fluidState().viscosity(phaseIdx);
     }
+
+    /*!
+     * \brief Set up the storage for the Forchheimer velocities of all elements.
+     *
+     * This is called by the problem after the grid has changed. All cached velocities
+     * are discarded.
+     */
+    template <class Simulator>
+    void updateFluxModuleCaches(const Simulator& simulator)
+    {
+        const auto& gridView = simulator.gridView();
+        const auto& elementMapper = simulator.model().elementMapper();
+
+        velocityOffsets_.assign(static_cast<std::size_t>(gridView.size(/*codim=*/0)) + 1, 0);
+        ElementContext elemCtx(simulator);
+        for (const auto& elem : elements(gridView)) {
+            elemCtx.updateStencil(elem);
+            velocityOffsets_[elementMapper.index(elem) + 1] =
+                elemCtx.numInteriorFaces(/*timeIdx=*/0)*numPhases;
+        }
+        std::partial_sum(velocityOffsets_.begin(), velocityOffsets_.end(), velocityOffsets_.begin());
+
+        velocityCache_.assign(velocityOffsets_.back(), CachedVelocity_());
+        threadStatistics_.assign(ThreadManager::maxThreads(), ThreadStatistics_());
+    }
+
+    /*!
+     * \brief Retrieve the Forchheimer velocity of a fluid phase at an interior face of
+     *        an element which was stored by the most recent call to
+     *        updateCachedForchheimerVelocity().
+     *
+     * \return false if no velocity is known for the face
+     */
+    template <class Context>
+    bool cachedForchheimerVelocity(DimVector& velocity,
+                                   const Context& context,
+                                   unsigned scvfIdx,
+                                   unsigned phaseIdx) const
+    {
+        const CachedVelocity_* entry = cacheEntry_(context, scvfIdx, phaseIdx);
+        if (!entry || !entry->valid)
+            return false;
+
+        velocity = entry->velocity;
+        return true;
+    }
+
+    /*!
+     * \brief Store the Forchheimer velocity of a fluid phase at an interior face of an
+     *        element.
+     *
+     * Since the elements are assigned to exactly one thread, no locking is required for
+     * this.
+     */
+    template <class Context>
+    void updateCachedForchheimerVelocity(const Context& context,
+                                         unsigned scvfIdx,
+                                         unsigned phaseIdx,
+                                         const DimVector& velocity) const
+    {
+        CachedVelocity_* entry = cacheEntry_(context, scvfIdx, phaseIdx);
+        if (!entry)
+            return;
+
+        entry->velocity = velocity;
+        entry->valid = true;
+    }
+
+    /*!
+     * \brief Record that the Forchheimer equation was solved using a given number of
+     *        iterations.
+     */
+    template <class Context>
+    void recordForchheimerSolve(const Context&, unsigned numIterations) const
+    {
+        const unsigned threadId = ThreadManager::threadId();
+        if (threadId >= threadStatistics_.size())
+            return;
+
+        auto& stats = threadStatistics_[threadId];
+        ++stats.numSolves;
+        stats.numIterations += numIterations;
+    }
+
+    /*!
+     * \brief Returns the number of times the Forchheimer equation was solved since the
+     *        last call to resetForchheimerStatistics().
+     */
+    std::size_t numForchheimerSolves() const
+    {
+        std::size_t result = 0;
+        for (const auto& stats : threadStatistics_)
+            result += stats.numSolves;
+        return result;
+    }
+
+    /*!
+     * \brief Returns the total number of iterations used to solve the Forchheimer
+     *        equation since the last call to resetForchheimerStatistics().
+     */
+    std::size_t numForchheimerIterations() const
+    {
+        std::size_t result = 0;
+        for (const auto& stats : threadStatistics_)
+            result += stats.numIterations;
+        return result;
+    }
+
+    /*!
+     * \brief Reset the counters of the Forchheimer solves.
+     */
+    void resetForchheimerStatistics()
+    {
+        for (auto& stats : threadStatistics_)
+            stats = ThreadStatistics_();
+    }
+
+private:
+    // returns the cached velocity of a phase at an interior face of the context's
+    // element or nullptr if the storage does not match the element
+    template <class Context>
+    CachedVelocity_* cacheEntry_(const Context& context,
+                                 unsigned scvfIdx,
+                                 unsigned phaseIdx) const
+    {
+        const std::size_t elemIdx = context.model().elementMapper().index(context.element());
+        if (elemIdx + 1 >= velocityOffsets_.size())
+            return nullptr;
+
+        const std::size_t idx = velocityOffsets_[elemIdx] + scvfIdx*numPhases + phaseIdx;
+        if (idx >= velocityOffsets_[elemIdx + 1])
+            return nullptr;
+
+        return &velocityCache_[idx];
+    }
+
+    // the cached velocities of the element with index i are stored at the positions
+    // [velocityOffsets_[i], velocityOffsets_[i + 1]) of velocityCache_
+    std::vector<std::size_t> velocityOffsets_;
+    mutable std::vector<CachedVelocity_> velocityCache_;
+    mutable std::vector<ThreadStatistics_> threadStatistics_;
 };
 
 /*!
@@ -181,7 +354,8 @@ private:
  * relation is not linear (as in the Darcy case) any more.
  *
  * Therefore, the Newton scheme is used to solve the Forchheimer equation. This velocity
- * is then used like the Darcy velocity e.g. by the local residual.
+ * is then used like the Darcy velocity e.g. by the local residual. If the intrinsic
+ * permeability is isotropic, the equation is solved directly instead.
  *
  * Note that for Reynolds numbers above \f$\approx 500\f$ the standard Forchheimer
  * relation also looses it's validity.
@@ -393,7 +567,32 @@ protected:
                 continue;
             }
 
-            calculateForchheimerFlux_(phaseIdx);
+            if (isIsotropic_()) {
+                calculateIsotropicForchheimerFlux_(phaseIdx);
+                elemCtx.problem().recordForchheimerSolve(elemCtx, /*numIterations=*/0);
+            }
+            else {
+                // use the velocity of the most recent evaluation of the face for the
+                // unperturbed solution as the initial guess. this is either the one of
+                // the previous Newton iteration or, if a partial derivative is
+                // calculated using finite differences, the one of the current iteration
+                const auto& problem = elemCtx.problem();
+                DimVector initialVelocity;
+                bool haveInitialVelocity =
+                    timeIdx == 0
+                    && problem.cachedForchheimerVelocity(initialVelocity, elemCtx, scvfIdx, phaseIdx);
+
+                unsigned numIterations =
+                    calculateForchheimerFlux_(phaseIdx, haveInitialVelocity ? &initialVelocity : nullptr);
+                problem.recordForchheimerSolve(elemCtx, numIterations);
+
+                if (timeIdx == 0 && !elemCtx.haveStashedIntensiveQuantities()) {
+                    DimVector velocity;
+                    for (unsigned dimIdx = 0; dimIdx < dimWorld; ++dimIdx)
+                        velocity[dimIdx] = getValue(this->filterVelocity_[phaseIdx][dimIdx]);
+                    problem.updateCachedForchheimerVelocity(elemCtx, scvfIdx, phaseIdx, velocity);
+                }
+            }
 
             this->volumeFlux_[phaseIdx] = 0.0;
             for (unsigned dimIdx = 0; dimIdx < dimWorld; ++ dimIdx)
@@ -422,7 +621,14 @@ protected:
                 continue;
             }
 
-            calculateForchheimerFlux_(phaseIdx);
+            if (isIsotropic_()) {
+                calculateIsotropicForchheimerFlux_(phaseIdx);
+                elemCtx.problem().recordForchheimerSolve(elemCtx, /*numIterations=*/0);
+            }
+            else {
+                unsigned numIterations = calculateForchheimerFlux_(phaseIdx, /*initialVelocity=*/nullptr);
+                elemCtx.problem().recordForchheimerSolve(elemCtx, numIterations);
+            }
 
             this->volumeFlux_[phaseIdx] = 0.0;
             for (unsigned dimIdx = 0; dimIdx < dimWorld; ++dimIdx)
@@ -431,11 +637,65 @@ protected:
         }
     }
 
-    void calculateForchheimerFlux_(unsigned phaseIdx)
+    /*!
+     * \brief Calculate the filter velocity of a phase if the permeability is isotropic.
+     *
+     * In this case, the filter velocity is parallel to the Darcy velocity
+     * \f$\vec{b} = - \frac{k_{r_alpha}}{mu} K (\nabla p_\alpha - \rho_\alpha \vec{g})\f$
+     * and the Forchheimer equation reduces to a quadratic equation for its magnitude:
+     *
+     * \f[
+     \sqrt{K} \frac{\rho_\alpha C_E}{\eta_{r,\alpha}} \frac{k_{r_alpha}}{mu}
+     \left| \vec{v}_\alpha \right|^2 + \left| \vec{v}_\alpha \right| = \left| \vec{b} \right|
+     \f]
+     */
+    void calculateIsotropicForchheimerFlux_(unsigned phaseIdx)
     {
-        // initial guess: filter velocity is zero
         DimEvalVector& velocity = this->filterVelocity_[phaseIdx];
-        velocity = 0.0;
+        const auto& mobility = this->mobility_[phaseIdx];
+        const auto& pGrad = this->potentialGrad_[phaseIdx];
+
+        // start with the Darcy velocity
+        Evaluation absDarcyVel = 0.0;
+        for (unsigned dimIdx = 0; dimIdx < dimWorld; ++dimIdx) {
+            velocity[dimIdx] = - mobility*pGrad[dimIdx]*this->K_[dimIdx][dimIdx];
+            absDarcyVel += velocity[dimIdx]*velocity[dimIdx];
+        }
+
+        // the derivatives of the square root of 0 are undefined
+        if (absDarcyVel <= 0.0)
+            return;
+        absDarcyVel = Toolbox::sqrt(absDarcyVel);
+
+        // solve the quadratic equation in a way which is also stable if the Forchheimer
+        // term is small
+        const auto& beta =
+            sqrtK_[0]*density_[phaseIdx]*mobilityPassabilityRatio_[phaseIdx]*ergunCoefficient_;
+        const Evaluation& absVel = 2.0*absDarcyVel/(1.0 + Toolbox::sqrt(1.0 + 4.0*beta*absDarcyVel));
+        velocity /= 1.0 + beta*absVel;
+    }
+
+    /*!
+     * \brief Calculate the filter velocity of a phase using the Newton method.
+     *
+     * If no initial velocity is specified, the Darcy velocity is used as the initial
+     * guess.
+     *
+     * \return The number of Newton iterations
+     */
+    unsigned calculateForchheimerFlux_(unsigned phaseIdx, const DimVector* initialVelocity)
+    {
+        DimEvalVector& velocity = this->filterVelocity_[phaseIdx];
+        if (initialVelocity) {
+            for (unsigned dimIdx = 0; dimIdx < dimWorld; ++dimIdx)
+                velocity[dimIdx] = (*initialVelocity)[dimIdx];
+        }
+        else {
+            const auto& mobility = this->mobility_[phaseIdx];
+            const auto& pGrad = this->potentialGrad_[phaseIdx];
+            for (unsigned dimIdx = 0; dimIdx < dimWorld; ++dimIdx)
+                velocity[dimIdx] = - mobility*pGrad[dimIdx]*this->K_[dimIdx][dimIdx];
+        }
 
         // the change of velocity between two consecutive Newton iterations
         DimEvalVector deltaV(1e5);
@@ -460,6 +720,8 @@ protected:
             gradResid.solve(deltaV, residual);
             velocity -= deltaV;
         }
+
+        return newtonIter;
     }
 
     void forchheimerResid_(DimEvalVector& residual, unsigned phaseIdx) const
@@ -513,23 +775,46 @@ protected:
                                DimEvalMatrix& gradResid,
                                unsigned phaseIdx)
     {
-        // TODO (?) use AD for this.
-        DimEvalVector& velocity = this->filterVelocity_[phaseIdx];
+        const DimEvalVector& velocity = this->filterVelocity_[phaseIdx];
         forchheimerResid_(residual, phaseIdx);
 
-        Scalar eps = 1e-11;
-        DimEvalVector tmp;
+        // the derivative of the residual w.r.t. the velocity is
+        //
+        // dr_i/dv_j = \delta_ij (1 + alpha sqrt(K_i) |v|) + alpha sqrt(K_i) v_i v_j/|v|
+        //
+        // with alpha = \rho_\alpha * mobility_\alpha * C_E / \eta_{r,\alpha}
+        const auto& alpha = density_[phaseIdx]*mobilityPassabilityRatio_[phaseIdx]*ergunCoefficient_;
+        Evaluation absVel = 0.0;
+        for (unsigned dimIdx = 0; dimIdx < dimWorld; ++dimIdx)
+            absVel += velocity[dimIdx]*velocity[dimIdx];
+
+        gradResid = 0.0;
+        if (absVel <= 0.0) {
+            for (unsigned i = 0; i < dimWorld; ++i)
+                gradResid[i][i] = 1.0;
+            return;
+        }
+
+        absVel = Toolbox::sqrt(absVel);
         for (unsigned i = 0; i < dimWorld; ++i) {
-            Scalar coordEps = std::max(eps, Toolbox::scalarValue(velocity[i]) * (1 + eps));
-            velocity[i] += coordEps;
-            forchheimerResid_(tmp, phaseIdx);
-            tmp -= residual;
-            tmp /= coordEps;
-            gradResid[i] = tmp;
-            velocity[i] -= coordEps;
+            const auto& tmp = sqrtK_[i]*alpha;
+            gradResid[i][i] = 1.0 + tmp*absVel;
+            for (unsigned j = 0; j < dimWorld; ++j)
+                gradResid[i][j] += tmp*velocity[i]*velocity[j]/absVel;
         }
     }
 
+    /*!
+     * \brief Returns true if the intrinsic permeability at the face is isotropic.
+     */
+    bool isIsotropic_() const
+    {
+        for (unsigned dimIdx = 1; dimIdx < dimWorld; ++dimIdx)
+            if (this->K_[dimIdx][dimIdx] != this->K_[0][0])
+                return false;
+        return true;
+    }
+
     /*!
      * \brief Check whether all off-diagonal entries of a tensor are zero.
      *
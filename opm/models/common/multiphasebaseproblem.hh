@@ -43,6 +43,9 @@
 #include <dune/common/fvector.hh>
 #include <dune/common/fmatrix.hh>
 
+#include <type_traits>
+#include <utility>
+
 namespace Opm {
 /*!
  * \ingroup Discretization
@@ -57,6 +60,7 @@ class MultiPhaseBaseProblem
 {
 //! \cond SKIP_THIS
     using ParentType = FvBaseProblem<TypeTag>;
+    using FluxBaseProblem = typename GetPropType<TypeTag, Properties::FluxModule>::FluxBaseProblem;
 
     using Implementation = GetPropType<TypeTag, Properties::Problem>;
     using Scalar = GetPropType<TypeTag, Properties::Scalar>;
@@ -94,6 +98,24 @@ public:
                              "Use the gravity correction for the pressure gradients.");
     }
 
+    /*!
+     * \copydoc FvBaseProblem::finishInit
+     */
+    void finishInit()
+    {
+        ParentType::finishInit();
+        updateFluxModuleCaches_();
+    }
+
+    /*!
+     * \copydoc FvBaseProblem::gridChanged
+     */
+    void gridChanged()
+    {
+        ParentType::gridChanged();
+        updateFluxModuleCaches_();
+    }
+
     /*!
      * \brief Returns the intrinsic permeability of an intersection.
      *
@@ -398,6 +420,25 @@ private:
         if (EWOMS_GET_PARAM(TypeTag, bool, EnableGravity))
             gravity_[dimWorld-1]  = -9.81;
     }
+
+    // the base problems of some flux modules keep data for each element which must be
+    // set up whenever the grid changes
+    template <class FluxProblem, class Enable = void>
+    struct HasFluxModuleCaches_ : public std::false_type
+    {};
+
+    template <class FluxProblem>
+    struct HasFluxModuleCaches_<FluxProblem,
+                                std::void_t<decltype(std::declval<FluxProblem&>()
+                                                     .updateFluxModuleCaches(std::declval<const Simulator&>()))> >
+        : public std::true_type
+    {};
+
+    void updateFluxModuleCaches_()
+    {
+        if constexpr (HasFluxModuleCaches_<FluxBaseProblem>::value)
+            FluxBaseProblem::updateFluxModuleCaches(this->simulator());
+    }
 };
 
 } // namespace Opm
@@ -47,11 +47,13 @@
 #include "fvbaseextensivequantities.hh"
 #include "baseauxiliarymodule.hh"
 
+#include <opm/models/parallel/firsttouchallocator.hh>
 #include <opm/models/parallel/gridcommhandles.hh>
 #include <opm/models/parallel/threadmanager.hh>
 #include <opm/simulators/linalg/nullborderlistmanager.hh>
 #include <opm/models/utils/simulator.hh>
 #include <opm/models/utils/alignedallocator.hh>
+#include <opm/models/utils/profiler.hh>
 #include <opm/models/utils/timer.hh>
 #include <opm/models/utils/timerguard.hh>
 #include <opm/models/io/vtkprimaryvarsmodule.hh>
@@ -72,12 +74,15 @@
 #endif
 
 #include <algorithm>
+#include <cassert>
 #include <cstddef>
 #include <limits>
 #include <list>
 #include <stdexcept>
 #include <sstream>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace Opm {
@@ -136,6 +141,23 @@ struct MaxTimeStepDivisions<TypeTag, TTag::FvBaseDiscretization> { static conste
 template<class TypeTag>
 struct ContinueOnConvergenceError<TypeTag, TTag::FvBaseDiscretization> { static constexpr bool value = false; };
 
+//! By default, control the time step size using the number of Newton iterations
+template<class TypeTag>
+struct TimeStepControl<TypeTag, TTag::FvBaseDiscretization> { static constexpr auto value = "iterationcount"; };
+
+//! Aim at a relative change of the solution of 10% per time step if the PID controller
+//! is used
+template<class TypeTag>
+struct TimeStepControlTolerance<TypeTag, TTag::FvBaseDiscretization>
+{
+    using type = GetPropType<TypeTag, Scalar>;
+    static constexpr type value = 1e-1;
+};
+
+//! By default, recalculate the intensive quantities if a time step must be repeated
+template<class TypeTag>
+struct EnableStartOfStepStateReuse<TypeTag, TTag::FvBaseDiscretization> { static constexpr bool value = false; };
+
 /*!
  * \brief A vector of quanties, each for one equation.
  */
@@ -219,6 +241,8 @@ struct ThreadManager<TypeTag, TTag::FvBaseDiscretization> { using type = ::Opm::
 template<class TypeTag>
 struct ThreadsPerProcess<TypeTag, TTag::FvBaseDiscretization> { static constexpr int value = 1; };
 template<class TypeTag>
+struct ThreadPinning<TypeTag, TTag::FvBaseDiscretization> { static constexpr auto value = "none"; };
+template<class TypeTag>
 struct UseLinearizationLock<TypeTag, TTag::FvBaseDiscretization> { static constexpr bool value = true; };
 
 /*!
@@ -247,10 +271,30 @@ struct MinTimeStepSize<TypeTag, TTag::FvBaseDiscretization>
 template<class TypeTag>
 struct EnableGridAdaptation<TypeTag, TTag::FvBaseDiscretization> { static constexpr bool value = false; };
 
+//! Disable dynamic load balancing by default
+template<class TypeTag>
+struct EnableDynamicLoadBalancing<TypeTag, TTag::FvBaseDiscretization> { static constexpr bool value = false; };
+
+//! Re-partition the grid if the most expensive process is 10% slower than the average
+template<class TypeTag>
+struct LoadImbalanceTolerance<TypeTag, TTag::FvBaseDiscretization>
+{
+    using type = GetPropType<TypeTag, Scalar>;
+    static constexpr type value = 1.1;
+};
+
+//! Sample each element in every eighth linearization
+template<class TypeTag>
+struct LinearizationCostSamplingInterval<TypeTag, TTag::FvBaseDiscretization> { static constexpr unsigned value = 8; };
+
 //! By default, write the simulation output to the current working directory
 template<class TypeTag>
 struct OutputDir<TypeTag, TTag::FvBaseDiscretization> { static constexpr auto value = "."; };
 
+//! By default, do not cache the results of the preprocessing steps
+template<class TypeTag>
+struct PreprocessingCacheDir<TypeTag, TTag::FvBaseDiscretization> { static constexpr auto value = ""; };
+
 //! Enable the VTK output by default
 template<class TypeTag>
 struct EnableVtkOutput<TypeTag, TTag::FvBaseDiscretization> { static constexpr bool value = true; };
@@ -337,6 +381,7 @@ class FvBaseDiscretization
     using Implementation = GetPropType<TypeTag, Properties::Model>;
     using Discretization = GetPropType<TypeTag, Properties::Discretization>;
     using Simulator = GetPropType<TypeTag, Properties::Simulator>;
+    using Vanguard = GetPropType<TypeTag, Properties::Vanguard>;
     using Grid = GetPropType<TypeTag, Properties::Grid>;
     using GridView = GetPropType<TypeTag, Properties::GridView>;
     using Scalar = GetPropType<TypeTag, Properties::Scalar>;
@@ -370,10 +415,13 @@ class FvBaseDiscretization
         historySize = getPropValue<TypeTag, Properties::TimeDiscHistorySize>(),
     };
 
-    using IntensiveQuantitiesVector = std::vector<IntensiveQuantities, aligned_allocator<IntensiveQuantities, alignof(IntensiveQuantities)> >;
+    // the pages of the intensive quantity cache are distributed amongst the NUMA nodes
+    // of the threads which update the intensive quantities
+    using IntensiveQuantitiesVector = std::vector<IntensiveQuantities, FirstTouchAllocator<IntensiveQuantities, alignof(IntensiveQuantities)> >;
 
     using Element = typename GridView::template Codim<0>::Entity;
     using ElementIterator = typename GridView::template Codim<0>::Iterator;
+    using ElementSeed = typename GridView::Grid::template Codim<0>::EntitySeed;
 
     using Toolbox = MathToolbox<Evaluation>;
     using VectorBlock = Dune::FieldVector<Evaluation, numEq>;
@@ -484,6 +532,18 @@ public:
 
         enableStorageCache_ = EWOMS_GET_PARAM(TypeTag, bool, EnableStorageCache);
 
+        enableDynamicLoadBalancing_ = EWOMS_GET_PARAM(TypeTag, bool, EnableDynamicLoadBalancing);
+        loadImbalanceTolerance_ = EWOMS_GET_PARAM(TypeTag, Scalar, LoadImbalanceTolerance);
+#if HAVE_DUNE_FEM
+        if (enableDynamicLoadBalancing_)
+            throw std::invalid_argument("Dynamic load balancing currently requires the absence "
+                                        "of the dune-fem module");
+#endif
+        if (enableDynamicLoadBalancing_ && !Vanguard::supportsWeightedLoadBalancing())
+            throw std::invalid_argument("Dynamic load balancing requires a grid whose load "
+                                        "balancer accepts weights for the elements (is: "
+                                        +Dune::className<Grid>()+")");
+
         size_t numDof = asImp_().numGridDof();
         for (unsigned timeIdx = 0; timeIdx < historySize; ++timeIdx) {
             solution_[timeIdx].reset(new DiscreteFunction("solution", space_));
@@ -530,6 +590,12 @@ public:
         VtkPrimaryVarsModule<TypeTag>::registerParameters();
 
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableGridAdaptation, "Enable adaptive grid refinement/coarsening");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableDynamicLoadBalancing,
+                             "Re-partition the grid at the end of episodes based on the "
+                             "measured cost of linearizing the elements");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, LoadImbalanceTolerance,
+                             "The ratio between the maximum and the average cost of the "
+                             "processes above which the grid is re-partitioned");
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableVtkOutput, "Global switch for turning on writing VTK files");
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableThermodynamicHints, "Enable thermodynamic hints");
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableIntensiveQuantityCache, "Turn on caching of intensive quantities");
@@ -550,8 +616,16 @@ public:
         ElementContext elemCtx(simulator_);
         gridTotalVolume_ = 0.0;
 
+        // remember the elements so that their intensive quantities can be updated
+        // without iterating over the grid
+        elementSeeds_.resize(gridView_.size(/*codim=*/0));
+
+        elementSeedsSequenceNumber_ = simulator_.vanguard().gridSequenceNumber();
+
         // iterate through the grid and evaluate the initial condition
         for (const auto& elem : elements(gridView_)) {
+            elementSeeds_[elementMapper_.index(elem)] = elem.seed();
+
             const bool isInteriorElement = elem.partitionType() == Dune::InteriorEntity;
             // ignore everything which is not in the interior if the
             // current process' piece of the grid
@@ -794,6 +868,29 @@ public:
     {
         invalidateIntensiveQuantitiesCache(timeIdx);
 
+        if (elementSeedsValid_()) {
+            // the elements are known by their index, so the grid does not need to be
+            // traversed. this also distributes the elements amongst the threads in the
+            // same way as the cell loop of the TPFA linearizer.
+            const long numElements = static_cast<long>(elementSeeds_.size());
+            const auto& grid = gridView_.grid();
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+            {
+                ElementContext elemCtx(simulator_);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+                for (long elemIdx = 0; elemIdx < numElements; ++elemIdx) {
+                    const Element& elem = grid.entity(elementSeeds_[elemIdx]);
+                    elemCtx.updatePrimaryStencil(elem);
+                    elemCtx.updatePrimaryIntensiveQuantities(timeIdx);
+                }
+            }
+            return;
+        }
+
         // loop over all elements...
         ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(gridView_);
 #ifdef _OPENMP
@@ -840,6 +937,77 @@ public:
         }
     }
 
+    /*!
+     * \brief Invalidate and recalculate the intensive quantities of the degrees of
+     *        freedom of a single element.
+     *
+     * The element is addressed by its index, i.e., no grid traversal is required.
+     *
+     * \param elemCtx The element context which is used for the update
+     * \param elemIdx The index of the element given by the element mapper
+     * \param timeIdx The index used by the time discretization.
+     */
+    void invalidateAndUpdateIntensiveQuantities(ElementContext& elemCtx,
+                                                unsigned elemIdx,
+                                                unsigned timeIdx) const
+    {
+        assert(elementSeedsValid_());
+        const Element& elem = gridView_.grid().entity(elementSeeds_[elemIdx]);
+        elemCtx.updatePrimaryStencil(elem);
+
+        const std::size_t numPrimaryDof = elemCtx.numPrimaryDof(timeIdx);
+        for (unsigned dofIdx = 0; dofIdx < numPrimaryDof; ++dofIdx) {
+            const unsigned globalIndex = elemCtx.globalSpaceIndex(dofIdx, timeIdx);
+            setIntensiveQuantitiesCacheEntryValidity(globalIndex, timeIdx, false);
+        }
+        elemCtx.updatePrimaryIntensiveQuantities(timeIdx);
+
+        // the updates are also part of the "intensive quantity updates" counter of the
+        // element context. this one tells how many of them did not traverse the grid.
+        EWOMS_PROFILE_COUNT("intensive quantity updates by index", numPrimaryDof);
+    }
+
+    /*!
+     * \brief Invalidate and recalculate the intensive quantities of a set of elements.
+     *
+     * In contrast to the variants of this method which take a grid view, this does not
+     * iterate over the grid, i.e., its costs only depend on the number of elements which
+     * are updated. This makes it suitable for the subdomains of the TPFA linearizer and
+     * of the local solves of the Newton method. The elements are distributed statically
+     * amongst the threads. If the method is called from within a parallel region, the
+     * calling thread does all the work.
+     *
+     * \param timeIdx The index used by the time discretization.
+     * \param elemIndices The indices of the elements given by the element mapper. For the
+     *                    element centered finite volume discretization, these are the
+     *                    indices of the degrees of freedom.
+     *
+     * \throw std::logic_error if the grid was changed without the model being notified
+     */
+    template <class ElementIndexContainer>
+    void invalidateAndUpdateIntensiveQuantitiesOfCells(unsigned timeIdx,
+                                                       const ElementIndexContainer& elemIndices) const
+    {
+        if (!elementSeedsValid_())
+            throw std::logic_error("The elements of the model do not correspond to the grid. "
+                                   "Was the grid changed without calling gridChanged()?");
+
+        const long numElements = static_cast<long>(elemIndices.size());
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            ElementContext elemCtx(simulator_);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+            for (long i = 0; i < numElements; ++i)
+                invalidateAndUpdateIntensiveQuantities(elemCtx,
+                                                       static_cast<unsigned>(elemIndices[i]),
+                                                       timeIdx);
+        }
+    }
+
     /*!
      * \brief Move the intensive quantities for a given time index to the back.
      *
@@ -947,45 +1115,54 @@ public:
      * \brief Compute the global residual for the current solution
      *        vector.
      *
+     * The result does not depend on the number of threads which are used.
+     *
      * \param dest Stores the result
      */
     Scalar globalResidual(GlobalEqVector& dest) const
     {
+        EWOMS_PROFILE_SCOPE("global residual");
+
         dest = 0;
 
-        std::mutex mutex;
-        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(gridView_);
-#ifdef _OPENMP
-#pragma omp parallel
-#endif
+        // with the element centered finite volume method, the primary degree of freedom
+        // of an element is not shared with any other element, so its residual can be
+        // written to the result directly. for the other discretizations, the
+        // contributions of each chunk of elements are collected and added to the result
+        // in the order of the chunks.
+        static constexpr bool isEcfv = std::is_same<Discretization, EcfvDiscretization<TypeTag> >::value;
+        std::vector<std::vector<std::pair<unsigned, EqVector> > > chunkResiduals;
+        if (!isEcfv)
+            chunkResiduals.resize(numElementChunks_());
+
+        std::vector<LocalEvalBlockVector> residuals(ThreadManager::maxThreads());
+        forEachInteriorElement_([&](ElementContext& elemCtx,
+                                    const Element& elem,
+                                    unsigned threadId,
+                                    std::size_t chunkIdx)
         {
-            // Attention: the variables below are thread specific and thus cannot be
-            // moved in front of the #pragma!
-            unsigned threadId = ThreadManager::threadId();
-            ElementContext elemCtx(simulator_);
-            ElementIterator elemIt = threadedElemIt.beginParallel();
-            LocalEvalBlockVector residual, storageTerm;
-
-            for (; !threadedElemIt.isFinished(elemIt); elemIt = threadedElemIt.increment()) {
-                const Element& elem = *elemIt;
-                if (elem.partitionType() != Dune::InteriorEntity)
-                    continue;
-
-                elemCtx.updateAll(elem);
-                residual.resize(elemCtx.numDof(/*timeIdx=*/0));
-                storageTerm.resize(elemCtx.numPrimaryDof(/*timeIdx=*/0));
-                asImp_().localResidual(threadId).eval(residual, elemCtx);
+            auto& residual = residuals[threadId];
+            elemCtx.updateAll(elem);
+            residual.resize(elemCtx.numDof(/*timeIdx=*/0));
+            asImp_().localResidual(threadId).eval(residual, elemCtx);
+
+            std::size_t numPrimaryDof = elemCtx.numPrimaryDof(/*timeIdx=*/0);
+            for (unsigned dofIdx = 0; dofIdx < numPrimaryDof; ++dofIdx) {
+                unsigned globalI = elemCtx.globalSpaceIndex(dofIdx, /*timeIdx=*/0);
+                EqVector value;
+                for (unsigned eqIdx = 0; eqIdx < numEq; ++ eqIdx)
+                    value[eqIdx] = Toolbox::value(residual[dofIdx][eqIdx]);
 
-                size_t numPrimaryDof = elemCtx.numPrimaryDof(/*timeIdx=*/0);
-                mutex.lock();
-                for (unsigned dofIdx = 0; dofIdx < numPrimaryDof; ++dofIdx) {
-                    unsigned globalI = elemCtx.globalSpaceIndex(dofIdx, /*timeIdx=*/0);
-                    for (unsigned eqIdx = 0; eqIdx < numEq; ++ eqIdx)
-                        dest[globalI][eqIdx] += Toolbox::value(residual[dofIdx][eqIdx]);
-                }
-                mutex.unlock();
+                if constexpr (isEcfv)
+                    dest[globalI] += value;
+                else
+                    chunkResiduals[chunkIdx].emplace_back(globalI, value);
             }
-        }
+        });
+
+        for (const auto& contributions : chunkResiduals)
+            for (const auto& [globalI, value] : contributions)
+                dest[globalI] += value;
 
         // add up the residuals on the process borders
         const auto sumHandle =
@@ -1008,51 +1185,39 @@ public:
      * \brief Compute the integral over the domain of the storage
      *        terms of all conservation quantities.
      *
+     * The result does not depend on the number of threads which are used.
+     *
      * \copydetails Doxygen::storageParam
      */
     void globalStorage(EqVector& storage, unsigned timeIdx = 0) const
     {
-        storage = 0;
-
-        std::mutex mutex;
-        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(gridView());
-#ifdef _OPENMP
-#pragma omp parallel
-#endif
-        {
-            // Attention: the variables below are thread specific and thus cannot be
-            // moved in front of the #pragma!
-            unsigned threadId = ThreadManager::threadId();
-            ElementContext elemCtx(simulator_);
-            ElementIterator elemIt = threadedElemIt.beginParallel();
-            LocalEvalBlockVector elemStorage;
-
-            // in this method, we need to disable the storage cache because we want to
-            // evaluate the storage term for other time indices than the most recent one
-            elemCtx.setEnableStorageCache(false);
-
-            for (; !threadedElemIt.isFinished(elemIt); elemIt = threadedElemIt.increment()) {
-                const Element& elem = *elemIt;
-                if (elem.partitionType() != Dune::InteriorEntity)
-                    continue; // ignore ghost and overlap elements
-
-                elemCtx.updateStencil(elem);
-                elemCtx.updatePrimaryIntensiveQuantities(timeIdx);
-
-                size_t numPrimaryDof = elemCtx.numPrimaryDof(timeIdx);
-                elemStorage.resize(numPrimaryDof);
-
-                localResidual(threadId).evalStorage(elemStorage, elemCtx, timeIdx);
-
-                mutex.lock();
-                for (unsigned dofIdx = 0; dofIdx < numPrimaryDof; ++dofIdx)
-                    for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
-                        storage[eqIdx] += Toolbox::value(elemStorage[dofIdx][eqIdx]);
-                mutex.unlock();
-            }
-        }
+        std::vector<EqVector> regionStorage(1);
+        globalRegionStorage_(regionStorage,
+                             [](unsigned) { return 0; },
+                             timeIdx);
+        storage = regionStorage[0];
+    }
 
-        storage = gridView_.comm().sum(storage);
+    /*!
+     * \brief Compute the integrals of the storage terms of all conservation quantities
+     *        over a number of regions of the domain.
+     *
+     * All regions are dealt with by a single pass over the grid. Degrees of freedom
+     * which are assigned to a negative region index or to one which is not smaller than
+     * the size of the result vector are ignored.
+     *
+     * \param regionStorage Stores the result. Its size determines the number of regions.
+     * \param dofRegionIdx The region index of each degree of freedom of the process' grid.
+     * \param timeIdx The index used by the time discretization.
+     */
+    void globalStorage(std::vector<EqVector>& regionStorage,
+                       const std::vector<int>& dofRegionIdx,
+                       unsigned timeIdx = 0) const
+    {
+        assert(dofRegionIdx.size() == asImp_().numGridDof());
+        globalRegionStorage_(regionStorage,
+                             [&dofRegionIdx](unsigned globalIdx) { return dofRegionIdx[globalIdx]; },
+                             timeIdx);
     }
 
     /*!
@@ -1429,41 +1594,157 @@ public:
             if( simulator_.problem().markForGridAdaptation() )
             {
                 // adapt the grid and load balance if necessary
+                const int oldSequenceNumber = simulator_.vanguard().gridSequenceNumber();
                 adaptationManager().adapt();
 
-                // if the grid has potentially changed, we need to re-create the
-                // supporting data structures.
-#if DUNE_VERSION_NEWER(DUNE_GRID, 2, 8)
-                elementMapper_.update(gridView_);
-                vertexMapper_.update(gridView_);
-#else
-                elementMapper_.update();
-                vertexMapper_.update();
+                // if no element was actually refined or coarsened, the supporting data
+                // structures are still valid
+                if (simulator_.vanguard().gridSequenceNumber() == oldSequenceNumber)
+                    return;
+
+                // if the grid has changed, we need to re-create the supporting data
+                // structures.
+                updateMappers_();
+                gridChanged_();
+            }
+        }
 #endif
-                resetLinearizer();
-
-                // this is a bit hacky because it supposes that Problem::finishInit()
-                // works fine multiple times in a row.
-                //
-                // TODO: move this to Problem::gridChanged()
-                finishInit();
-
-                // notify the problem that the grid has changed
-                //
-                // TODO: come up with a mechanism to access the unadapted data structures
-                // outside of the problem (i.e., grid, mappers, solutions)
-                simulator_.problem().gridChanged();
-
-                // notify the modules for visualization output
-                auto outIt = outputModules_.begin();
-                auto outEndIt = outputModules_.end();
-                for (; outIt != outEndIt; ++outIt)
-                    (*outIt)->allocBuffers();
+    }
+
+    /*!
+     * \brief Re-partition the grid at the end of an episode if the measured cost of the
+     *        processes is too unbalanced.
+     *
+     * The cost of the elements is sampled by the linearizer and passed to the load
+     * balancer of the grid as the weights of the elements. The solution is moved to
+     * the new owners of the degrees of freedom, all other data structures are re-created
+     * in the same way as after an adaptation of the grid. Problems which store data for
+     * individual elements need to re-create it in their gridChanged() method.
+     */
+    void balanceLoad()
+    {
+#if !HAVE_DUNE_FEM
+        if (!enableDynamicLoadBalancing_ || !simulator_.episodeWillBeOver())
+            return;
+
+        const auto& comm = gridView_.comm();
+        if (comm.size() < 2)
+            return;
+
+        // elements which have not been sampled yet are assumed to be as expensive as
+        // the average sampled one
+        const auto& elementCosts = asImp_().linearizer().elementCosts();
+        Scalar sampledCost = 0.0;
+        Scalar numSampled = 0.0;
+        for (const auto& cost : elementCosts) {
+            if (cost > 0.0) {
+                sampledCost += cost;
+                numSampled += 1.0;
             }
         }
+        sampledCost = comm.sum(sampledCost);
+        numSampled = comm.sum(numSampled);
+        const Scalar defaultCost = (numSampled > 0.0) ? sampledCost/numSampled : 1.0;
+
+        // the weights are relative to the average cost of an element
+        std::vector<double> weights(static_cast<size_t>(gridView_.size(/*codim=*/0)), 0.0);
+        Scalar localCost = 0.0;
+        for (const auto& elem : elements(gridView_, Dune::Partitions::interior)) {
+            const unsigned elemIdx = static_cast<unsigned>(elementMapper_.index(elem));
+            Scalar cost = defaultCost;
+            if (elemIdx < elementCosts.size() && elementCosts[elemIdx] > 0.0)
+                cost = elementCosts[elemIdx];
+
+            weights[elemIdx] = cost/defaultCost;
+            localCost += cost;
+        }
+
+        const Scalar maxCost = comm.max(localCost);
+        const Scalar meanCost = comm.sum(localCost)/comm.size();
+        const Scalar imbalance = (meanCost > 0.0) ? maxCost/meanCost : 1.0;
+        if (verbose_())
+            std::cout << "Load imbalance of the linearization: " << imbalance << "\n" << std::flush;
+
+        if (imbalance <= loadImbalanceTolerance_)
+            return;
+
+        // remember the solution by the global identifiers of the degrees of freedom,
+        // because the indices are different after the re-partitioning
+        static constexpr int dofCodim = GridCommHandleFactory::dofCodim;
+        using IdSet = typename Grid::GlobalIdSet;
+        using MigrateHandle = GridCommHandleMigrate<PrimaryVariables, IdSet, dofCodim>;
+
+        const IdSet& idSet = gridView_.grid().globalIdSet();
+        typename MigrateHandle::Container dofValues;
+        for (const auto& entity : entities(gridView_, Dune::Codim<dofCodim>())) {
+            const unsigned dofIdx = static_cast<unsigned>(asImp_().dofMapper().index(entity));
+            auto& values = dofValues[idSet.id(entity)];
+            values.resize(historySize);
+            for (unsigned timeIdx = 0; timeIdx < historySize; ++timeIdx)
+                values[timeIdx] = solution(timeIdx)[dofIdx];
+        }
+
+        auto migrateHandle =
+            GridCommHandleFactory::template migrateHandle<PrimaryVariables>(dofValues,
+                                                                             idSet,
+                                                                             historySize);
+        const bool changed = simulator_.vanguard().repartition(elementMapper_, weights, *migrateHandle);
+        if (!comm.max(static_cast<int>(changed)))
+            return;
+
+        updateMappers_();
+
+        // re-create the solution from the migrated values. the DOFs in the overlap and
+        // ghost partitions might not have received any, so they are taken from their
+        // owners afterwards.
+        space_ = asImp_().numGridDof();
+        for (unsigned timeIdx = 0; timeIdx < historySize; ++timeIdx) {
+            solution_[timeIdx].reset(new DiscreteFunction("solution", space_));
+            solution(timeIdx) = 0.0;
+        }
+
+        for (const auto& entity : entities(gridView_, Dune::Codim<dofCodim>())) {
+            const auto valuesIt = dofValues.find(idSet.id(entity));
+            if (valuesIt == dofValues.end())
+                continue;
+
+            const unsigned dofIdx = static_cast<unsigned>(asImp_().dofMapper().index(entity));
+            for (unsigned timeIdx = 0; timeIdx < historySize; ++timeIdx)
+                solution(timeIdx)[dofIdx] = valuesIt->second[timeIdx];
+        }
+
+        using GhostSyncHandle = GridCommHandleGhostSync<PrimaryVariables, SolutionVector, DofMapper, dofCodim>;
+        for (unsigned timeIdx = 0; timeIdx < historySize; ++timeIdx) {
+            GhostSyncHandle ghostSync(solution(timeIdx), asImp_().dofMapper());
+            gridView_.communicate(ghostSync,
+                                  Dune::InteriorBorder_All_Interface,
+                                  Dune::ForwardCommunication);
+        }
+
+        gridChanged_();
 #endif
     }
 
+    /*!
+     * \brief Specify that the intensive quantities of the solution at the beginning of
+     *        the time step are to be reused if the time step fails.
+     *
+     * The cached intensive quantities of the previous time index are those of the
+     * solution at the beginning of the time step, so no copy of them is required. If the
+     * time integration fails afterwards, updateFailed() copies them to the cache of the
+     * current time index instead of recalculating the intensive quantities for the
+     * whole grid. This is not possible if the intensive quantity cache is disabled or
+     * if it is not shifted at the end of a time step because the storage term is
+     * recycled.
+     */
+    void saveStartOfStepState()
+    {
+        startOfStepStateValid_ =
+            historySize > 1
+            && storeIntensiveQuantities()
+            && !(enableStorageCache() && simulator_.problem().recycleFirstIterationStorage());
+    }
+
     /*!
      * \brief Called by the update() method if it was
      *        unsuccessful. This is primary a hook which the actual
@@ -1475,7 +1756,8 @@ public:
         // previous time step so that we can start the next
         // update at a physically meaningful solution.
         solution(/*timeIdx=*/0) = solution(/*timeIdx=*/1);
-        invalidateAndUpdateIntensiveQuantities(/*timeIdx=*/0);
+        if (!restoreStartOfStepState_())
+            invalidateAndUpdateIntensiveQuantities(/*timeIdx=*/0);
 
 #ifndef NDEBUG
         for (unsigned timeIdx = 0; timeIdx < historySize; ++timeIdx) {
@@ -1497,8 +1779,17 @@ public:
      */
     void advanceTimeLevel()
     {
-        // at this point we can adapt the grid
-        asImp_().adaptGrid();
+        adaptTimer_.halt();
+        adaptTimer_.start();
+        {
+            TimerGuard adaptGuard(adaptTimer_);
+
+            // at this point we can adapt the grid
+            asImp_().adaptGrid();
+
+            // and re-partition it if the processes are too unbalanced
+            asImp_().balanceLoad();
+        }
 
         // make the current solution the previous one.
         solution(/*timeIdx=*/1) = solution(/*timeIdx=*/0);
@@ -1935,6 +2226,13 @@ public:
     const Timer& updateTimer() const
     { return updateTimer_; }
 
+    /*!
+     * \brief Returns the timer for adapting and re-partitioning the grid at the end of
+     *        the last time step, including the rebuild of the model's data structures.
+     */
+    const Timer& adaptTimer() const
+    { return adaptTimer_; }
+
     template<class Serializer>
     void serializeOp(Serializer& serializer)
     {
@@ -1977,7 +2275,40 @@ protected:
                 invalidateIntensiveQuantitiesCache(timeIdx);
             }
         }
+
+        // the cache of the previous time index does not correspond to the beginning of
+        // the time step anymore
+        startOfStepStateValid_ = false;
+    }
+
+    // returns true if the stored element seeds correspond to the current grid. entity
+    // seeds become invalid when the grid is modified, which is indicated by a change of
+    // its sequence number.
+    bool elementSeedsValid_() const
+    {
+        return elementSeeds_.size() == static_cast<std::size_t>(gridView_.size(/*codim=*/0))
+            && elementSeedsSequenceNumber_ == simulator_.vanguard().gridSequenceNumber();
+    }
+
+    // copy the cached intensive quantities of the previous time index, i.e., the ones
+    // of the beginning of the time step, to the current time index. returns false if
+    // saveStartOfStepState() was not called for the current time step.
+    bool restoreStartOfStepState_()
+    {
+        if constexpr (historySize > 1) {
+            if (!startOfStepStateValid_)
+                return false;
+
+            // entries which were not up to date stay invalid and thus get recalculated
+            // when they are accessed the next time
+            intensiveQuantityCache_[/*timeIdx=*/0] = intensiveQuantityCache_[/*timeIdx=*/1];
+            intensiveQuantityCacheUpToDate_[/*timeIdx=*/0] = intensiveQuantityCacheUpToDate_[/*timeIdx=*/1];
+            return true;
+        }
+        else
+            return false;
     }
+
     template <class Context>
     void supplementInitialSolution_(PrimaryVariables&,
                                     const Context&,
@@ -1999,12 +2330,177 @@ protected:
         this->outputModules_.push_back(mod);
     }
 
+    template <class RegionIndexFn>
+    void globalRegionStorage_(std::vector<EqVector>& regionStorage,
+                              const RegionIndexFn& regionIdx,
+                              unsigned timeIdx) const
+    {
+        EWOMS_PROFILE_SCOPE("global storage");
+
+        static constexpr bool isEcfv = std::is_same<Discretization, EcfvDiscretization<TypeTag> >::value;
+        const std::size_t numRegions = regionStorage.size();
+        const std::size_t numChunks = numElementChunks_();
+
+        // the partial sums of the regions for each chunk of elements
+        std::vector<EqVector> chunkStorage(numChunks*numRegions, EqVector(0.0));
+        std::vector<LocalEvalBlockVector> elemStorages(ThreadManager::maxThreads());
+        forEachInteriorElement_([&](ElementContext& elemCtx,
+                                    const Element& elem,
+                                    unsigned threadId,
+                                    std::size_t chunkIdx)
+        {
+            // in this method, we need to disable the storage cache because we want to
+            // evaluate the storage term for other time indices than the most recent one
+            elemCtx.setEnableStorageCache(false);
+
+            // the storage term only needs the primary degrees of freedom. for the
+            // element centered finite volume method, this avoids computing the geometry
+            // of the neighboring elements.
+            if constexpr (isEcfv)
+                elemCtx.updatePrimaryStencil(elem);
+            else
+                elemCtx.updateStencil(elem);
+            elemCtx.updatePrimaryIntensiveQuantities(timeIdx);
+
+            std::size_t numPrimaryDof = elemCtx.numPrimaryDof(timeIdx);
+            auto& elemStorage = elemStorages[threadId];
+            elemStorage.resize(numPrimaryDof);
+            localResidual(threadId).evalStorage(elemStorage, elemCtx, timeIdx);
+
+            for (unsigned dofIdx = 0; dofIdx < numPrimaryDof; ++dofIdx) {
+                int regionI = regionIdx(elemCtx.globalSpaceIndex(dofIdx, timeIdx));
+                if (regionI < 0 || static_cast<std::size_t>(regionI) >= numRegions)
+                    continue;
+
+                EqVector& partialSum = chunkStorage[chunkIdx*numRegions + regionI];
+                for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
+                    partialSum[eqIdx] += Toolbox::value(elemStorage[dofIdx][eqIdx]);
+            }
+        });
+
+        // add up the partial sums in the order of the chunks and then over all processes
+        std::vector<Scalar> sums(numRegions*numEq, 0.0);
+        for (std::size_t chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx)
+            for (std::size_t regionI = 0; regionI < numRegions; ++regionI)
+                for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
+                    sums[regionI*numEq + eqIdx] += chunkStorage[chunkIdx*numRegions + regionI][eqIdx];
+
+        if (!sums.empty())
+            gridView_.comm().sum(sums.data(), static_cast<int>(sums.size()));
+
+        for (std::size_t regionI = 0; regionI < numRegions; ++regionI)
+            for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
+                regionStorage[regionI][eqIdx] = sums[regionI*numEq + eqIdx];
+    }
+
+    // the number of elements which are processed by a single thread in one go if the
+    // partial results of the threads need to be added up in a deterministic order. the
+    // chunks are small enough to keep all threads busy and large enough to keep the
+    // memory required for the partial results of the chunks bounded.
+    std::size_t elementChunkSize_() const
+    {
+        static constexpr std::size_t minChunkSize = 256;
+        static constexpr std::size_t maxNumChunks = 256;
+
+        const std::size_t numElements = gridView_.size(/*codim=*/0);
+        return std::max(minChunkSize, (numElements + maxNumChunks - 1)/maxNumChunks);
+    }
+
+    std::size_t numElementChunks_() const
+    {
+        const std::size_t numElements = gridView_.size(/*codim=*/0);
+        const std::size_t chunkSize = elementChunkSize_();
+        return (numElements + chunkSize - 1)/chunkSize;
+    }
+
+    // call a function for all interior elements of the local process. the elements are
+    // split into chunks of consecutive element indices. all elements of a chunk are
+    // visited by the same thread in the order of their indices, so results which are
+    // accumulated per chunk and added up in the order of the chunks are independent of
+    // the number of threads.
+    template <class Visitor>
+    void forEachInteriorElement_(Visitor&& visitor) const
+    {
+        const std::size_t chunkSize = elementChunkSize_();
+        if (!elementSeedsValid_()) {
+            // the elements cannot be accessed by their index, so the grid is traversed
+            // sequentially
+            ElementContext elemCtx(simulator_);
+            for (const auto& elem : elements(gridView_)) {
+                if (elem.partitionType() != Dune::InteriorEntity)
+                    continue; // ignore ghost and overlap elements
+
+                visitor(elemCtx, elem, /*threadId=*/0, elementMapper_.index(elem)/chunkSize);
+            }
+            return;
+        }
+
+        const std::size_t numElements = elementSeeds_.size();
+        const long numChunks = static_cast<long>(numElementChunks_());
+        const auto& grid = gridView_.grid();
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            // Attention: the variables below are thread specific and thus cannot be
+            // moved in front of the #pragma!
+            unsigned threadId = ThreadManager::threadId();
+            ElementContext elemCtx(simulator_);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+            for (long chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx) {
+                const std::size_t elemBegin = static_cast<std::size_t>(chunkIdx)*chunkSize;
+                const std::size_t elemEnd = std::min(elemBegin + chunkSize, numElements);
+                for (std::size_t elemIdx = elemBegin; elemIdx < elemEnd; ++elemIdx) {
+                    const Element& elem = grid.entity(elementSeeds_[elemIdx]);
+                    if (elem.partitionType() != Dune::InteriorEntity)
+                        continue; // ignore ghost and overlap elements
+
+                    visitor(elemCtx, elem, threadId, static_cast<std::size_t>(chunkIdx));
+                }
+            }
+        }
+    }
+
     /*!
      * \brief Reference to the local residal object
      */
     LocalResidual& localResidual_()
     { return localLinearizer_.localResidual(); }
 
+    void updateMappers_()
+    {
+#if DUNE_VERSION_NEWER(DUNE_GRID, 2, 8)
+        elementMapper_.update(gridView_);
+        vertexMapper_.update(gridView_);
+#else
+        elementMapper_.update();
+        vertexMapper_.update();
+#endif
+    }
+
+    // re-create the data structures which depend on the grid after it has been changed
+    void gridChanged_()
+    {
+        resetLinearizer();
+
+        // this is a bit hacky because it supposes that Problem::finishInit()
+        // works fine multiple times in a row.
+        //
+        // TODO: move this to Problem::gridChanged()
+        finishInit();
+
+        // notify the problem that the grid has changed
+        //
+        // TODO: come up with a mechanism to access the unadapted data structures
+        // outside of the problem (i.e., grid, mappers, solutions)
+        simulator_.problem().gridChanged();
+
+        // the buffers of the output modules do not need to be re-allocated here
+        // because prepareOutputFields() resizes them before anything is written
+    }
+
     /*!
      * \brief Returns whether messages should be printed
      */
@@ -2026,6 +2522,9 @@ protected:
     // the mappers for element and vertex entities to global indices
     ElementMapper elementMapper_;
     VertexMapper vertexMapper_;
+    std::vector<ElementSeed> elementSeeds_;
+    // the sequence number of the grid for which the element seeds were determined
+    int elementSeedsSequenceNumber_ = -1;
 
     // a vector with all auxiliary equations to be considered
     std::vector<BaseAuxiliaryModule<TypeTag>*> auxEqModules_;
@@ -2036,6 +2535,7 @@ protected:
     Timer linearizeTimer_;
     Timer solveTimer_;
     Timer updateTimer_;
+    Timer adaptTimer_;
 
     // calculates the local jacobian matrix for a given element
     std::vector<LocalLinearizer> localLinearizer_;
@@ -2066,7 +2566,13 @@ protected:
 
     mutable GlobalEqVector storageCache_[historySize];
 
+    // specifies whether the cached intensive quantities of the previous time index can
+    // be used to restore the ones of the beginning of the time step
+    bool startOfStepStateValid_ = false;
+
     bool enableGridAdaptation_;
+    bool enableDynamicLoadBalancing_ = false;
+    Scalar loadImbalanceTolerance_ = 1.1;
     bool enableIntensiveQuantityCache_;
     bool enableStorageCache_;
     bool enableThermodynamicHints_;
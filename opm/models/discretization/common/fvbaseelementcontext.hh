@@ -32,6 +32,7 @@
 
 #include <opm/models/discretization/common/linearizationtype.hh>
 #include <opm/models/utils/alignedallocator.hh>
+#include <opm/models/utils/profiler.hh>
 
 #include <dune/common/fvector.hh>
 
@@ -97,6 +98,7 @@ public:
         simulatorPtr_ = &simulator;
         enableStorageCache_ = EWOMS_GET_PARAM(TypeTag, bool, EnableStorageCache);
         stashedDofIdx_ = -1;
+        numStashedDofs_ = 0;
         focusDofIdx_ = -1;
     }
 
@@ -139,6 +141,7 @@ public:
         // resize the arrays containing the flux and the volume variables
         dofVars_.resize(stencil_.numDof());
         extensiveQuantities_.resize(stencil_.numInteriorFaces());
+        resizeStash_(stencil_.numDof());
     }
 
     /*!
@@ -156,6 +159,7 @@ public:
         stencil_.updatePrimaryTopology(elem);
 
         dofVars_.resize(stencil_.numPrimaryDof());
+        resizeStash_(stencil_.numPrimaryDof());
     }
 
     /*!
@@ -248,6 +252,33 @@ public:
         }
     }
 
+    /*!
+     * \brief Compute the extensive quantities of all sub-control volume faces of the
+     *        current element which are adjacent to a given degree of freedom.
+     *
+     * This only yields the same result as updateExtensiveQuantities() if the
+     * extensive quantities of a face exclusively depend on the intensive quantities of
+     * its interior and exterior degrees of freedom.
+     *
+     * \param dofIdx The local index of the degree of freedom
+     * \param timeIdx The index of the solution vector used by the
+     *                time discretization.
+     */
+    void updateAdjacentExtensiveQuantities(unsigned dofIdx, unsigned timeIdx)
+    {
+        gradientCalculator_.prepare(/*context=*/asImp_(), timeIdx);
+
+        for (unsigned fluxIdx = 0; fluxIdx < numInteriorFaces(timeIdx); fluxIdx++) {
+            const auto& face = stencil_.interiorFace(fluxIdx);
+            if (face.interiorIndex() != dofIdx && face.exteriorIndex() != dofIdx)
+                continue;
+
+            extensiveQuantities_[fluxIdx].update(/*context=*/asImp_(),
+                                                 /*localIndex=*/fluxIdx,
+                                                 timeIdx);
+        }
+    }
+
     /*!
      * \brief Sets the degree of freedom on which the simulator is currently "focused" on
      *
@@ -466,7 +497,8 @@ public:
      * \brief Return the (local) index of the DOF for which the primary variables were
      *        stashed
      *
-     * If none, then this returns -1.
+     * If the quantities of multiple DOFs are stashed, this is the one which was stashed
+     * last. If none, then this returns -1.
      */
     int stashedDofIdx() const
     { return stashedDofIdx_; }
@@ -474,15 +506,19 @@ public:
     /*!
      * \brief Stash the intensive quantities for a degree of freedom on internal memory.
      *
+     * The quantities of several degrees of freedom can be stashed at the same time.
+     *
      * \param dofIdx The local index of the degree of freedom in the current element.
      */
     void stashIntensiveQuantities(unsigned dofIdx)
     {
         assert(dofIdx < numDof(/*timeIdx=*/0));
+        assert(dofIdx < intensiveQuantitiesStashed_.size());
 
-        intensiveQuantitiesStashed_ = dofVars_[dofIdx].intensiveQuantities[/*timeIdx=*/0];
-        priVarsStashed_ = *dofVars_[dofIdx].priVars[/*timeIdx=*/0];
+        intensiveQuantitiesStashed_[dofIdx] = dofVars_[dofIdx].intensiveQuantities[/*timeIdx=*/0];
+        priVarsStashed_[dofIdx] = *dofVars_[dofIdx].priVars[/*timeIdx=*/0];
         stashedDofIdx_ = static_cast<int>(dofIdx);
+        ++numStashedDofs_;
     }
 
     /*!
@@ -492,9 +528,12 @@ public:
      */
     void restoreIntensiveQuantities(unsigned dofIdx)
     {
-        dofVars_[dofIdx].priVars[/*timeIdx=*/0] = &priVarsStashed_;
-        dofVars_[dofIdx].intensiveQuantities[/*timeIdx=*/0] = intensiveQuantitiesStashed_;
-        stashedDofIdx_ = -1;
+        assert(numStashedDofs_ > 0);
+
+        dofVars_[dofIdx].priVars[/*timeIdx=*/0] = &priVarsStashed_[dofIdx];
+        dofVars_[dofIdx].intensiveQuantities[/*timeIdx=*/0] = intensiveQuantitiesStashed_[dofIdx];
+        if (--numStashedDofs_ == 0)
+            stashedDofIdx_ = -1;
     }
 
     /*!
@@ -570,6 +609,18 @@ protected:
         }
     }
 
+    // the stashed primary variables are referenced by the DOFs after they have been
+    // restored, so the storage must only be reallocated if a new element is visited
+    void resizeStash_(size_t numDof)
+    {
+        stashedDofIdx_ = -1;
+        numStashedDofs_ = 0;
+        if (intensiveQuantitiesStashed_.size() < numDof) {
+            intensiveQuantitiesStashed_.resize(numDof);
+            priVarsStashed_.resize(numDof);
+        }
+    }
+
     void updateSingleIntQuants_(const PrimaryVariables& priVars, unsigned dofIdx, unsigned timeIdx)
     {
 #ifndef NDEBUG
@@ -580,10 +631,11 @@ protected:
 
         dofVars_[dofIdx].priVars[timeIdx] = &priVars;
         dofVars_[dofIdx].intensiveQuantities[timeIdx].update(/*context=*/asImp_(), dofIdx, timeIdx);
+        EWOMS_PROFILE_COUNT("intensive quantity updates", 1);
     }
 
-    IntensiveQuantities intensiveQuantitiesStashed_;
-    PrimaryVariables priVarsStashed_;
+    std::vector<IntensiveQuantities, aligned_allocator<IntensiveQuantities, alignof(IntensiveQuantities)> > intensiveQuantitiesStashed_;
+    std::vector<PrimaryVariables, aligned_allocator<PrimaryVariables, alignof(PrimaryVariables)> > priVarsStashed_;
 
     GradientCalculator gradientCalculator_;
 
@@ -596,6 +648,7 @@ protected:
     Stencil stencil_;
 
     int stashedDofIdx_;
+    unsigned numStashedDofs_;
     int focusDofIdx_;
     bool enableStorageCache_;
 };
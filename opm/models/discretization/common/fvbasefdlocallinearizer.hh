@@ -41,7 +41,10 @@
 #include <dune/common/fvector.hh>
 #include <dune/common/fmatrix.hh>
 
+#include <algorithm>
 #include <limits>
+#include <stdexcept>
+#include <vector>
 
 namespace Opm {
 // forward declaration
@@ -62,6 +65,10 @@ template<class TypeTag, class MyTypeTag>
 struct NumericDifferenceMethod { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct BaseEpsilon { using type = UndefinedProperty; };
+template<class TypeTag, class MyTypeTag>
+struct SparseNumericDifferentiation { using type = UndefinedProperty; };
+template<class TypeTag, class MyTypeTag>
+struct NumericDifferenceColoring { using type = UndefinedProperty; };
 
 // set the properties to be spliced in
 template<class TypeTag>
@@ -90,6 +97,23 @@ struct BaseEpsilon<TypeTag, TTag::FiniteDifferenceLocalLinearizer>
     static constexpr type value = std::max<type>(0.9123e-10, std::numeric_limits<type>::epsilon()*1.23e3);
 };
 
+/*!
+ * \brief Specify whether only the terms of the residual which depend on the perturbed
+ *        degree of freedom ought to be re-evaluated.
+ *
+ * This is only correct if the extensive quantities of a face solely depend on its
+ * interior and exterior degrees of freedom, e.g., if two-point gradients are used.
+ */
+template<class TypeTag>
+struct SparseNumericDifferentiation<TypeTag, TTag::FiniteDifferenceLocalLinearizer> { static constexpr bool value = false; };
+
+/*!
+ * \brief Specify whether independent degrees of freedom of an element ought to be
+ *        perturbed simultaneously if sparse numeric differentiation is used.
+ */
+template<class TypeTag>
+struct NumericDifferenceColoring<TypeTag, TTag::FiniteDifferenceLocalLinearizer> { static constexpr bool value = false; };
+
 } // namespace Opm::Properties
 
 namespace Opm {
@@ -129,6 +153,14 @@ namespace Opm {
  * Here, \f$ f \f$ is the residual function for all equations, \f$x\f$ is the value of a
  * sub-control volume's primary variable at the evaluation point and \f$\epsilon\f$ is a
  * small scalar value larger than 0.
+ *
+ * If the "SparseNumericDifferentiation" parameter is enabled, only the fluxes over the
+ * faces adjacent to the perturbed degree of freedom as well as its storage, source and
+ * boundary terms are re-evaluated for each perturbation. This requires the extensive
+ * quantities of a face to only depend on its interior and exterior degrees of freedom,
+ * i.e., it cannot be used with P1 finite element gradients. With
+ * "NumericDifferenceColoring", all degrees of freedom of an element which do not share
+ * any neighbor are additionally perturbed at the same time.
  */
 template<class TypeTag>
 class FvBaseFdLocalLinearizer
@@ -144,6 +176,7 @@ private:
     using Scalar = GetPropType<TypeTag, Properties::Scalar>;
     using GridView = GetPropType<TypeTag, Properties::GridView>;
     using Element = typename GridView::template Codim<0>::Entity;
+    using GradientCalculator = GetPropType<TypeTag, Properties::GradientCalculator>;
 
     enum { numEq = getPropValue<TypeTag, Properties::NumEq>() };
 
@@ -172,7 +205,10 @@ public:
 public:
     FvBaseFdLocalLinearizer()
         : internalElemContext_(0)
-    { }
+    {
+        setSparseNumericDifferentiation(EWOMS_GET_PARAM(TypeTag, bool, SparseNumericDifferentiation),
+                                        EWOMS_GET_PARAM(TypeTag, bool, NumericDifferenceColoring));
+    }
 
     ~FvBaseFdLocalLinearizer()
     { delete internalElemContext_; }
@@ -185,6 +221,12 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, int, NumericDifferenceMethod,
                              "The method used for numeric differentiation (-1: backward "
                              "differences, 0: central differences, 1: forward differences)");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, SparseNumericDifferentiation,
+                             "Only re-evaluate the terms of the residual which depend on the "
+                             "perturbed degree of freedom for numeric differentiation");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, NumericDifferenceColoring,
+                             "Simultaneously perturb the degrees of freedom of an element which "
+                             "do not share any neighbors if sparse numeric differentiation is used");
     }
 
     /*!
@@ -202,6 +244,31 @@ public:
         internalElemContext_ = new ElementContext(simulator);
     }
 
+    /*!
+     * \brief Specify how the partial derivatives are evaluated.
+     *
+     * By default, this is determined by the "SparseNumericDifferentiation" and
+     * "NumericDifferenceColoring" parameters.
+     *
+     * \param sparse Only re-evaluate the terms of the residual which depend on the
+     *               perturbed degrees of freedom
+     * \param coloring Perturb the independent degrees of freedom of an element at the
+     *                 same time. This is ignored if \c sparse is false.
+     */
+    void setSparseNumericDifferentiation(bool sparse, bool coloring)
+    {
+        // with gradients which are not based on two-point approximations, the extensive
+        // quantities of a face depend on more degrees of freedom than the ones adjacent
+        // to it and the sparse Jacobian would be wrong
+        if (sparse && !GradientCalculator::usesTwoPointStencil())
+            throw std::invalid_argument("Sparse numeric differentiation requires two-point "
+                                        "gradients, i.e., it cannot be combined with "
+                                        "P1 finite element gradients");
+
+        sparseNumericDifferentiation_ = sparse;
+        numericDifferenceColoring_ = sparse && coloring;
+    }
+
     /*!
      * \brief Compute an element's local Jacobian matrix and evaluate its residual.
      *
@@ -245,6 +312,11 @@ public:
         // calculate the local residual
         localResidual_.eval(residual_, elemCtx);
 
+        if (sparseNumericDifferentiation_) {
+            linearizeSparse_(elemCtx);
+            return;
+        }
+
         // calculate the local jacobian matrix
         size_t numPrimaryDof = elemCtx.numPrimaryDof(/*timeIdx=*/0);
         for (unsigned dofIdx = 0; dofIdx < numPrimaryDof; dofIdx++) {
@@ -350,6 +422,15 @@ protected:
         jacobian_.setSize(numDof, numPrimaryDof);
 
         derivResidual_.resize(numDof);
+
+        if (sparseNumericDifferentiation_) {
+            dofResidual_.resize(numDof);
+            perturbedResidual_.resize(numDof);
+            unperturbedPriVars_.resize(numPrimaryDof);
+            perturbedPriVars_.resize(numPrimaryDof);
+            epsilons_.resize(numPrimaryDof);
+            deltas_.resize(numPrimaryDof);
+        }
     }
 
     /*!
@@ -480,6 +561,174 @@ protected:
 #endif
     }
 
+    /*!
+     * \brief Compute the local Jacobian matrix by only re-evaluating the terms of the
+     *        residual which depend on the perturbed degrees of freedom.
+     *
+     * The residual of the unperturbed solution must already have been calculated.
+     */
+    void linearizeSparse_(ElementContext& elemCtx)
+    {
+        updateDofGroups_(elemCtx);
+
+        for (unsigned groupIdx = 0; groupIdx < numDofGroups_; ++groupIdx) {
+            const auto& dofIndices = dofGroups_[groupIdx];
+
+            // the extensive quantities of the adjacent faces may still correspond to a
+            // perturbation of the previous group
+            for (unsigned dofIdx : dofIndices) {
+                elemCtx.stashIntensiveQuantities(dofIdx);
+                unperturbedPriVars_[dofIdx] = elemCtx.primaryVars(dofIdx, /*timeIdx=*/0);
+                elemCtx.updateAdjacentExtensiveQuantities(dofIdx, /*timeIdx=*/0);
+            }
+            localResidual_.evalDofTerms(dofResidual_, elemCtx, dofIndices);
+
+            for (unsigned pvIdx = 0; pvIdx < numEq; pvIdx++) {
+                asImp_().evalSparsePartialDerivatives_(elemCtx, dofIndices, pvIdx);
+
+                for (unsigned dofIdx : dofIndices)
+                    updateSparseLocalJacobian_(dofIdx, pvIdx);
+            }
+
+            for (unsigned dofIdx : dofIndices)
+                elemCtx.restoreIntensiveQuantities(dofIdx);
+        }
+    }
+
+    /*!
+     * \brief Compute the partial derivatives of the residual with regard to a primary
+     *        variable of a group of independent degrees of freedom.
+     *
+     * In contrast to evalPartialDerivative_(), only the terms of the residual which
+     * depend on the degrees of freedom of the group are evaluated and the differences
+     * of the residuals are not divided by the magnitude of the deflections. Since no
+     * degree of freedom of the residual is affected by more than one member of the
+     * group, all members can be perturbed simultaneously.
+     *
+     * The intensive quantities of the group must have been stashed by the caller.
+     *
+     * \param elemCtx The element context for which the local partial
+     *                derivatives ought to be calculated
+     * \param dofIndices The local indices of the degrees of freedom which are perturbed
+     * \param pvIdx The index of the primary variable which is perturbed
+     */
+    void evalSparsePartialDerivatives_(ElementContext& elemCtx,
+                                       const std::vector<unsigned>& dofIndices,
+                                       unsigned pvIdx)
+    {
+        for (unsigned dofIdx : dofIndices) {
+            epsilons_[dofIdx] = asImp_().numericEpsilon(elemCtx, dofIdx, pvIdx);
+            deltas_[dofIdx] = 0.0;
+        }
+
+        if (numericDifferenceMethod_() >= 0) {
+            // calculate f(x + \epsilon)
+            for (unsigned dofIdx : dofIndices) {
+                perturbedPriVars_[dofIdx] = unperturbedPriVars_[dofIdx];
+                perturbedPriVars_[dofIdx][pvIdx] += epsilons_[dofIdx];
+                deltas_[dofIdx] += epsilons_[dofIdx];
+                elemCtx.updateIntensiveQuantities(perturbedPriVars_[dofIdx], dofIdx, /*timeIdx=*/0);
+            }
+            for (unsigned dofIdx : dofIndices)
+                elemCtx.updateAdjacentExtensiveQuantities(dofIdx, /*timeIdx=*/0);
+            localResidual_.evalDofTerms(derivResidual_, elemCtx, dofIndices);
+        }
+        else
+            // backward differences: recycle f(x)
+            derivResidual_ = dofResidual_;
+
+        if (numericDifferenceMethod_() <= 0) {
+            // calculate f(x - \epsilon)
+            for (unsigned dofIdx : dofIndices) {
+                perturbedPriVars_[dofIdx] = unperturbedPriVars_[dofIdx];
+                perturbedPriVars_[dofIdx][pvIdx] -= epsilons_[dofIdx];
+                deltas_[dofIdx] += epsilons_[dofIdx];
+                elemCtx.updateIntensiveQuantities(perturbedPriVars_[dofIdx], dofIdx, /*timeIdx=*/0);
+            }
+            for (unsigned dofIdx : dofIndices)
+                elemCtx.updateAdjacentExtensiveQuantities(dofIdx, /*timeIdx=*/0);
+            localResidual_.evalDofTerms(perturbedResidual_, elemCtx, dofIndices);
+
+            derivResidual_ -= perturbedResidual_;
+        }
+        else
+            // forward differences: recycle f(x)
+            derivResidual_ -= dofResidual_;
+
+#ifndef NDEBUG
+        for (unsigned i = 0; i < derivResidual_.size(); ++i)
+            Valgrind::CheckDefined(derivResidual_[i]);
+#endif
+    }
+
+    /*!
+     * \brief Partition the primary degrees of freedom of an element into groups which
+     *        can be perturbed simultaneously.
+     *
+     * Two degrees of freedom can be perturbed at the same time if the sets of degrees of
+     * freedom which their residual terms contribute to are disjoint. Without coloring,
+     * each group consists of a single degree of freedom.
+     */
+    void updateDofGroups_(const ElementContext& elemCtx)
+    {
+        size_t numDof = elemCtx.numDof(/*timeIdx=*/0);
+        size_t numPrimaryDof = elemCtx.numPrimaryDof(/*timeIdx=*/0);
+
+        // determine the degrees of freedom affected by each primary one
+        adjacentDofs_.resize(numPrimaryDof);
+        for (unsigned dofIdx = 0; dofIdx < numPrimaryDof; ++dofIdx)
+            adjacentDofs_[dofIdx].assign(1, dofIdx);
+
+        const auto& stencil = elemCtx.stencil(/*timeIdx=*/0);
+        size_t numInteriorFaces = elemCtx.numInteriorFaces(/*timeIdx=*/0);
+        for (unsigned scvfIdx = 0; scvfIdx < numInteriorFaces; ++scvfIdx) {
+            const auto& face = stencil.interiorFace(scvfIdx);
+            unsigned i = face.interiorIndex();
+            unsigned j = face.exteriorIndex();
+            if (i < numPrimaryDof)
+                addAdjacentDof_(i, j);
+            if (j < numPrimaryDof)
+                addAdjacentDof_(j, i);
+        }
+
+        // greedily assign the degrees of freedom to groups
+        numDofGroups_ = 0;
+        groupTouchesDof_.clear();
+        for (unsigned dofIdx = 0; dofIdx < numPrimaryDof; ++dofIdx) {
+            unsigned groupIdx = 0;
+            if (numericDifferenceColoring_) {
+                for (; groupIdx < numDofGroups_; ++groupIdx) {
+                    bool independent = true;
+                    for (unsigned adjDofIdx : adjacentDofs_[dofIdx])
+                        independent = independent && !groupTouchesDof_[groupIdx*numDof + adjDofIdx];
+                    if (independent)
+                        break;
+                }
+            }
+            else
+                groupIdx = numDofGroups_;
+
+            if (groupIdx == numDofGroups_) {
+                ++numDofGroups_;
+                if (dofGroups_.size() < numDofGroups_)
+                    dofGroups_.resize(numDofGroups_);
+                dofGroups_[groupIdx].clear();
+                groupTouchesDof_.resize(numDofGroups_*numDof, false);
+            }
+
+            dofGroups_[groupIdx].push_back(dofIdx);
+            for (unsigned adjDofIdx : adjacentDofs_[dofIdx])
+                groupTouchesDof_[groupIdx*numDof + adjDofIdx] = true;
+        }
+    }
+
+    void addAdjacentDof_(unsigned dofIdx, unsigned adjDofIdx)
+    {
+        auto& adjDofs = adjacentDofs_[dofIdx];
+        if (std::find(adjDofs.begin(), adjDofs.end(), adjDofIdx) == adjDofs.end())
+            adjDofs.push_back(adjDofIdx);
+    }
+
     /*!
      * \brief Updates the current local Jacobian matrix with the partial derivatives of
      *        all equations for primary variable 'pvIdx' at the degree of freedom
@@ -502,6 +751,26 @@ protected:
         }
     }
 
+    /*!
+     * \brief Updates the current local Jacobian matrix with the partial derivatives
+     *        which were computed by evalSparsePartialDerivatives_().
+     *
+     * Only the degrees of freedom which are affected by 'focusDofIdx' are considered,
+     * all other entries of the local Jacobian stay zero.
+     */
+    void updateSparseLocalJacobian_(unsigned focusDofIdx, unsigned pvIdx)
+    {
+        Scalar delta = deltas_[focusDofIdx];
+        assert(delta > 0);
+
+        for (unsigned dofIdx : adjacentDofs_[focusDofIdx]) {
+            for (unsigned eqIdx = 0; eqIdx < numEq; eqIdx++) {
+                jacobian_[dofIdx][focusDofIdx][eqIdx][pvIdx] = derivResidual_[dofIdx][eqIdx]/delta;
+                Valgrind::CheckDefined(jacobian_[dofIdx][focusDofIdx][eqIdx][pvIdx]);
+            }
+        }
+    }
+
     Simulator *simulatorPtr_;
     Model *modelPtr_;
 
@@ -511,6 +780,20 @@ protected:
     LocalEvalBlockVector derivResidual_;
     ScalarLocalBlockMatrix jacobian_;
 
+    // state of the sparse numeric differentiation
+    bool sparseNumericDifferentiation_ = false;
+    bool numericDifferenceColoring_ = false;
+    LocalEvalBlockVector dofResidual_;
+    LocalEvalBlockVector perturbedResidual_;
+    std::vector<PrimaryVariables> unperturbedPriVars_;
+    std::vector<PrimaryVariables> perturbedPriVars_;
+    std::vector<Scalar> epsilons_;
+    std::vector<Scalar> deltas_;
+    std::vector<std::vector<unsigned> > adjacentDofs_;
+    std::vector<std::vector<unsigned> > dofGroups_;
+    std::vector<bool> groupTouchesDof_;
+    unsigned numDofGroups_ = 0;
+
     LocalResidual localResidual_;
 };
 
@@ -69,6 +69,13 @@ public:
     static void registerParameters()
     { }
 
+    /*!
+     * \brief Returns true iff the values and gradients at a face only depend on the
+     *        degrees of freedom adjacent to the face.
+     */
+    static constexpr bool usesTwoPointStencil()
+    { return true; }
+
     /*!
      * \brief Precomputes the common values to calculate gradients and values of
      *        quantities at every interior flux approximation point.
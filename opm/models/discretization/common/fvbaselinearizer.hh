@@ -39,12 +39,15 @@
 #include <opm/models/parallel/threadmanager.hh>
 #include <opm/models/parallel/threadedentityiterator.hh>
 #include <opm/models/discretization/common/baseauxiliarymodule.hh>
+#include <opm/models/io/preprocessingcache.hh>
 
 #include <dune/common/version.hh>
 #include <dune/common/fvector.hh>
 #include <dune/common/fmatrix.hh>
 
+#include <chrono>
 #include <type_traits>
+#include <typeinfo>
 #include <iostream>
 #include <vector>
 #include <thread>
@@ -113,6 +116,10 @@ class FvBaseLinearizer
 //! \endcond
 
 public:
+    //! Subdomains are specified by grid views, i.e., the linearizer is not able to
+    //! assemble lists of cells
+    static constexpr bool linearizesCellSubDomains = false;
+
     FvBaseLinearizer()
         : jacobian_()
     {
@@ -131,7 +138,14 @@ public:
      * \brief Register all run-time parameters for the Jacobian linearizer.
      */
     static void registerParameters()
-    { }
+    {
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, PreprocessingCacheDir,
+                             "The directory in which the results of expensive preprocessing "
+                             "steps are cached for later runs. An empty value disables the cache");
+        EWOMS_REGISTER_PARAM(TypeTag, unsigned, LinearizationCostSamplingInterval,
+                             "Measure the time needed to linearize each element every N-th "
+                             "linearization if dynamic load balancing is enabled");
+    }
 
     /*!
      * \brief Initialize the linearizer.
@@ -153,6 +167,13 @@ public:
         }
         elementCtx_.resize(0);
         fullDomain_ = std::make_unique<FullDomain>(simulator.gridView());
+
+        costSamplingInterval_ = 0;
+        if (EWOMS_GET_PARAM(TypeTag, bool, EnableDynamicLoadBalancing))
+            costSamplingInterval_ = EWOMS_GET_PARAM(TypeTag, unsigned, LinearizationCostSamplingInterval);
+        elementCost_.clear();
+        if (costSamplingInterval_ > 0)
+            elementCost_.resize(static_cast<std::size_t>(simulator.gridView().size(/*codim=*/0)), 0.0);
     }
 
     /*!
@@ -167,6 +188,17 @@ public:
         jacobian_.reset();
     }
 
+    /*!
+     * \brief Returns the measured wall clock time in seconds which is needed to
+     *        linearize each element.
+     *
+     * The vector is indexed by the element mapper. It is only filled if dynamic load
+     * balancing is enabled. Elements which have not been sampled yet exhibit a cost of
+     * zero.
+     */
+    const std::vector<Scalar>& elementCosts() const
+    { return elementCost_; }
+
     /*!
      * \brief Linearize the full system of non-linear equations.
      *
@@ -421,17 +453,32 @@ private:
         sparsityPattern_.clear();
         sparsityPattern_.resize(model.numTotalDof());
 
-        for (const auto& elem : elements(gridView_())) {
-            stencil.update(elem);
+        // the part of the sparsity pattern which is caused by the grid only depends on
+        // its topology and on the discretization, so it can be reused by later runs
+        PreprocessingCache cache(EWOMS_GET_PARAM(TypeTag, std::string, PreprocessingCacheDir),
+                                 gridView_().comm().rank(),
+                                 gridView_().comm().size());
+        if (cache.isEnabled()) {
+            cache.hashString(typeid(Stencil).name());
+            cache.hashValue(model.numTotalDof());
+            cache.hashGridTopology(gridView_());
+        }
+
+        if (!cache.loadSparsityPattern(sparsityPattern_)) {
+            for (const auto& elem : elements(gridView_())) {
+                stencil.update(elem);
 
-            for (unsigned primaryDofIdx = 0; primaryDofIdx < stencil.numPrimaryDof(); ++primaryDofIdx) {
-                unsigned myIdx = stencil.globalSpaceIndex(primaryDofIdx);
+                for (unsigned primaryDofIdx = 0; primaryDofIdx < stencil.numPrimaryDof(); ++primaryDofIdx) {
+                    unsigned myIdx = stencil.globalSpaceIndex(primaryDofIdx);
 
-                for (unsigned dofIdx = 0; dofIdx < stencil.numDof(); ++dofIdx) {
-                    unsigned neighborIdx = stencil.globalSpaceIndex(dofIdx);
-                    sparsityPattern_[myIdx].insert(neighborIdx);
+                    for (unsigned dofIdx = 0; dofIdx < stencil.numDof(); ++dofIdx) {
+                        unsigned neighborIdx = stencil.globalSpaceIndex(dofIdx);
+                        sparsityPattern_[myIdx].insert(neighborIdx);
+                    }
                 }
             }
+
+            cache.storeSparsityPattern(sparsityPattern_);
         }
 
         // add the additional neighbors and degrees of freedom caused by the auxiliary
@@ -519,6 +566,8 @@ private:
 
         applyConstraintsToSolution_();
 
+        ++linearizationIdx_;
+
         // to avoid a race condition if two threads handle an exception at the same time,
         // we use an explicit lock to control access to the exception storage object
         // amongst thread-local handlers
@@ -595,8 +644,27 @@ private:
         ElementContext *elementCtx = elementCtx_[threadId];
         auto& localLinearizer = model_().localLinearizer(threadId);
 
-        // the actual work of linearization is done by the local linearizer class
-        localLinearizer.linearize(*elementCtx, elem);
+        // the actual work of linearization is done by the local linearizer class. every
+        // element is timed in one of costSamplingInterval_ linearizations, which keeps
+        // the overhead of reading the clock negligible.
+        unsigned elemIdx = 0;
+        bool sampleCost = false;
+        if (costSamplingInterval_ > 0) {
+            elemIdx = static_cast<unsigned>(elementMapper_().index(elem));
+            sampleCost = (elemIdx + linearizationIdx_) % costSamplingInterval_ == 0;
+        }
+
+        if (sampleCost) {
+            const auto startTime = std::chrono::steady_clock::now();
+            localLinearizer.linearize(*elementCtx, elem);
+            const std::chrono::duration<Scalar> duration = std::chrono::steady_clock::now() - startTime;
+
+            // exponentially weighted average, so that moving fronts are followed
+            Scalar& cost = elementCost_[elemIdx];
+            cost = (cost > 0.0) ? 0.5*(cost + duration.count()) : duration.count();
+        }
+        else
+            localLinearizer.linearize(*elementCtx, elem);
 
         // update the right hand side and the Jacobian matrix
         if (getPropValue<TypeTag, Properties::UseLinearizationLock>())
@@ -693,6 +761,11 @@ private:
 
     std::vector<std::set<unsigned int>> sparsityPattern_;
 
+    // the measured cost of linearizing the elements
+    std::vector<Scalar> elementCost_;
+    unsigned costSamplingInterval_ = 0;
+    unsigned linearizationIdx_ = 0;
+
     struct FullDomain
     {
         explicit FullDomain(const GridView& v) : view (v) {}
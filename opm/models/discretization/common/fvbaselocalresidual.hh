@@ -32,6 +32,7 @@
 
 #include <opm/models/utils/parametersystem.hh>
 #include <opm/models/utils/alignedallocator.hh>
+#include <opm/models/utils/profiler.hh>
 
 #include <opm/material/common/Valgrind.hpp>
 
@@ -42,7 +43,9 @@
 
 #include <dune/common/classname.hh>
 
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
 namespace Opm {
 /*!
@@ -171,23 +174,61 @@ public:
         // evaluate the boundary conditions
         asImp_().evalBoundary_(residual, elemCtx, /*timeIdx=*/0);
 
-        if (useVolumetricResidual) {
-            // make the residual volume specific (i.e., make it incorrect mass per cubic
-            // meter instead of total mass)
-            size_t numDof = elemCtx.numDof(/*timeIdx=*/0);
-            for (unsigned dofIdx=0; dofIdx < numDof; ++dofIdx) {
-                if (elemCtx.dofTotalVolume(dofIdx, /*timeIdx=*/0) > 0.0) {
-                    // interior DOF
-                    Scalar dofVolume = elemCtx.dofTotalVolume(dofIdx, /*timeIdx=*/0);
+        if (useVolumetricResidual)
+            makeVolumetric_(residual, elemCtx);
+    }
+
+    /*!
+     * \brief Compute the terms of the local residual which depend on the primary
+     *        variables of a set of degrees of freedom.
+     *
+     * These terms are the fluxes over all sub-control volume faces adjacent to one of
+     * the degrees of freedom plus their storage, source and boundary terms. All other
+     * entries of the residual are zero. This assumes that the extensive quantities of a
+     * face only depend on the intensive quantities of its interior and exterior degree
+     * of freedom, i.e., that no face is adjacent to more than one of the specified
+     * degrees of freedom and that the gradients are approximated using two-point
+     * schemes.
+     *
+     * \copydetails Doxygen::residualParam
+     * \copydetails Doxygen::ecfvElemCtxParam
+     * \param dofIndices The local indices of the primary degrees of freedom
+     */
+    void evalDofTerms(LocalEvalBlockVector& residual,
+                      ElementContext& elemCtx,
+                      const std::vector<unsigned>& dofIndices) const
+    {
+        assert(residual.size() == elemCtx.numDof(/*timeIdx=*/0));
 
-                    assert(std::isfinite(dofVolume));
-                    Valgrind::CheckDefined(dofVolume);
+        residual = 0.0;
 
-                    for (unsigned eqIdx = 0; eqIdx < numEq; ++ eqIdx)
-                        residual[dofIdx][eqIdx] /= dofVolume;
-                }
+        const auto& stencil = elemCtx.stencil(/*timeIdx=*/0);
+        size_t numInteriorFaces = elemCtx.numInteriorFaces(/*timeIdx=*/0);
+        for (unsigned scvfIdx = 0; scvfIdx < numInteriorFaces; scvfIdx++) {
+            const auto& face = stencil.interiorFace(scvfIdx);
+            if (isContained_(dofIndices, face.interiorIndex())
+                || isContained_(dofIndices, face.exteriorIndex()))
+                asImp_().addFlux_(residual, elemCtx, scvfIdx, /*timeIdx=*/0);
+        }
+
+        for (unsigned dofIdx : dofIndices)
+            asImp_().evalVolumeTerm_(residual, elemCtx, dofIdx);
+
+        if (elemCtx.onBoundary()) {
+            BoundaryContext boundaryCtx(elemCtx);
+            if (boundaryCtx.intersection(0).neighbor())
+                boundaryCtx.increment();
+
+            size_t numBoundaryFaces = boundaryCtx.numBoundaryFaces(/*timeIdx=*/0);
+            for (unsigned faceIdx = 0; faceIdx < numBoundaryFaces; ++faceIdx, boundaryCtx.increment()) {
+                unsigned dofIdx = boundaryCtx.stencil(/*timeIdx=*/0).boundaryFace(faceIdx).interiorIndex();
+                if (isContained_(dofIndices, dofIdx))
+                    evalBoundarySegment_(residual, boundaryCtx, faceIdx, /*timeIdx=*/0);
             }
         }
+
+        if (useVolumetricResidual)
+            makeVolumetric_(residual, elemCtx);
     }
 
     /*!
@@ -300,52 +341,11 @@ public:
                     const ElementContext& elemCtx,
                     unsigned timeIdx) const
     {
-        RateVector flux;
-
-        const auto& stencil = elemCtx.stencil(timeIdx);
         // calculate the mass flux over the sub-control volume faces
         size_t numInteriorFaces = elemCtx.numInteriorFaces(timeIdx);
-        for (unsigned scvfIdx = 0; scvfIdx < numInteriorFaces; scvfIdx++) {
-            const auto& face = stencil.interiorFace(scvfIdx);
-            unsigned i = face.interiorIndex();
-            unsigned j = face.exteriorIndex();
-
-            Valgrind::SetUndefined(flux);
-            asImp_().computeFlux(flux, /*context=*/elemCtx, scvfIdx, timeIdx);
-            Valgrind::CheckDefined(flux);
-#ifndef NDEBUG
-            for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
-                assert(isfinite(flux[eqIdx]));
-#endif
-
-            Scalar alpha = elemCtx.extensiveQuantities(scvfIdx, timeIdx).extrusionFactor();
-            alpha *= face.area();
-            Valgrind::CheckDefined(alpha);
-            assert(alpha > 0.0);
-            assert(isfinite(alpha));
-
-            for (unsigned eqIdx = 0; eqIdx < numEq; ++ eqIdx)
-                flux[eqIdx] *= alpha;
-
-            // The balance equation for a finite volume is given by
-            //
-            // dStorage/dt + Flux = Source
-            //
-            // where the 'Flux' and the 'Source' terms represent the
-            // mass per second which leaves the finite
-            // volume. Re-arranging this, we get
-            //
-            // dStorage/dt + Flux - Source = 0
-            //
-            // Since the mass flux as calculated by computeFlux() goes out of sub-control
-            // volume i and into sub-control volume j, we need to add the flux to finite
-            // volume i and subtract it from finite volume j
-            for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx) {
-                assert(isfinite(flux[eqIdx]));
-                residual[i][eqIdx] += flux[eqIdx];
-                residual[j][eqIdx] -= flux[eqIdx];
-            }
-        }
+        for (unsigned scvfIdx = 0; scvfIdx < numInteriorFaces; scvfIdx++)
+            asImp_().addFlux_(residual, elemCtx, scvfIdx, timeIdx);
+        EWOMS_PROFILE_COUNT("flux evaluations", numInteriorFaces);
 
 #if !defined NDEBUG
         // in debug mode, ensure that the residual is well-defined
@@ -413,6 +413,58 @@ public:
     }
 
 protected:
+    /*!
+     * \brief Add the flux over a single sub-control volume face to the residuals of
+     *        its interior and exterior degrees of freedom.
+     */
+    void addFlux_(LocalEvalBlockVector& residual,
+                  const ElementContext& elemCtx,
+                  unsigned scvfIdx,
+                  unsigned timeIdx) const
+    {
+        RateVector flux;
+
+        const auto& face = elemCtx.stencil(timeIdx).interiorFace(scvfIdx);
+        unsigned i = face.interiorIndex();
+        unsigned j = face.exteriorIndex();
+
+        Valgrind::SetUndefined(flux);
+        asImp_().computeFlux(flux, /*context=*/elemCtx, scvfIdx, timeIdx);
+        Valgrind::CheckDefined(flux);
+#ifndef NDEBUG
+        for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
+            assert(isfinite(flux[eqIdx]));
+#endif
+
+        Scalar alpha = elemCtx.extensiveQuantities(scvfIdx, timeIdx).extrusionFactor();
+        alpha *= face.area();
+        Valgrind::CheckDefined(alpha);
+        assert(alpha > 0.0);
+        assert(isfinite(alpha));
+
+        for (unsigned eqIdx = 0; eqIdx < numEq; ++ eqIdx)
+            flux[eqIdx] *= alpha;
+
+        // The balance equation for a finite volume is given by
+        //
+        // dStorage/dt + Flux = Source
+        //
+        // where the 'Flux' and the 'Source' terms represent the
+        // mass per second which leaves the finite
+        // volume. Re-arranging this, we get
+        //
+        // dStorage/dt + Flux - Source = 0
+        //
+        // Since the mass flux as calculated by computeFlux() goes out of sub-control
+        // volume i and into sub-control volume j, we need to add the flux to finite
+        // volume i and subtract it from finite volume j
+        for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx) {
+            assert(isfinite(flux[eqIdx]));
+            residual[i][eqIdx] += flux[eqIdx];
+            residual[j][eqIdx] -= flux[eqIdx];
+        }
+    }
+
     /*!
      * \brief Evaluate the boundary conditions of an element.
      */
@@ -490,6 +542,31 @@ protected:
      */
     void evalVolumeTerms_(LocalEvalBlockVector& residual,
                           ElementContext& elemCtx) const
+    {
+        // evaluate the volumetric terms (storage + source terms)
+        size_t numPrimaryDof = elemCtx.numPrimaryDof(/*timeIdx=*/0);
+        for (unsigned dofIdx=0; dofIdx < numPrimaryDof; dofIdx++)
+            asImp_().evalVolumeTerm_(residual, elemCtx, dofIdx);
+
+#if !defined NDEBUG
+        // in debug mode, ensure that the residual is well-defined
+        size_t numDof = elemCtx.numDof(/*timeIdx=*/0);
+        for (unsigned i=0; i < numDof; i++) {
+            for (unsigned j = 0; j < numEq; ++ j) {
+                assert(isfinite(residual[i][j]));
+                Valgrind::CheckDefined(residual[i][j]);
+            }
+        }
+#endif
+    }
+
+    /*!
+     * \brief Add the change in the storage term and the source term of a single
+     *        sub-control volume to the local residual.
+     */
+    void evalVolumeTerm_(LocalEvalBlockVector& residual,
+                         ElementContext& elemCtx,
+                         unsigned dofIdx) const
     {
         EvalVector tmp;
         EqVector tmp2;
@@ -498,133 +575,143 @@ protected:
         tmp = 0.0;
         tmp2 = 0.0;
 
-        // evaluate the volumetric terms (storage + source terms)
-        size_t numPrimaryDof = elemCtx.numPrimaryDof(/*timeIdx=*/0);
-        for (unsigned dofIdx=0; dofIdx < numPrimaryDof; dofIdx++) {
-            Scalar extrusionFactor =
-                elemCtx.intensiveQuantities(dofIdx, /*timeIdx=*/0).extrusionFactor();
-            Valgrind::CheckDefined(extrusionFactor);
-            assert(isfinite(extrusionFactor));
-            assert(extrusionFactor > 0.0);
-            Scalar scvVolume =
-               elemCtx.stencil(/*timeIdx=*/0).subControlVolume(dofIdx).volume() * extrusionFactor;
-            Valgrind::CheckDefined(scvVolume);
-            assert(isfinite(scvVolume));
-            assert(scvVolume > 0.0);
-
-            // if the model uses extensive quantities in its storage term, and we use
-            // automatic differention and current DOF is also not the one we currently
-            // focus on, the storage term does not need any derivatives!
-            if (!extensiveStorageTerm &&
-                !std::is_same<Scalar, Evaluation>::value &&
-                dofIdx != elemCtx.focusDofIndex())
-            {
-                asImp_().computeStorage(tmp2, elemCtx, dofIdx, /*timeIdx=*/0);
-                for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
-                    tmp[eqIdx] = tmp2[eqIdx];
-            }
-            else
-                asImp_().computeStorage(tmp, elemCtx, dofIdx, /*timeIdx=*/0);
+        Scalar extrusionFactor =
+            elemCtx.intensiveQuantities(dofIdx, /*timeIdx=*/0).extrusionFactor();
+        Valgrind::CheckDefined(extrusionFactor);
+        assert(isfinite(extrusionFactor));
+        assert(extrusionFactor > 0.0);
+        Scalar scvVolume =
+           elemCtx.stencil(/*timeIdx=*/0).subControlVolume(dofIdx).volume() * extrusionFactor;
+        Valgrind::CheckDefined(scvVolume);
+        assert(isfinite(scvVolume));
+        assert(scvVolume > 0.0);
+
+        // if the model uses extensive quantities in its storage term, and we use
+        // automatic differention and current DOF is also not the one we currently
+        // focus on, the storage term does not need any derivatives!
+        if (!extensiveStorageTerm &&
+            !std::is_same<Scalar, Evaluation>::value &&
+            dofIdx != elemCtx.focusDofIndex())
+        {
+            asImp_().computeStorage(tmp2, elemCtx, dofIdx, /*timeIdx=*/0);
+            for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
+                tmp[eqIdx] = tmp2[eqIdx];
+        }
+        else
+            asImp_().computeStorage(tmp, elemCtx, dofIdx, /*timeIdx=*/0);
 
 #ifndef NDEBUG
-            Valgrind::CheckDefined(tmp);
-            for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
-                assert(isfinite(tmp[eqIdx]));
+        Valgrind::CheckDefined(tmp);
+        for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
+            assert(isfinite(tmp[eqIdx]));
 #endif
 
-            if (elemCtx.enableStorageCache()) {
-                const auto& model = elemCtx.model();
-                unsigned globalDofIdx = elemCtx.globalSpaceIndex(dofIdx, /*timeIdx=*/0);
-                if (model.newtonMethod().numIterations() == 0 &&
-                    !elemCtx.haveStashedIntensiveQuantities())
-                {
-                    if (!elemCtx.problem().recycleFirstIterationStorage()) {
-                        // we re-calculate the storage term for the solution of the
-                        // previous time step from scratch instead of using the one of
-                        // the first iteration of the current time step.
-                        tmp2 = 0.0;
-                        elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/1);
-                        asImp_().computeStorage(tmp2, elemCtx,  dofIdx, /*timeIdx=*/1);
-                    }
-                    else {
-                        // if the storage term is cached and we're in the first iteration
-                        // of the time step, use the storage term of the first iteration
-                        // as the one as the solution of the last time step (this assumes
-                        // that the initial guess for the solution at the end of the time
-                        // step is the same as the solution at the beginning of the time
-                        // step. This is usually true, but some fancy preprocessing
-                        // scheme might invalidate that assumption.)
-                        for (unsigned eqIdx = 0; eqIdx < numEq; ++ eqIdx)
-                            tmp2[eqIdx] = Toolbox::value(tmp[eqIdx]);
-                    }
-
-                    Valgrind::CheckDefined(tmp2);
-
-                    model.updateCachedStorage(globalDofIdx, /*timeIdx=*/1, tmp2);
+        if (elemCtx.enableStorageCache()) {
+            const auto& model = elemCtx.model();
+            unsigned globalDofIdx = elemCtx.globalSpaceIndex(dofIdx, /*timeIdx=*/0);
+            if (model.newtonMethod().numIterations() == 0 &&
+                !elemCtx.haveStashedIntensiveQuantities())
+            {
+                if (!elemCtx.problem().recycleFirstIterationStorage()) {
+                    // we re-calculate the storage term for the solution of the
+                    // previous time step from scratch instead of using the one of
+                    // the first iteration of the current time step.
+                    tmp2 = 0.0;
+                    elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/1);
+                    asImp_().computeStorage(tmp2, elemCtx,  dofIdx, /*timeIdx=*/1);
                 }
                 else {
-                    // if the mass storage at the beginning of the time step is not cached,
-                    // if the storage term is cached and we're not looking at the first
-                    // iteration of the time step, we take the cached data.
-                    tmp2 = model.cachedStorage(globalDofIdx, /*timeIdx=*/1);
-                    Valgrind::CheckDefined(tmp2);
+                    // if the storage term is cached and we're in the first iteration
+                    // of the time step, use the storage term of the first iteration
+                    // as the one as the solution of the last time step (this assumes
+                    // that the initial guess for the solution at the end of the time
+                    // step is the same as the solution at the beginning of the time
+                    // step. This is usually true, but some fancy preprocessing
+                    // scheme might invalidate that assumption.)
+                    for (unsigned eqIdx = 0; eqIdx < numEq; ++ eqIdx)
+                        tmp2[eqIdx] = Toolbox::value(tmp[eqIdx]);
                 }
+
+                Valgrind::CheckDefined(tmp2);
+
+                model.updateCachedStorage(globalDofIdx, /*timeIdx=*/1, tmp2);
             }
             else {
                 // if the mass storage at the beginning of the time step is not cached,
-                // we re-calculate it from scratch.
-                tmp2 = 0.0;
-                asImp_().computeStorage(tmp2, elemCtx,  dofIdx, /*timeIdx=*/1);
+                // if the storage term is cached and we're not looking at the first
+                // iteration of the time step, we take the cached data.
+                tmp2 = model.cachedStorage(globalDofIdx, /*timeIdx=*/1);
                 Valgrind::CheckDefined(tmp2);
             }
+        }
+        else {
+            // if the mass storage at the beginning of the time step is not cached,
+            // we re-calculate it from scratch.
+            tmp2 = 0.0;
+            asImp_().computeStorage(tmp2, elemCtx,  dofIdx, /*timeIdx=*/1);
+            Valgrind::CheckDefined(tmp2);
+        }
 
-            // Use the implicit Euler time discretization
-            for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx) {
-                double dt = elemCtx.simulator().timeStepSize();
-                assert(dt > 0);
-                tmp[eqIdx] -= tmp2[eqIdx];
-                tmp[eqIdx] *= scvVolume / dt;
+        // Use the implicit Euler time discretization
+        for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx) {
+            double dt = elemCtx.simulator().timeStepSize();
+            assert(dt > 0);
+            tmp[eqIdx] -= tmp2[eqIdx];
+            tmp[eqIdx] *= scvVolume / dt;
 
-                residual[dofIdx][eqIdx] += tmp[eqIdx];
-            }
+            residual[dofIdx][eqIdx] += tmp[eqIdx];
+        }
 
-            Valgrind::CheckDefined(residual[dofIdx]);
+        Valgrind::CheckDefined(residual[dofIdx]);
 
-            // deal with the source term
-            asImp_().computeSource(sourceRate, elemCtx, dofIdx, /*timeIdx=*/0);
+        // deal with the source term
+        asImp_().computeSource(sourceRate, elemCtx, dofIdx, /*timeIdx=*/0);
 
-            // if the model uses extensive quantities in its storage term, and we use
-            // automatic differention and current DOF is also not the one we currently
-            // focus on, the storage term does not need any derivatives!
-            if (!extensiveStorageTerm &&
-                !std::is_same<Scalar, Evaluation>::value &&
-                dofIdx != elemCtx.focusDofIndex())
-            {
-                for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
-                    residual[dofIdx][eqIdx] -= scalarValue(sourceRate[eqIdx])*scvVolume;
-            }
-            else {
-                for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx) {
-                    sourceRate[eqIdx] *= scvVolume;
-                    residual[dofIdx][eqIdx] -= sourceRate[eqIdx];
-                }
+        // if the model uses extensive quantities in its storage term, and we use
+        // automatic differention and current DOF is also not the one we currently
+        // focus on, the storage term does not need any derivatives!
+        if (!extensiveStorageTerm &&
+            !std::is_same<Scalar, Evaluation>::value &&
+            dofIdx != elemCtx.focusDofIndex())
+        {
+            for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
+                residual[dofIdx][eqIdx] -= scalarValue(sourceRate[eqIdx])*scvVolume;
+        }
+        else {
+            for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx) {
+                sourceRate[eqIdx] *= scvVolume;
+                residual[dofIdx][eqIdx] -= sourceRate[eqIdx];
             }
-
-            Valgrind::CheckDefined(residual[dofIdx]);
         }
 
-#if !defined NDEBUG
-        // in debug mode, ensure that the residual is well-defined
+        Valgrind::CheckDefined(residual[dofIdx]);
+    }
+
+    /*!
+     * \brief Make the residual volume specific, i.e., convert it from total mass to
+     *        mass per cubic meter.
+     */
+    void makeVolumetric_(LocalEvalBlockVector& residual,
+                         const ElementContext& elemCtx) const
+    {
         size_t numDof = elemCtx.numDof(/*timeIdx=*/0);
-        for (unsigned i=0; i < numDof; i++) {
-            for (unsigned j = 0; j < numEq; ++ j) {
-                assert(isfinite(residual[i][j]));
-                Valgrind::CheckDefined(residual[i][j]);
+        for (unsigned dofIdx=0; dofIdx < numDof; ++dofIdx) {
+            if (elemCtx.dofTotalVolume(dofIdx, /*timeIdx=*/0) > 0.0) {
+                // interior DOF
+                Scalar dofVolume = elemCtx.dofTotalVolume(dofIdx, /*timeIdx=*/0);
+
+                assert(std::isfinite(dofVolume));
+                Valgrind::CheckDefined(dofVolume);
+
+                for (unsigned eqIdx = 0; eqIdx < numEq; ++ eqIdx)
+                    residual[dofIdx][eqIdx] /= dofVolume;
             }
         }
-#endif
     }
 
+    static bool isContained_(const std::vector<unsigned>& dofIndices, unsigned dofIdx)
+    { return std::find(dofIndices.begin(), dofIndices.end(), dofIdx) != dofIndices.end(); }
+
 
 private:
     Implementation& asImp_()
@@ -29,15 +29,36 @@
 #define EWOMS_FV_BASE_NEWTON_CONVERGENCE_WRITER_HH
 
 #include <opm/models/io/vtkmultiwriter.hh>
+#include <opm/models/parallel/mpiutil.hh>
+#include <opm/models/utils/parametersystem.hh>
 #include <opm/models/utils/propertysystem.hh>
 
+#include <dune/common/fvector.hh>
+#include <dune/grid/common/gridenums.hh>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
 
 //! \cond SKIP_THIS
 namespace Opm::Properties {
 
 // forward declaration of the required property tags
 template<class TypeTag, class MyTypeTag>
+struct Scalar;
+template<class TypeTag, class MyTypeTag>
+struct NumEq;
+template<class TypeTag, class MyTypeTag>
+struct ElementContext;
+template<class TypeTag, class MyTypeTag>
 struct SolutionVector;
 template<class TypeTag, class MyTypeTag>
 struct GlobalEqVector;
@@ -45,6 +66,12 @@ template<class TypeTag, class MyTypeTag>
 struct NewtonMethod;
 template<class TypeTag, class MyTypeTag>
 struct VtkOutputFormat;
+template<class TypeTag, class MyTypeTag>
+struct NewtonConvergenceHistory;
+template<class TypeTag, class MyTypeTag>
+struct NewtonConvergenceNumWorstCells;
+template<class TypeTag, class MyTypeTag>
+struct NewtonConvergenceBoundingBox;
 
 } // namespace Opm::Properties
 //! \endcond
@@ -55,11 +82,22 @@ namespace Opm {
  *
  * \brief Writes the intermediate solutions during the Newton scheme
  *        for models using a finite volume discretization
+ *
+ * By default, the primary variables, the update and the residual of all degrees of
+ * freedom are written to a VTK file for each iteration. Since this is not feasible for
+ * large grids, the writer can alternatively record a convergence history: For each
+ * iteration, one line is appended to a JSON lines file which contains the norms of the
+ * weighted residual of each equation, the degrees of freedom which exhibit the largest
+ * weighted residual and histograms of the magnitude of the weighted update of each
+ * primary variable. All of these are reduced over the processes. Optionally, the
+ * values of the degrees of freedom within a bounding box are included.
  */
 template <class TypeTag>
 class FvBaseNewtonConvergenceWriter
 {
+    using Scalar = GetPropType<TypeTag, Properties::Scalar>;
     using GridView = GetPropType<TypeTag, Properties::GridView>;
+    using ElementContext = GetPropType<TypeTag, Properties::ElementContext>;
 
     using SolutionVector = GetPropType<TypeTag, Properties::SolutionVector>;
     using GlobalEqVector = GetPropType<TypeTag, Properties::GlobalEqVector>;
@@ -68,6 +106,16 @@ class FvBaseNewtonConvergenceWriter
     static const int vtkFormat = getPropValue<TypeTag, Properties::VtkOutputFormat>();
     using VtkMultiWriter = ::Opm::VtkMultiWriter<GridView, vtkFormat>;
 
+    enum { numEq = getPropValue<TypeTag, Properties::NumEq>() };
+    enum { dimWorld = GridView::dimensionworld };
+    using GlobalPosition = Dune::FieldVector<double, dimWorld>;
+
+    // the histograms of the weighted updates have one bin for each decade between
+    // these exponents plus one bin for the smaller and one for the larger values
+    static constexpr int minUpdateExponent = -10;
+    static constexpr int maxUpdateExponent = 0;
+    static constexpr int numHistogramBins = maxUpdateExponent - minUpdateExponent + 2;
+
 public:
     FvBaseNewtonConvergenceWriter(NewtonMethod& nm)
         : newtonMethod_(nm)
@@ -75,11 +123,34 @@ public:
         timeStepIdx_ = 0;
         iteration_ = 0;
         vtkMultiWriter_ = 0;
+
+        enableHistory_ = EWOMS_GET_PARAM(TypeTag, bool, NewtonConvergenceHistory);
+        numWorstCells_ = std::max(0, EWOMS_GET_PARAM(TypeTag, int, NewtonConvergenceNumWorstCells));
+        parseBoundingBox_(EWOMS_GET_PARAM(TypeTag, std::string, NewtonConvergenceBoundingBox));
     }
 
     ~FvBaseNewtonConvergenceWriter()
     { delete vtkMultiWriter_; }
 
+    /*!
+     * \brief Register all run-time parameters of the convergence writer.
+     */
+    static void registerParameters()
+    {
+        EWOMS_REGISTER_PARAM(TypeTag, bool, NewtonConvergenceHistory,
+                             "Write a compact history of the residual and update "
+                             "statistics instead of VTK files if the convergence of "
+                             "the Newton method is written");
+        EWOMS_REGISTER_PARAM(TypeTag, int, NewtonConvergenceNumWorstCells,
+                             "The number of degrees of freedom with the largest "
+                             "weighted residual recorded by the convergence history");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, NewtonConvergenceBoundingBox,
+                             "The lower left and upper right corners of a box, given "
+                             "as comma separated coordinates, whose degrees of freedom "
+                             "are fully recorded by the convergence history. Empty means "
+                             "no box");
+    }
+
     /*!
      * \brief Called by the Newton method before the actual algorithm
      *        is started for any given timestep.
@@ -97,6 +168,9 @@ public:
     void beginIteration()
     {
         ++ iteration_;
+        if (enableHistory_)
+            return;
+
         if (!vtkMultiWriter_)
             vtkMultiWriter_ =
                 new VtkMultiWriter(/*async=*/false,
@@ -118,6 +192,11 @@ public:
     void writeFields(const SolutionVector& uLastIter,
                      const GlobalEqVector& deltaU)
     {
+        if (enableHistory_) {
+            writeHistory_(uLastIter, deltaU);
+            return;
+        }
+
         try {
             newtonMethod_.problem().model().addConvergenceVtkFields(*vtkMultiWriter_,
                                                                     uLastIter,
@@ -135,7 +214,12 @@ public:
      *        Newton algorithm has been completed.
      */
     void endIteration()
-    { vtkMultiWriter_->endWrite(); }
+    {
+        if (enableHistory_)
+            return;
+
+        vtkMultiWriter_->endWrite();
+    }
 
     /*!
      * \brief Called by the Newton method after Newton algorithm
@@ -145,13 +229,259 @@ public:
      * converged or not.
      */
     void endTimeStep()
-    { iteration_ = 0; }
+    {
+        iteration_ = 0;
+        if (historyFile_)
+            historyFile_->flush();
+    }
 
 private:
+    void writeHistory_(const SolutionVector& uLastIter,
+                       const GlobalEqVector& deltaU)
+    {
+        const auto& problem = newtonMethod_.problem();
+        const auto& model = problem.model();
+        const auto& residual = model.linearizer().residual();
+        const auto& comm = problem.gridView().comm();
+        const std::size_t numGridDof = model.numGridDof();
+
+        if (dofPositions_.size() != numGridDof)
+            updateDofPositions_();
+
+        // compute the statistics of the local process. degrees of freedom on the
+        // process boundaries of vertex-centered discretizations are considered by
+        // all adjacent processes.
+        std::array<double, numEq> sumSquaredResid{};
+        std::array<double, numEq> maxResid{};
+        std::vector<long> histograms(numEq*numHistogramBins, 0);
+        std::vector<std::tuple<double, unsigned, unsigned>> dofErrors;
+        std::ostringstream localData;
+        localData.precision(10);
+        localData << "R\n";
+        for (unsigned dofIdx = 0; dofIdx < numGridDof; ++dofIdx) {
+            if (!model.isLocalDof(dofIdx))
+                continue;
+
+            double dofError = -1.0;
+            unsigned worstEqIdx = 0;
+            for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx) {
+                const double r =
+                    std::abs(static_cast<double>(residual[dofIdx][eqIdx]*model.eqWeight(dofIdx, eqIdx)));
+                sumSquaredResid[eqIdx] += r*r;
+                maxResid[eqIdx] = std::max(maxResid[eqIdx], r);
+                if (r > dofError) {
+                    dofError = r;
+                    worstEqIdx = eqIdx;
+                }
+            }
+            dofErrors.emplace_back(dofError, dofIdx, worstEqIdx);
+
+            for (unsigned pvIdx = 0; pvIdx < numEq; ++pvIdx) {
+                const double du =
+                    std::abs(static_cast<double>(deltaU[dofIdx][pvIdx]*model.primaryVarWeight(dofIdx, pvIdx)));
+                ++histograms[pvIdx*numHistogramBins + histogramBin_(du)];
+            }
+
+            if (!boundingBox_.empty() && inBoundingBox_(dofPositions_[dofIdx])) {
+                localData << "C\t{\"rank\":" << comm.rank()
+                          << ",\"dof\":" << dofIdx
+                          << ",\"pos\":" << positionJson_(dofPositions_[dofIdx])
+                          << ",\"priVars\":" << blockJson_(uLastIter[dofIdx])
+                          << ",\"update\":" << blockJson_(deltaU[dofIdx])
+                          << ",\"residual\":" << blockJson_(residual[dofIdx])
+                          << "}\n";
+            }
+        }
+
+        // only the worst degrees of freedom of each process can be amongst the
+        // globally worst ones
+        const std::size_t numWorst = std::min<std::size_t>(numWorstCells_, dofErrors.size());
+        std::partial_sort(dofErrors.begin(), dofErrors.begin() + numWorst, dofErrors.end(),
+                          [](const auto& a, const auto& b)
+                          { return std::get<0>(a) > std::get<0>(b); });
+        for (std::size_t i = 0; i < numWorst; ++i) {
+            const auto& [error, dofIdx, eqIdx] = dofErrors[i];
+            localData << "W\t" << error
+                      << "\t{\"rank\":" << comm.rank()
+                      << ",\"dof\":" << dofIdx
+                      << ",\"pos\":" << positionJson_(dofPositions_[dofIdx])
+                      << ",\"eq\":\"" << model.eqName(eqIdx) << "\""
+                      << ",\"error\":" << error
+                      << "}\n";
+        }
+
+        // reduce the statistics over all processes
+        comm.sum(sumSquaredResid.data(), numEq);
+        comm.max(maxResid.data(), numEq);
+        comm.sum(histograms.data(), static_cast<int>(histograms.size()));
+        const auto allProcesses = gatherStrings(localData.str());
+        if (comm.rank() != 0)
+            return;
+
+        std::vector<std::pair<double, std::string>> worstDofs;
+        std::vector<std::string> boxDofs;
+        for (const auto& processData : allProcesses) {
+            std::istringstream iss(processData);
+            std::string line;
+            while (std::getline(iss, line)) {
+                if (line.compare(0, 2, "W\t") == 0) {
+                    const auto sepPos = line.find('\t', 2);
+                    worstDofs.emplace_back(std::stod(line.substr(2, sepPos - 2)),
+                                           line.substr(sepPos + 1));
+                }
+                else if (line.compare(0, 2, "C\t") == 0)
+                    boxDofs.push_back(line.substr(2));
+            }
+        }
+        std::stable_sort(worstDofs.begin(), worstDofs.end(),
+                         [](const auto& a, const auto& b)
+                         { return a.first > b.first; });
+        worstDofs.resize(std::min<std::size_t>(numWorstCells_, worstDofs.size()));
+
+        if (!historyFile_)
+            openHistoryFile_();
+
+        auto& os = *historyFile_;
+        os << "{\"timeStep\":" << timeStepIdx_
+           << ",\"iteration\":" << iteration_
+           << ",\"time\":" << problem.simulator().time()
+           << ",\"residual\":{";
+        for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx) {
+            os << (eqIdx > 0 ? "," : "")
+               << "\"" << model.eqName(eqIdx) << "\":{\"l2\":" << std::sqrt(sumSquaredResid[eqIdx])
+               << ",\"max\":" << maxResid[eqIdx] << "}";
+        }
+        os << "},\"worstDofs\":[";
+        for (std::size_t i = 0; i < worstDofs.size(); ++i)
+            os << (i > 0 ? "," : "") << worstDofs[i].second;
+        os << "],\"updateHistograms\":{";
+        for (unsigned pvIdx = 0; pvIdx < numEq; ++pvIdx) {
+            os << (pvIdx > 0 ? "," : "") << "\"" << model.primaryVarName(pvIdx) << "\":[";
+            for (int binIdx = 0; binIdx < numHistogramBins; ++binIdx)
+                os << (binIdx > 0 ? "," : "") << histograms[pvIdx*numHistogramBins + binIdx];
+            os << "]";
+        }
+        os << "}";
+        if (!boundingBox_.empty()) {
+            os << ",\"boxDofs\":[";
+            for (std::size_t i = 0; i < boxDofs.size(); ++i)
+                os << (i > 0 ? "," : "") << boxDofs[i];
+            os << "]";
+        }
+        os << "}\n";
+    }
+
+    void openHistoryFile_()
+    {
+        const auto& problem = newtonMethod_.problem();
+        const std::string fileName = problem.outputDir() + "/" + problem.name() + ".convergence.jsonl";
+        historyFile_ = std::make_unique<std::ofstream>(fileName);
+        if (!*historyFile_)
+            throw std::runtime_error("Could not open the convergence history file '" + fileName + "'");
+        historyFile_->precision(10);
+
+        // the first line describes the bins of the histograms
+        *historyFile_ << "{\"updateHistogramEdges\":[";
+        for (int exponent = minUpdateExponent; exponent <= maxUpdateExponent; ++exponent)
+            *historyFile_ << (exponent > minUpdateExponent ? "," : "") << std::pow(10.0, exponent);
+        *historyFile_ << "]}\n";
+    }
+
+    // the histogram bin of the magnitude of a weighted update
+    static int histogramBin_(double value)
+    {
+        if (!(value >= std::pow(10.0, minUpdateExponent)))
+            return 0;
+
+        const int binIdx = static_cast<int>(std::floor(std::log10(value))) - minUpdateExponent + 1;
+        return std::min(binIdx, numHistogramBins - 1);
+    }
+
+    void updateDofPositions_()
+    {
+        const auto& problem = newtonMethod_.problem();
+        dofPositions_.resize(problem.model().numGridDof());
+
+        ElementContext elemCtx(problem.simulator());
+        for (const auto& elem : elements(problem.gridView())) {
+            if (elem.partitionType() != Dune::InteriorEntity)
+                continue;
+
+            elemCtx.updateStencil(elem);
+            for (unsigned dofIdx = 0; dofIdx < elemCtx.numPrimaryDof(/*timeIdx=*/0); ++dofIdx) {
+                const unsigned globalIdx = elemCtx.globalSpaceIndex(dofIdx, /*timeIdx=*/0);
+                const auto& pos = elemCtx.pos(dofIdx, /*timeIdx=*/0);
+                for (unsigned i = 0; i < dimWorld; ++i)
+                    dofPositions_[globalIdx][i] = static_cast<double>(pos[i]);
+            }
+        }
+    }
+
+    void parseBoundingBox_(const std::string& spec)
+    {
+        if (spec.empty())
+            return;
+
+        std::string tmp(spec);
+        std::replace(tmp.begin(), tmp.end(), ',', ' ');
+        std::istringstream iss(tmp);
+        std::vector<double> coords;
+        double value;
+        while (iss >> value)
+            coords.push_back(value);
+        if (!iss.eof() || coords.size() != 2*dimWorld)
+            throw std::invalid_argument("The bounding box of the convergence history must be "
+                                        "specified by "+std::to_string(2*dimWorld)+" coordinates, "
+                                        "got '"+spec+"'");
+
+        boundingBox_.resize(2);
+        for (unsigned i = 0; i < dimWorld; ++i) {
+            boundingBox_[0][i] = coords[i];
+            boundingBox_[1][i] = coords[dimWorld + i];
+        }
+    }
+
+    bool inBoundingBox_(const GlobalPosition& pos) const
+    {
+        for (unsigned i = 0; i < dimWorld; ++i)
+            if (pos[i] < boundingBox_[0][i] || pos[i] > boundingBox_[1][i])
+                return false;
+        return true;
+    }
+
+    static std::string positionJson_(const GlobalPosition& pos)
+    {
+        std::ostringstream oss;
+        oss.precision(10);
+        oss << "[";
+        for (unsigned i = 0; i < dimWorld; ++i)
+            oss << (i > 0 ? "," : "") << pos[i];
+        oss << "]";
+        return oss.str();
+    }
+
+    template <class Block>
+    static std::string blockJson_(const Block& block)
+    {
+        std::ostringstream oss;
+        oss.precision(10);
+        oss << "[";
+        for (unsigned i = 0; i < block.size(); ++i)
+            oss << (i > 0 ? "," : "") << static_cast<double>(block[i]);
+        oss << "]";
+        return oss.str();
+    }
+
     int timeStepIdx_;
     int iteration_;
     VtkMultiWriter *vtkMultiWriter_;
     NewtonMethod& newtonMethod_;
+
+    bool enableHistory_;
+    int numWorstCells_;
+    std::vector<GlobalPosition> boundingBox_;
+    std::vector<GlobalPosition> dofPositions_;
+    std::unique_ptr<std::ofstream> historyFile_;
 };
 
 } // namespace Opm
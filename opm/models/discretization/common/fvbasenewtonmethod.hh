@@ -67,6 +67,15 @@ template<class TypeTag>
 struct NewtonConvergenceWriter<TypeTag, TTag::FvBaseNewtonMethod>
 { using type = FvBaseNewtonConvergenceWriter<TypeTag>; };
 
+template<class TypeTag>
+struct NewtonConvergenceHistory<TypeTag, TTag::FvBaseNewtonMethod> { static constexpr bool value = false; };
+
+template<class TypeTag>
+struct NewtonConvergenceNumWorstCells<TypeTag, TTag::FvBaseNewtonMethod> { static constexpr int value = 10; };
+
+template<class TypeTag>
+struct NewtonConvergenceBoundingBox<TypeTag, TTag::FvBaseNewtonMethod> { static constexpr auto value = ""; };
+
 } // namespace Opm::Properties
 
 namespace Opm {
@@ -100,6 +109,16 @@ public:
         : ParentType(simulator)
     { }
 
+    /*!
+     * \brief Register all run-time parameters for the Newton method.
+     */
+    static void registerParameters()
+    {
+        ParentType::registerParameters();
+
+        FvBaseNewtonConvergenceWriter<TypeTag>::registerParameters();
+    }
+
 protected:
     friend class NewtonMethod<TypeTag>;
 
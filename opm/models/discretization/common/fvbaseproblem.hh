@@ -33,6 +33,9 @@
 #include <opm/models/io/vtkmultiwriter.hh>
 #include <opm/models/io/restart.hh>
 #include <opm/models/discretization/common/restrictprolong.hh>
+#include <opm/models/nonlinear/newtonmethodproperties.hh>
+#include <opm/models/utils/pidtimestepcontrol.hh>
+#include <opm/models/utils/profiler.hh>
 
 #include <dune/common/fvector.hh>
 
@@ -42,13 +45,6 @@
 
 #include <sys/stat.h>
 
-namespace Opm::Properties {
-
-template <class TypeTag, class MyTypeTag>
-struct NewtonMethod;
-
-} // namespace Opm::Properties
-
 namespace Opm {
 
 /*!
@@ -59,6 +55,15 @@ namespace Opm {
  * \note All quantities are specified assuming a threedimensional world. Problems
  *       discretized using 2D grids are assumed to be extruded by \f$1 m\f$ and 1D grids
  *       are assumed to have a cross section of \f$1m \times 1m\f$.
+ *
+ * \note The linearizers evaluate the elements concurrently if multiple threads are
+ *       used. The const methods of the problem which they call, e.g., source(),
+ *       boundary() and the methods which return the properties of the porous medium,
+ *       must therefore be safe to be called by several threads at the same time. The
+ *       cell-based boundary conditions used by the TPFA linearizer
+ *       (boundaryCondition() and boundaryFluidState() of the problem) are exempt from
+ *       this: They are only evaluated by a single thread outside of the parallel
+ *       regions of the linearizer.
  */
 template<class TypeTag>
 class FvBaseProblem
@@ -121,6 +126,7 @@ public:
         , boundingBoxMax_(-std::numeric_limits<double>::max())
         , simulator_(simulator)
         , defaultVtkWriter_(0)
+        , pidTimeStepControl_(EWOMS_GET_PARAM(TypeTag, Scalar, TimeStepControlTolerance))
     {
         // calculate the bounding box of the local partition of the grid view
         VertexIterator vIt = gridView_.template begin<dim>();
@@ -156,6 +162,13 @@ public:
             defaultVtkWriter_ =
                 new VtkMultiWriter(asyncVtkOutput, gridView_, outputDir, asImp_().name());
         }
+
+        const std::string timeStepControl = EWOMS_GET_PARAM(TypeTag, std::string, TimeStepControl);
+        if (timeStepControl == "pid")
+            usePidTimeStepControl_ = true;
+        else if (timeStepControl != "iterationcount")
+            throw std::invalid_argument("Unknown time step control '"+timeStepControl+"'. "
+                                        "Valid values are 'iterationcount' and 'pid'");
     }
 
     ~FvBaseProblem()
@@ -181,6 +194,15 @@ public:
                              "Continue with a non-converged solution instead of giving up "
                              "if we encounter a time step size smaller than the minimum time "
                              "step size.");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, TimeStepControl,
+                             "The algorithm used to determine the size of the time steps. "
+                             "Possible values: 'iterationcount', 'pid'");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, TimeStepControlTolerance,
+                             "The relative change of the solution per time step aimed at by "
+                             "the 'pid' time step control");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableStartOfStepStateReuse,
+                             "Keep the intensive quantities of the beginning of a time step "
+                             "instead of recalculating them if the time step must be repeated");
     }
 
     /*!
@@ -466,6 +488,7 @@ public:
 
         Scalar executionTime = executionTimer.realTimeElapsed();
         Scalar setupTime = simulator().setupTimer().realTimeElapsed();
+        Scalar vanguardTime = simulator().vanguardTimer().realTimeElapsed();
         Scalar prePostProcessTime = simulator().prePostProcessTimer().realTimeElapsed();
         Scalar localCpuTime = executionTimer.cpuTimeElapsed();
         Scalar globalCpuTime = executionTimer.globalCpuTimeElapsed();
@@ -473,6 +496,7 @@ public:
         Scalar linearizeTime = simulator().linearizeTimer().realTimeElapsed();
         Scalar solveTime = simulator().solveTimer().realTimeElapsed();
         Scalar updateTime = simulator().updateTimer().realTimeElapsed();
+        Scalar adaptTime = simulator().adaptTimer().realTimeElapsed();
         unsigned numProcesses = static_cast<unsigned>(this->gridView().comm().size());
         unsigned threadsPerProcess = ThreadManager::maxThreads();
         if (gridView().comm().rank() == 0) {
@@ -482,6 +506,8 @@ public:
                       << "------------------------ Timing ------------------------\n"
                       << "Setup time: " << setupTime << " seconds" << Simulator::humanReadableTime(setupTime)
                       << ", " << setupTime/(executionTime + setupTime)*100 << "%\n"
+                      << "    Grid creation and distribution time: " << vanguardTime << " seconds" << Simulator::humanReadableTime(vanguardTime)
+                      << ", " << vanguardTime/setupTime*100 << "%\n"
                       << "Simulation time: " << executionTime << " seconds" << Simulator::humanReadableTime(executionTime)
                       << ", " << executionTime/(executionTime + setupTime)*100 << "%\n"
                       << "    Linearization time: " << linearizeTime << " seconds" << Simulator::humanReadableTime(linearizeTime)
@@ -490,10 +516,15 @@ public:
                       << ", " << solveTime/executionTime*100 << "%\n"
                       << "    Newton update time: "  << updateTime << " seconds" << Simulator::humanReadableTime(updateTime)
                       << ", " << updateTime/executionTime*100 << "%\n"
+                      << "    Grid adaptation time: "  << adaptTime << " seconds" << Simulator::humanReadableTime(adaptTime)
+                      << ", " << adaptTime/executionTime*100 << "%\n"
                       << "    Pre/postprocess time: "  << prePostProcessTime << " seconds" << Simulator::humanReadableTime(prePostProcessTime)
                       << ", " << prePostProcessTime/executionTime*100 << "%\n"
                       << "    Output write time: "  << writeTime << " seconds" << Simulator::humanReadableTime(writeTime)
                       << ", " << writeTime/executionTime*100 << "%\n"
+                      << "    Time spent on failed time steps: " << failedTimeStepsTime_ << " seconds" << Simulator::humanReadableTime(failedTimeStepsTime_)
+                      << ", " << failedTimeStepsTime_/executionTime*100 << "%"
+                      << " (" << numFailedTimeSteps_ << " failures, " << numFailedNewtonIterations_ << " Newton iterations)\n"
                       << "First process' simulation CPU time: "  << localCpuTime << " seconds" <<  Simulator::humanReadableTime(localCpuTime) << "\n"
                       << "Number of processes: " << numProcesses << "\n"
                       << "Threads per processes: " << threadsPerProcess << "\n"
@@ -513,14 +544,33 @@ public:
         unsigned maxFails = asImp_().maxTimeIntegrationFailures();
         Scalar minTimeStepSize = asImp_().minTimeStepSize();
 
+        // remember the state at the beginning of the time step so that it does not need
+        // to be recalculated if the time step needs to be repeated
+        if (EWOMS_GET_PARAM(TypeTag, bool, EnableStartOfStepStateReuse))
+            model().saveStartOfStepState();
+
         std::string errorMessage;
         for (unsigned i = 0; i < maxFails; ++i) {
             bool converged = model().update();
-            if (converged)
+            if (converged) {
+                if (usePidTimeStepControl_)
+                    pidTimeStepControl_.registerSolutionChange(relativeSolutionChange_());
                 return;
+            }
+
+            // the model's timers only cover the last invocation of the Newton method
+            Scalar wastedTime =
+                model().prePostProcessTimer().realTimeElapsed()
+                + model().linearizeTimer().realTimeElapsed()
+                + model().solveTimer().realTimeElapsed()
+                + model().updateTimer().realTimeElapsed();
+            int wastedIterations = newtonMethod().numLinearizations();
+            failedTimeStepsTime_ += wastedTime;
+            numFailedNewtonIterations_ += static_cast<unsigned>(wastedIterations);
+            ++numFailedTimeSteps_;
 
             Scalar dt = simulator().timeStepSize();
-            Scalar nextDt = dt / 2.0;
+            Scalar nextDt = asImp_().retryTimeStepSize(dt);
             if (dt < minTimeStepSize*(1 + 1e-9)) {
                 if (asImp_().continueOnConvergenceError()) {
                     if (gridView().comm().rank() == 0)
@@ -543,7 +593,9 @@ public:
             // update failed
             if (gridView().comm().rank() == 0)
                 std::cout << "Newton solver did not converge with "
-                          << "dt=" << dt << " seconds. Retrying with time step of "
+                          << "dt=" << dt << " seconds after " << wastedIterations
+                          << " iterations (" << wastedTime << " seconds wasted). "
+                          << "Retrying with time step of "
                           << nextDt << " seconds\n" << std::flush;
         }
 
@@ -555,6 +607,29 @@ public:
         throw std::runtime_error(errorMessage);
     }
 
+    /*!
+     * \brief Returns the time step size which should be used to repeat a time step after
+     *        the Newton method failed.
+     *
+     * By default, the time step size is halved. If the "pid" time step control is used,
+     * the size is estimated from the error reduction achieved by the failed attempt.
+     *
+     * \param failedDt The time step size for which the Newton method did not converge
+     */
+    Scalar retryTimeStepSize(Scalar failedDt) const
+    {
+        if (!usePidTimeStepControl_)
+            return failedDt / 2.0;
+
+        const auto& newton = newtonMethod();
+        return pidTimeStepControl_.suggestRetryTimeStepSize(failedDt,
+                                                            newton.initialError(),
+                                                            newton.error(),
+                                                            newton.tolerance(),
+                                                            newton.numLinearizations(),
+                                                            EWOMS_GET_PARAM(TypeTag, int, NewtonTargetIterations));
+    }
+
     /*!
      * \brief Returns the minimum allowable size of a time step.
      */
@@ -592,8 +667,13 @@ public:
         if (nextTimeStepSize_ > 0.0)
             return nextTimeStepSize_;
 
+        Scalar dt = simulator().timeStepSize();
+        Scalar suggestedDt =
+            usePidTimeStepControl_
+            ? std::max(asImp_().minTimeStepSize(), pidTimeStepControl_.suggestTimeStepSize(dt))
+            : newtonMethod().suggestTimeStepSize(dt);
         Scalar dtNext = std::min(EWOMS_GET_PARAM(TypeTag, Scalar, MaxTimeStepSize),
-                                 newtonMethod().suggestTimeStepSize(simulator().timeStepSize()));
+                                 suggestedDt);
 
         if (dtNext < simulator().maxTimeStepSize()
             && simulator().maxTimeStepSize() < dtNext*2)
@@ -785,6 +865,8 @@ public:
         if (!enableVtkOutput_())
             return;
 
+        EWOMS_PROFILE_SCOPE("output");
+
         if (verbose && gridView().comm().rank() == 0)
             std::cout << "Writing visualization results for the current time step.\n"
                       << std::flush;
@@ -813,6 +895,24 @@ private:
     bool enableVtkOutput_() const
     { return EWOMS_GET_PARAM(TypeTag, bool, EnableVtkOutput); }
 
+    // returns the maximum relative difference between the current solution and the one
+    // of the previous time step over all processes
+    Scalar relativeSolutionChange_() const
+    {
+        const auto& uCur = model().solution(/*timeIdx=*/0);
+        const auto& uPrev = model().solution(/*timeIdx=*/1);
+
+        Scalar result = 0.0;
+        size_t numGridDof = model().numGridDof();
+        for (unsigned dofIdx = 0; dofIdx < numGridDof; ++dofIdx) {
+            if (!model().isLocalDof(dofIdx))
+                continue;
+            result = std::max(result, model().relativeDofError(dofIdx, uPrev[dofIdx], uCur[dofIdx]));
+        }
+
+        return gridView().comm().max(result);
+    }
+
     //! Returns the implementation of the problem (i.e. static polymorphism)
     Implementation& asImp_()
     { return *static_cast<Implementation *>(this); }
@@ -831,6 +931,15 @@ private:
     // Attributes required for the actual simulation
     Simulator& simulator_;
     mutable VtkMultiWriter *defaultVtkWriter_;
+
+    // time step control
+    PidTimeStepControl<Scalar> pidTimeStepControl_;
+    bool usePidTimeStepControl_ = false;
+
+    // work spent on time steps that had to be repeated
+    Scalar failedTimeStepsTime_ = 0.0;
+    unsigned numFailedTimeSteps_ = 0;
+    unsigned numFailedNewtonIterations_ = 0;
 };
 
 } // namespace Opm
@@ -189,6 +189,11 @@ struct ThreadManager { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct ThreadsPerProcess { using type = UndefinedProperty; };
 
+//! Specifies how the threads of a process are bound to its CPUs ('none', 'compact' or
+//! 'spread')
+template<class TypeTag, class MyTypeTag>
+struct ThreadPinning { using type = UndefinedProperty; };
+
 //! use locking to prevent race conditions when linearizing the global system of
 //! equations in multi-threaded mode. (setting this property to true is always save, but
 //! it may slightly deter performance in multi-threaded simlations and some
@@ -207,12 +212,43 @@ struct UseLinearizationLock { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct EnableGridAdaptation { using type = UndefinedProperty; };
 
+/*!
+ * \brief Switch to enable or disable re-partitioning the grid at the end of episodes
+ *        based on the measured cost of linearizing the elements
+ *
+ * This requires a grid whose load balancer accepts weights for the elements, i.e.,
+ * dune-alugrid, and the absence of the dune-FEM module.
+ */
+template<class TypeTag, class MyTypeTag>
+struct EnableDynamicLoadBalancing { using type = UndefinedProperty; };
+
+/*!
+ * \brief The ratio between the maximum and the average cost of the processes above which
+ *        the grid is re-partitioned
+ */
+template<class TypeTag, class MyTypeTag>
+struct LoadImbalanceTolerance { using type = UndefinedProperty; };
+
+/*!
+ * \brief Measure the time needed to linearize each element every N-th linearization
+ */
+template<class TypeTag, class MyTypeTag>
+struct LinearizationCostSamplingInterval { using type = UndefinedProperty; };
+
 /*!
  * \brief The directory to which simulation output ought to be written to.
  */
 template<class TypeTag, class MyTypeTag>
 struct OutputDir { using type = UndefinedProperty; };
 
+/*!
+ * \brief The directory in which the results of expensive preprocessing steps are cached.
+ *
+ * An empty string disables the cache.
+ */
+template<class TypeTag, class MyTypeTag>
+struct PreprocessingCacheDir { using type = UndefinedProperty; };
+
 /*!
  * \brief Global switch to enable or disable the writing of VTK output files
  *
@@ -281,6 +317,38 @@ struct MaxTimeStepDivisions { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct ContinueOnConvergenceError { using type = UndefinedProperty; };
 
+/*!
+ * \brief The algorithm which is used to determine the size of the time steps.
+ *
+ * Possible values are:
+ *   - "iterationcount" (default): scale the time step size by the deviation of the
+ *     number of Newton iterations from the target number and halve it if the Newton
+ *     method fails
+ *   - "pid": use a PID controller based on the relative change of the solution and
+ *     estimate the size of the retried time step from the Newton error reduction
+ */
+template<class TypeTag, class MyTypeTag>
+struct TimeStepControl { using type = UndefinedProperty; };
+
+/*!
+ * \brief The relative change of the solution per time step at which the "pid" time step
+ *        control aims at.
+ */
+template<class TypeTag, class MyTypeTag>
+struct TimeStepControlTolerance { using type = UndefinedProperty; };
+
+/*!
+ * \brief Keep the intensive quantities of the beginning of a time step around so that
+ *        they do not need to be recalculated if the time step must be repeated.
+ *
+ * The intensive quantities are taken from the cache of the previous time index, which
+ * holds the state at the beginning of the time step anyway, so no additional memory is
+ * required. This has only an effect if the intensive quantity cache is enabled and if
+ * it is not kept at its old state because the storage term is recycled.
+ */
+template<class TypeTag, class MyTypeTag>
+struct EnableStartOfStepStateReuse { using type = UndefinedProperty; };
+
 /*!
  * \brief Specify whether all intensive quantities for the grid should be
  *        cached in the discretization.
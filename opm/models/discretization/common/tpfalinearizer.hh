@@ -40,11 +40,14 @@
 #include <opm/input/eclipse/Schedule/BCProp.hpp>
 
 #include <opm/models/discretization/common/baseauxiliarymodule.hh>
+#include <opm/models/utils/profiler.hh>
 
 #include <dune/common/version.hh>
 #include <dune/common/fvector.hh>
 #include <dune/common/fmatrix.hh>
 
+#include <algorithm>
+#include <chrono>
 #include <type_traits>
 #include <iostream>
 #include <vector>
@@ -117,6 +120,9 @@ class TpfaLinearizer
 //! \endcond
 
 public:
+    //! Subdomains are specified by the list of their cells, see linearizeDomain()
+    static constexpr bool linearizesCellSubDomains = true;
+
     TpfaLinearizer()
         : jacobian_()
     {
@@ -135,6 +141,9 @@ public:
     {
         EWOMS_REGISTER_PARAM(TypeTag, bool, SeparateSparseSourceTerms,
                              "Treat well source terms all in one go, instead of on a cell by cell basis.");
+        EWOMS_REGISTER_PARAM(TypeTag, unsigned, LinearizationCostSamplingInterval,
+                             "Measure the time needed to linearize each element every N-th "
+                             "linearization if dynamic load balancing is enabled");
     }
 
     /*!
@@ -150,6 +159,13 @@ public:
     {
         simulatorPtr_ = &simulator;
         eraseMatrix();
+
+        costSamplingInterval_ = 0;
+        if (EWOMS_GET_PARAM(TypeTag, bool, EnableDynamicLoadBalancing))
+            costSamplingInterval_ = EWOMS_GET_PARAM(TypeTag, unsigned, LinearizationCostSamplingInterval);
+        elementCost_.clear();
+        if (costSamplingInterval_ > 0)
+            elementCost_.resize(static_cast<std::size_t>(simulator.gridView().size(/*codim=*/0)), 0.0);
     }
 
     /*!
@@ -164,6 +180,17 @@ public:
         jacobian_.reset();
     }
 
+    /*!
+     * \brief Returns the measured wall clock time in seconds which is needed to
+     *        linearize each cell.
+     *
+     * The vector is indexed by the cell. It is only filled if dynamic load balancing is
+     * enabled. Cells which have not been sampled yet exhibit a cost of zero. The cost of
+     * the well source terms is not included if they are treated separately.
+     */
+    const std::vector<Scalar>& elementCosts() const
+    { return elementCost_; }
+
     /*!
      * \brief Linearize the full system of non-linear equations.
      *
@@ -208,6 +235,7 @@ public:
     void linearizeDomain(const SubDomainType& domain)
     {
         OPM_TIMEBLOCK(linearizeDomain);
+        const bool onFullDomain = (domain.cells.size() == model_().numTotalDof());
         // we defer the initialization of the Jacobian matrix until here because the
         // auxiliary modules usually assume the problem, model and grid to be fully
         // initialized...
@@ -215,7 +243,7 @@ public:
             initFirstIteration_();
 
         // Called here because it is no longer called from linearize_().
-        if (domain.cells.size() == model_().numTotalDof()) {
+        if (onFullDomain) {
             // We are on the full domain.
             resetSystem_();
         } else {
@@ -241,7 +269,10 @@ public:
                       << "\n"  << std::flush;
             succeeded = 0;
         }
-        succeeded = simulator_().gridView().comm().min(succeeded);
+        // subdomains are linearized independently by each process, so we must not
+        // communicate in this case
+        if (onFullDomain)
+            succeeded = simulator_().gridView().comm().min(succeeded);
 
         if (!succeeded)
             throw NumericalProblem("A process did not succeed in linearizing the system");
@@ -334,6 +365,8 @@ public:
     }
 
     void updateBoundaryConditionData() {
+        // the problem's boundaryCondition() and boundaryFluidState() methods are not
+        // required to be thread safe, so the boundary conditions are evaluated serially
         for (auto& bdyInfo : boundaryInfo_) {
             const auto [type, massrateAD] = problem_().boundaryCondition(bdyInfo.cell, bdyInfo.dir);
 
@@ -472,6 +505,17 @@ private:
             }
         }
 
+        // group the boundary conditions by cell, so that they can be handled by the
+        // thread which linearizes the cell
+        std::stable_sort(boundaryInfo_.begin(), boundaryInfo_.end(),
+                         [](const BoundaryInfo& a, const BoundaryInfo& b)
+                         { return a.cell < b.cell; });
+        boundaryInfoOffset_.assign(numCells + 1, 0);
+        for (const auto& bdyInfo : boundaryInfo_)
+            ++boundaryInfoOffset_[bdyInfo.cell + 1];
+        std::partial_sum(boundaryInfoOffset_.begin(), boundaryInfoOffset_.end(),
+                         boundaryInfoOffset_.begin());
+
         // add the additional neighbors and degrees of freedom caused by the auxiliary
         // equations
         size_t numAuxMod = model.numAuxiliaryModules();
@@ -612,13 +656,25 @@ private:
         const bool& enableFlores = simulator_().problem().eclWriter()->eclOutputModule().hasFlores();
         const unsigned int numCells = domain.cells.size();
         const bool on_full_domain = (numCells == model_().numTotalDof());
+        ++linearizationIdx_;
 
+        // use a static schedule: the memory of the intensive quantity cache is
+        // distributed amongst the NUMA nodes using the same partition of the cells
 #ifdef _OPENMP
-#pragma omp parallel for
+#pragma omp parallel for schedule(static)
 #endif
         for (unsigned ii = 0; ii < numCells; ++ii) {
             OPM_TIMEBLOCK_LOCAL(linearizationForEachCell);
             const unsigned globI = domain.cells[ii];
+
+            // every cell is timed in one of costSamplingInterval_ linearizations, which
+            // keeps the overhead of reading the clock negligible
+            const bool sampleCost =
+                costSamplingInterval_ > 0 && (globI + linearizationIdx_) % costSamplingInterval_ == 0;
+            std::chrono::steady_clock::time_point startTime;
+            if (sampleCost)
+                startTime = std::chrono::steady_clock::now();
+
             const auto& nbInfos = neighborInfo_[globI];
             VectorBlock res(0.0);
             MatrixBlock bMat(0.0);
@@ -662,6 +718,7 @@ private:
                 *nbInfo.matBlockAddress += bMat;
                 ++loc;
             }
+            EWOMS_PROFILE_COUNT("flux evaluations", nbInfos.size());
             }
 
             // Accumulation term.
@@ -731,30 +788,39 @@ private:
             residual_[globI] += res;
             //SparseAdapter syntax: jacobian_->addToBlock(globI, globI, bMat);
             *diagMatAddress_[globI] += bMat;
+
+            // Boundary terms. The boundary conditions are grouped by cell, so only
+            // the thread which is responsible for the cell writes to its entries.
+            const unsigned bdyBegin = boundaryInfoOffset_[globI];
+            const unsigned bdyEnd = boundaryInfoOffset_[globI + 1];
+            for (unsigned bdyIdx = bdyBegin; bdyIdx < bdyEnd; ++bdyIdx) {
+                const auto& bdyInfo = boundaryInfo_[bdyIdx];
+                res = 0.0;
+                bMat = 0.0;
+                adres = 0.0;
+                LocalResidual::computeBoundaryFlux(adres, problem_(), bdyInfo.bcdata, intQuantsIn, globI);
+                adres *= bdyInfo.bcdata.faceArea;
+                setResAndJacobi(res, bMat, adres);
+                residual_[globI] += res;
+                //SparseAdapter syntax: jacobian_->addToBlock(globI, globI, bMat);
+                *diagMatAddress_[globI] += bMat;
+            }
+
+            if (sampleCost) {
+                const std::chrono::duration<Scalar> duration = std::chrono::steady_clock::now() - startTime;
+
+                // exponentially weighted average, so that moving fronts are followed
+                Scalar& cost = elementCost_[globI];
+                cost = (cost > 0.0) ? 0.5*(cost + duration.count()) : duration.count();
+            }
         } // end of loop for cell globI.
 
-        // Add sparse source terms. For now only wells.
+        // Add sparse source terms. For now only wells. The well model adds the
+        // contributions of all perforations to the global vectors at once, so this
+        // cannot be done by the threads which linearize the cells.
         if (separateSparseSourceTerms_) {
             problem_().wellModel().addReservoirSourceTerms(residual_, diagMatAddress_);
         }
-
-        // Boundary terms. Only looping over cells with nontrivial bcs.
-        for (const auto& bdyInfo : boundaryInfo_) {
-            VectorBlock res(0.0);
-            MatrixBlock bMat(0.0);
-            ADVectorBlock adres(0.0);
-            const unsigned globI = bdyInfo.cell;
-            const IntensiveQuantities* insideIntQuants = model_().cachedIntensiveQuantities(globI, /*timeIdx*/ 0);
-            if (insideIntQuants == nullptr) {
-                throw std::logic_error("Missing updated intensive quantities for cell " + std::to_string(globI));
-            }
-            LocalResidual::computeBoundaryFlux(adres, problem_(), bdyInfo.bcdata, *insideIntQuants, globI);
-            adres *= bdyInfo.bcdata.faceArea;
-            setResAndJacobi(res, bMat, adres);
-            residual_[globI] += res;
-            ////SparseAdapter syntax: jacobian_->addToBlock(globI, globI, bMat);
-            *diagMatAddress_[globI] += bMat;
-        }
     }
 
     void updateStoredTransmissibilities()
@@ -827,7 +893,16 @@ private:
         BoundaryConditionData bcdata;
     };
     std::vector<BoundaryInfo> boundaryInfo_;
+    // the boundary conditions of cell i are boundaryInfo_[boundaryInfoOffset_[i]] up
+    // to boundaryInfo_[boundaryInfoOffset_[i + 1] - 1]
+    std::vector<unsigned> boundaryInfoOffset_;
     bool separateSparseSourceTerms_ = false;
+
+    // the measured cost of linearizing the cells
+    std::vector<Scalar> elementCost_;
+    unsigned costSamplingInterval_ = 0;
+    unsigned linearizationIdx_ = 0;
+
     struct FullDomain
     {
         std::vector<int> cells;
@@ -83,6 +83,16 @@ class P1FeGradientCalculator : public FvBaseGradientCalculator<TypeTag>
 #endif // HAVE_DUNE_LOCALFUNCTIONS
 
 public:
+    /*!
+     * \brief Returns true iff the values and gradients at a face only depend on the
+     *        degrees of freedom adjacent to the face.
+     *
+     * This is not the case for P1 finite element gradients, which use all vertices of
+     * the element.
+     */
+    static constexpr bool usesTwoPointStencil()
+    { return !getPropValue<TypeTag, Properties::UseP1FiniteElementGradients>(); }
+
     /*!
      * \brief Precomputes the common values to calculate gradients and
      *        values of quantities at any flux approximation point.
@@ -50,6 +50,9 @@ class VcfvGridCommHandleFactory
     static const int dim = GridView::dimension;
 
 public:
+    //! The codimension of the entities to which the degrees of freedom are attached
+    static constexpr int dofCodim = dim;
+
     /*!
      * \brief Return a handle which computes the minimum of a value
      *        for each overlapping degree of freedom across all processes.
@@ -85,6 +88,20 @@ public:
         using Handle = GridCommHandleSum<ValueType, ArrayType,  DofMapper, /*commCodim=*/dim>;
         return  std::shared_ptr<Handle>(new Handle(array, dofMapper));
     }
+
+    /*!
+     * \brief Return a handle which moves the values attached to the degrees of freedom
+     *        to their new owner if the grid is re-partitioned.
+     */
+    template <class ValueType, class IdSet>
+    static std::shared_ptr<GridCommHandleMigrate<ValueType, IdSet, /*commCodim=*/dim> >
+    migrateHandle(typename GridCommHandleMigrate<ValueType, IdSet, /*commCodim=*/dim>::Container& container,
+                  const IdSet& idSet,
+                  size_t numValues)
+    {
+        using Handle = GridCommHandleMigrate<ValueType, IdSet, /*commCodim=*/dim>;
+        return  std::shared_ptr<Handle>(new Handle(container, idSet, numValues));
+    }
 };
 } // namespace Opm
 
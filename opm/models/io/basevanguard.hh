@@ -29,6 +29,7 @@
 
 #include <opm/models/utils/basicproperties.hh>
 #include <opm/models/utils/parametersystem.hh>
+#include <opm/models/parallel/weightedloadbalancing.hh>
 
 #include <dune/common/version.hh>
 
@@ -38,6 +39,7 @@
 
 #include <type_traits>
 #include <memory>
+#include <vector>
 
 namespace Opm {
 
@@ -95,7 +97,8 @@ public:
         using FemDofManager = Dune::Fem::DofManager< Grid >;
         return FemDofManager::instance( asImp_().grid() ).sequence();
 #else
-        return 0; // return the same sequence number >= 0 means the grid never changes
+        // the grid is only changed by re-partitioning it
+        return numRepartitions_;
 #endif
     }
 
@@ -110,6 +113,40 @@ public:
         updateGridView_();
     }
 
+    /*!
+     * \brief Returns true if the grid can be re-distributed based on weights for its
+     *        elements.
+     */
+    static constexpr bool supportsWeightedLoadBalancing()
+    { return WeightedLoadBalancing<Grid>::isSupported; }
+
+    /*!
+     * \brief Re-distribute the grid of a running simulation over all processes such that
+     *        the total weight of the elements of each process is roughly the same.
+     *
+     * The data attached to the entities of the grid is moved to the new owners by the
+     * data handle. The weights specify the computational cost of the interior elements
+     * of the process and are indexed by the element mapper. This is only possible if
+     * supportsWeightedLoadBalancing() returns true.
+     *
+     * \return true iff the partitioning of the grid has changed on the local process
+     */
+    template <class ElementMapper, class DataHandle>
+    bool repartition(const ElementMapper& elementMapper,
+                     const std::vector<double>& elementWeights,
+                     DataHandle& dataHandle)
+    {
+        bool changed = WeightedLoadBalancing<Grid>::repartition(asImp_().grid(),
+                                                                elementMapper,
+                                                                elementWeights,
+                                                                dataHandle);
+        updateGridView_();
+
+        // entity seeds and indices of the old partition are invalid on all processes
+        ++numRepartitions_;
+        return changed;
+    }
+
 protected:
     // this method should be called after the grid has been allocated
     void finalizeInit_()
@@ -143,6 +180,7 @@ private:
     std::unique_ptr<GridPart> gridPart_;
 #endif
     std::unique_ptr<GridView> gridView_;
+    int numRepartitions_ = 0;
 };
 
 } // namespace Opm
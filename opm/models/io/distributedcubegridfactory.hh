@@ -0,0 +1,193 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Opm::DistributedCubeGridFactory
+ */
+#ifndef EWOMS_DISTRIBUTED_CUBE_GRID_FACTORY_HH
+#define EWOMS_DISTRIBUTED_CUBE_GRID_FACTORY_HH
+
+#include <dune/grid/yaspgrid.hh>
+#include <dune/grid/utility/structuredgridfactory.hh>
+
+#if HAVE_DUNE_ALUGRID
+#include <dune/alugrid/grid.hh>
+#include <dune/alugrid/common/structuredgridfactory.hh>
+#endif
+
+#include <dune/grid/common/capabilities.hh>
+#include <dune/geometry/type.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/exceptions.hh>
+#include <dune/common/parallel/mpihelper.hh>
+
+#include <array>
+#include <bitset>
+#include <memory>
+
+namespace Opm {
+
+/*!
+ * \brief Creates a structured grid of cubes in parallel.
+ *
+ * In contrast to going through the DGF parser, each process only creates the part of
+ * the grid which it owns plus the overlap. This avoids creating the whole grid on the
+ * first rank and distributing it afterwards.
+ *
+ * The generic version uses Dune::StructuredGridFactory, which is specialized for
+ * dune-alugrid to insert only the elements of the local partition of a space filling
+ * curve. Grids which only consist of simplices get each cube split into simplices.
+ * For YaspGrid, the grid object is constructed directly because the factory neither
+ * supports a lower-left corner nor a custom overlap for it.
+ */
+template <class Grid>
+class DistributedCubeGridFactory
+{
+    static const int dim = Grid::dimension;
+    using ctype = typename Grid::ctype;
+    using GlobalPosition = Dune::FieldVector<ctype, Grid::dimensionworld>;
+
+public:
+    /*!
+     * \brief Create a grid of the cuboid spanned by two points.
+     *
+     * \param lowerLeft The lower-left corner of the domain
+     * \param upperRight The upper-right corner of the domain
+     * \param cellRes The number of cells in each direction
+     * \param overlap The number of element layers which overlap with the neighboring
+     *                processes. The generic version cannot control the overlap, so it
+     *                must be 0 for parallel runs.
+     *
+     * \throw Dune::GridError if the requested overlap cannot be provided
+     */
+    static std::unique_ptr<Grid> createCubeGrid(const GlobalPosition& lowerLeft,
+                                                const GlobalPosition& upperRight,
+                                                const std::array<unsigned, dim>& cellRes,
+                                                int overlap = 1)
+    {
+        if (overlap != 0 && Dune::MPIHelper::getCommunication().size() > 1)
+            throw Dune::GridError("The overlap of the grid cannot be specified if it is "
+                                  "created using Dune::StructuredGridFactory");
+
+        std::unique_ptr<Grid> grid;
+        if constexpr (isSimplexGrid_())
+            grid = Dune::StructuredGridFactory<Grid>::createSimplexGrid(lowerLeft, upperRight, cellRes);
+        else
+            grid = Dune::StructuredGridFactory<Grid>::createCubeGrid(lowerLeft, upperRight, cellRes);
+        return grid;
+    }
+
+private:
+    static constexpr bool isSimplexGrid_()
+    {
+        using SingleGeometryType = Dune::Capabilities::hasSingleGeometryType<Grid>;
+        if constexpr (SingleGeometryType::v)
+            return SingleGeometryType::topologyId == Dune::GeometryTypes::simplex(dim).id();
+        else
+            return false;
+    }
+};
+
+#if HAVE_DUNE_ALUGRID
+/*!
+ * \brief Creates a structured grid for dune-alugrid.
+ *
+ * dune-alugrid provides a single layer of ghost elements at the process boundaries,
+ * which serves as the overlap.
+ */
+template <int dim, int dimWorld, Dune::ALUGridElementType elType,
+          Dune::ALUGridRefinementType refinementType, class Comm>
+class DistributedCubeGridFactory<Dune::ALUGrid<dim, dimWorld, elType, refinementType, Comm> >
+{
+    using Grid = Dune::ALUGrid<dim, dimWorld, elType, refinementType, Comm>;
+    using GlobalPosition = Dune::FieldVector<typename Grid::ctype, dimWorld>;
+
+public:
+    static std::unique_ptr<Grid> createCubeGrid(const GlobalPosition& lowerLeft,
+                                                const GlobalPosition& upperRight,
+                                                const std::array<unsigned, dim>& cellRes,
+                                                int overlap = 1)
+    {
+        if (overlap > 1)
+            throw Dune::GridError("dune-alugrid only supports a single layer of ghost "
+                                  "elements as the overlap");
+
+        std::unique_ptr<Grid> grid;
+        if constexpr (elType == Dune::simplex)
+            grid = Dune::StructuredGridFactory<Grid>::createSimplexGrid(lowerLeft, upperRight, cellRes);
+        else
+            grid = Dune::StructuredGridFactory<Grid>::createCubeGrid(lowerLeft, upperRight, cellRes);
+        return grid;
+    }
+};
+#endif // HAVE_DUNE_ALUGRID
+
+template <int dim, class ctype>
+class DistributedCubeGridFactory<Dune::YaspGrid<dim, Dune::EquidistantCoordinates<ctype, dim> > >
+{
+    using Grid = Dune::YaspGrid<dim, Dune::EquidistantCoordinates<ctype, dim> >;
+    using GlobalPosition = Dune::FieldVector<ctype, dim>;
+
+public:
+    static std::unique_ptr<Grid> createCubeGrid(const GlobalPosition& lowerLeft,
+                                                const GlobalPosition& upperRight,
+                                                const std::array<unsigned, dim>& cellRes,
+                                                int overlap = 1)
+    {
+        for (int i = 0; i < dim; ++i)
+            if (lowerLeft[i] != 0.0)
+                throw Dune::GridError("The lower-left corner of YaspGrid with equidistant "
+                                      "coordinates must be the origin");
+
+        std::array<int, dim> cells;
+        for (int i = 0; i < dim; ++i)
+            cells[i] = static_cast<int>(cellRes[i]);
+
+        // YaspGrid partitions the cells itself using the communicator of all processes
+        return std::make_unique<Grid>(upperRight, cells, std::bitset<dim>(), overlap);
+    }
+};
+
+template <int dim, class ctype>
+class DistributedCubeGridFactory<Dune::YaspGrid<dim, Dune::EquidistantOffsetCoordinates<ctype, dim> > >
+{
+    using Grid = Dune::YaspGrid<dim, Dune::EquidistantOffsetCoordinates<ctype, dim> >;
+    using GlobalPosition = Dune::FieldVector<ctype, dim>;
+
+public:
+    static std::unique_ptr<Grid> createCubeGrid(const GlobalPosition& lowerLeft,
+                                                const GlobalPosition& upperRight,
+                                                const std::array<unsigned, dim>& cellRes,
+                                                int overlap = 1)
+    {
+        std::array<int, dim> cells;
+        for (int i = 0; i < dim; ++i)
+            cells[i] = static_cast<int>(cellRes[i]);
+
+        return std::make_unique<Grid>(lowerLeft, upperRight, cells, std::bitset<dim>(), overlap);
+    }
+};
+
+} // namespace Opm
+
+#endif
@@ -0,0 +1,296 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Opm::PreprocessingCache
+ */
+#ifndef EWOMS_PREPROCESSING_CACHE_HH
+#define EWOMS_PREPROCESSING_CACHE_HH
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Opm {
+
+/*!
+ * \brief Stores the results of expensive preprocessing steps in binary files, so that
+ *        they can be reused by subsequent runs which use the same grid.
+ *
+ * Each process uses its own files. The files are identified by a key which is a hash of
+ * the number of processes, the rank of the process and of the topology of the local
+ * part of the grid. Anything else which the cached data depends on must be added to
+ * the key via hashValue() before the cache is accessed.
+ *
+ * If the directory for the cache is empty, the cache is disabled.
+ */
+class PreprocessingCache
+{
+    static constexpr char magicCookie_[8] = { 'E', 'W', 'O', 'M', 'S', 'P', 'P', 'C' };
+    static constexpr std::uint32_t formatVersion_ = 2;
+
+public:
+    PreprocessingCache(const std::string& directory, int rank, int numRanks)
+        : directory_(directory)
+        , rank_(rank)
+    {
+        if (!isEnabled())
+            return;
+
+        struct stat st;
+        if (::stat(directory_.c_str(), &st) != 0)
+            throw std::runtime_error("Could not access preprocessing cache directory '"
+                                     +directory_+"':"+strerror(errno));
+        if (!S_ISDIR(st.st_mode))
+            throw std::runtime_error("Path to preprocessing cache directory '"+directory_
+                                     +"' exists but is not a directory");
+        if (access(directory_.c_str(), W_OK) != 0)
+            throw std::runtime_error("Preprocessing cache directory '"+directory_
+                                     +"' exists but is not writeable");
+
+        hashValue(static_cast<std::uint64_t>(numRanks));
+        hashValue(static_cast<std::uint64_t>(rank));
+    }
+
+    /*!
+     * \brief Returns true iff a directory for the cache was specified.
+     */
+    bool isEnabled() const
+    { return !directory_.empty(); }
+
+    /*!
+     * \brief Returns the key which identifies the cached data of the process.
+     */
+    std::uint64_t key() const
+    { return key_; }
+
+    /*!
+     * \brief Add an integral value to the key.
+     */
+    void hashValue(std::uint64_t value)
+    {
+        for (unsigned i = 0; i < sizeof(value); ++i)
+            hashByte_(static_cast<unsigned char>((value >> (8*i)) & 0xff));
+    }
+
+    /*!
+     * \brief Add a string to the key.
+     */
+    void hashString(const std::string& value)
+    {
+        hashValue(value.size());
+        for (char c : value)
+            hashByte_(static_cast<unsigned char>(c));
+    }
+
+    /*!
+     * \brief Add the topology of the local part of a grid to the key.
+     *
+     * This considers the indices of all elements and of their vertices as well as the
+     * partition type of the elements.
+     */
+    template <class GridView>
+    void hashGridTopology(const GridView& gridView)
+    {
+        static const int dim = GridView::dimension;
+        const auto& indexSet = gridView.indexSet();
+
+        hashValue(static_cast<std::uint64_t>(gridView.size(0)));
+        hashValue(static_cast<std::uint64_t>(gridView.size(dim)));
+        for (const auto& elem : elements(gridView)) {
+            hashValue(static_cast<std::uint64_t>(indexSet.index(elem)));
+            hashValue(static_cast<std::uint64_t>(elem.partitionType()));
+
+            const unsigned numVertices = elem.subEntities(dim);
+            for (unsigned vertexIdx = 0; vertexIdx < numVertices; ++vertexIdx)
+                hashValue(static_cast<std::uint64_t>(indexSet.subIndex(elem, vertexIdx, dim)));
+        }
+    }
+
+    /*!
+     * \brief Read a sparsity pattern from the cache.
+     *
+     * The pattern must already exhibit the correct number of rows. If no matching
+     * pattern is cached, false is returned and the pattern is not modified.
+     */
+    template <class Set>
+    bool loadSparsityPattern(std::vector<Set>& pattern) const
+    {
+        if (!isEnabled())
+            return false;
+
+        std::ifstream is(fileName_("sparsity"), std::ios::binary);
+        if (!is.good() || !readHeader_(is))
+            return false;
+
+        std::uint64_t numRows;
+        read_(is, numRows);
+        if (!is.good() || numRows != pattern.size())
+            return false;
+
+        std::vector<std::uint64_t> rowOffsets(numRows + 1);
+        is.read(reinterpret_cast<char*>(rowOffsets.data()),
+                static_cast<std::streamsize>(rowOffsets.size()*sizeof(std::uint64_t)));
+        if (!is.good() || rowOffsets[0] != 0)
+            return false;
+        for (std::size_t rowIdx = 0; rowIdx < numRows; ++rowIdx)
+            if (rowOffsets[rowIdx + 1] < rowOffsets[rowIdx])
+                return false;
+
+        std::vector<std::uint64_t> columns(rowOffsets.back());
+        is.read(reinterpret_cast<char*>(columns.data()),
+                static_cast<std::streamsize>(columns.size()*sizeof(std::uint64_t)));
+        if (!is.good())
+            return false;
+
+        for (std::size_t rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+            auto& row = pattern[rowIdx];
+            row.clear();
+            // the columns are sorted, so the insertion hint makes this linear
+            for (std::uint64_t i = rowOffsets[rowIdx]; i < rowOffsets[rowIdx + 1]; ++i)
+                row.insert(row.end(), columns[i]);
+        }
+
+        return true;
+    }
+
+    /*!
+     * \brief Write a sparsity pattern to the cache.
+     *
+     * The file is first written under a unique temporary name and then renamed, so that
+     * concurrent runs neither see partially written files nor write to the same
+     * temporary file. If the file cannot be written, the cache is silently not updated.
+     */
+    template <class Set>
+    void storeSparsityPattern(const std::vector<Set>& pattern) const
+    {
+        if (!isEnabled())
+            return;
+
+        std::vector<std::uint64_t> rowOffsets(pattern.size() + 1, 0);
+        std::vector<std::uint64_t> columns;
+        for (std::size_t rowIdx = 0; rowIdx < pattern.size(); ++rowIdx) {
+            for (const auto& colIdx : pattern[rowIdx])
+                columns.push_back(static_cast<std::uint64_t>(colIdx));
+            rowOffsets[rowIdx + 1] = columns.size();
+        }
+
+        const std::string fileName = fileName_("sparsity");
+
+        // mkstemp() replaces the trailing X characters by a name which does not exist
+        // yet and creates the file
+        std::string tmpFileName = fileName + ".XXXXXX";
+        int fd = ::mkstemp(&tmpFileName[0]);
+        if (fd < 0)
+            return;
+        ::close(fd);
+
+        {
+            std::ofstream os(tmpFileName, std::ios::binary | std::ios::trunc);
+            writeHeader_(os);
+            write_(os, static_cast<std::uint64_t>(pattern.size()));
+            os.write(reinterpret_cast<const char*>(rowOffsets.data()),
+                     static_cast<std::streamsize>(rowOffsets.size()*sizeof(std::uint64_t)));
+            os.write(reinterpret_cast<const char*>(columns.data()),
+                     static_cast<std::streamsize>(columns.size()*sizeof(std::uint64_t)));
+            if (!os.good()) {
+                os.close();
+                std::remove(tmpFileName.c_str());
+                return;
+            }
+        }
+
+        if (std::rename(tmpFileName.c_str(), fileName.c_str()) != 0)
+            std::remove(tmpFileName.c_str());
+    }
+
+private:
+    // FNV-1a
+    void hashByte_(unsigned char value)
+    {
+        key_ ^= value;
+        key_ *= 1099511628211ULL;
+    }
+
+    std::string fileName_(const std::string& kind) const
+    {
+        std::string dir = directory_;
+        if (!dir.empty() && dir.back() != '/')
+            dir += "/";
+
+        std::ostringstream oss;
+        oss << dir << kind << "_" << std::hex << key_ << std::dec << "_rank=" << rank_ << ".ppc";
+        return oss.str();
+    }
+
+    void writeHeader_(std::ostream& os) const
+    {
+        os.write(magicCookie_, sizeof(magicCookie_));
+        write_(os, formatVersion_);
+        write_(os, key_);
+    }
+
+    bool readHeader_(std::istream& is) const
+    {
+        char cookie[sizeof(magicCookie_)];
+        std::uint32_t version;
+        std::uint64_t key;
+
+        is.read(cookie, sizeof(cookie));
+        read_(is, version);
+        read_(is, key);
+
+        return
+            is.good()
+            && std::memcmp(cookie, magicCookie_, sizeof(cookie)) == 0
+            && version == formatVersion_
+            && key == key_;
+    }
+
+    template <class T>
+    static void write_(std::ostream& os, const T& value)
+    { os.write(reinterpret_cast<const char*>(&value), sizeof(value)); }
+
+    template <class T>
+    static void read_(std::istream& is, T& value)
+    { is.read(reinterpret_cast<char*>(&value), sizeof(value)); }
+
+    std::string directory_;
+    int rank_;
+    std::uint64_t key_ = 14695981039346656037ULL;
+};
+
+} // namespace Opm
+
+#endif
@@ -27,6 +27,8 @@
 #ifndef EWOMS_RESTART_HH
 #define EWOMS_RESTART_HH
 
+#include <opm/models/utils/profiler.hh>
+
 #include <string>
 #include <fstream>
 #include <iostream>
@@ -162,7 +164,10 @@ public:
      * \brief Finish the restart file.
      */
     void serializeEnd()
-    { outStream_.close(); }
+    {
+        EWOMS_PROFILE_COUNT("bytes written", std::streamoff(outStream_.tellp()));
+        outStream_.close();
+    }
 
     /*!
      * \brief Start reading a restart file at a certain simulated
@@ -28,6 +28,7 @@
 #define EWOMS_STRUCTURED_GRID_VANGUARD_HH
 
 #include <opm/models/io/basevanguard.hh>
+#include <opm/models/io/distributedcubegridfactory.hh>
 #include <opm/models/utils/propertysystem.hh>
 #include <opm/models/utils/parametersystem.hh>
 
@@ -42,6 +43,7 @@
 #include <dune/common/fvector.hh>
 #include <dune/common/version.hh>
 
+#include <array>
 #include <vector>
 #include <memory>
 
@@ -60,6 +62,10 @@ struct StructuredGridVanguard {};
 
 } // namespace TTag
 
+//! Create the grid on all processes directly instead of using the DGF parser
+template<class TypeTag, class MyTypeTag>
+struct EnableDistributedGridCreation { using type = UndefinedProperty; };
+
 // GRIDDIM is only set by the finger problem
 #ifndef GRIDDIM
 static const int dim = 2;
@@ -79,6 +85,9 @@ struct Grid<TypeTag, TTag::StructuredGridVanguard> { using type = Dune::YaspGrid
 template<class TypeTag>
 struct Vanguard<TypeTag, TTag::StructuredGridVanguard> { using type = Opm::StructuredGridVanguard<TypeTag>; };
 
+template<class TypeTag>
+struct EnableDistributedGridCreation<TypeTag, TTag::StructuredGridVanguard> { static constexpr bool value = false; };
+
 } // namespace Opm::Properties
 
 namespace Opm {
@@ -125,6 +134,10 @@ public:
             EWOMS_REGISTER_PARAM(TypeTag, unsigned, CellsZ,
                                  "The number of intervalls in z direction");
         }
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableDistributedGridCreation,
+                             "Let each process create its part of the grid directly "
+                             "instead of creating the whole grid on the first process "
+                             "and distributing it afterwards");
     }
 
     /*!
@@ -149,21 +162,33 @@ public:
             cellRes[2] = EWOMS_GET_PARAM(TypeTag, unsigned, CellsZ);
         }
 
-        std::stringstream dgffile;
-        dgffile << "DGF" << std::endl;
-        dgffile << "INTERVAL" << std::endl;
-        dgffile << lowerLeft  << std::endl;
-        dgffile << upperRight << std::endl;
-        dgffile << cellRes    << std::endl;
-        dgffile << "#" << std::endl;
-        dgffile << "GridParameter" << std::endl;
-        dgffile << "overlap 1" << std::endl;
-        dgffile << "#" << std::endl;
-        dgffile << "Simplex" << std::endl;
-        dgffile << "#" << std::endl;
-
-        // use DGF parser to create a grid from interval block
-        gridPtr_.reset( Dune::GridPtr< Grid >( dgffile ).release() );
+        if (EWOMS_GET_PARAM(TypeTag, bool, EnableDistributedGridCreation)) {
+            std::array<unsigned, dim> cells;
+            for (int i = 0; i < dim; ++i)
+                cells[i] = static_cast<unsigned>(cellRes[i]);
+
+            gridPtr_ = DistributedCubeGridFactory<Grid>::createCubeGrid(lowerLeft,
+                                                                        upperRight,
+                                                                        cells,
+                                                                        /*overlap=*/1);
+        }
+        else {
+            std::stringstream dgffile;
+            dgffile << "DGF" << std::endl;
+            dgffile << "INTERVAL" << std::endl;
+            dgffile << lowerLeft  << std::endl;
+            dgffile << upperRight << std::endl;
+            dgffile << cellRes    << std::endl;
+            dgffile << "#" << std::endl;
+            dgffile << "GridParameter" << std::endl;
+            dgffile << "overlap 1" << std::endl;
+            dgffile << "#" << std::endl;
+            dgffile << "Simplex" << std::endl;
+            dgffile << "#" << std::endl;
+
+            // use DGF parser to create a grid from interval block
+            gridPtr_.reset( Dune::GridPtr< Grid >( dgffile ).release() );
+        }
 
         unsigned numRefinements = EWOMS_GET_PARAM(TypeTag, unsigned, GridGlobalRefinements);
         gridPtr_->globalRefine(static_cast<int>(numRefinements));
@@ -34,6 +34,7 @@
 
 #include <opm/models/io/baseoutputwriter.hh>
 #include <opm/models/parallel/tasklets.hh>
+#include <opm/models/utils/profiler.hh>
 
 #include <opm/material/common/Valgrind.hpp>
 
@@ -50,6 +51,7 @@
 #include <string>
 #include <limits>
 #include <sstream>
+#include <system_error>
 #include <fstream>
 
 namespace Opm {
@@ -88,6 +90,15 @@ class VtkMultiWriter : public BaseOutputWriter
             // The file names in the pvd file are relative, the path should therefore be stripped.
             const std::filesystem::path fullPath{fileName};
             const std::string localFileName = fullPath.filename();
+
+            // in the parallel case, the names of the pieces written by the individual
+            // processes are not known here, so only sequential output is accounted for
+            if (multiWriter_.commSize_ == 1) {
+                std::error_code ec;
+                const auto fileSize = std::filesystem::file_size(fullPath, ec);
+                if (!ec)
+                    EWOMS_PROFILE_COUNT("bytes written", fileSize);
+            }
             multiWriter_.multiFile_.precision(16);
             multiWriter_.multiFile_ << "   <DataSet timestep=\"" << multiWriter_.curTime_ << "\" file=\""
                                     << localFileName << "\"/>\n";
@@ -28,14 +28,19 @@
 #define EWOMS_NEWTON_METHOD_HH
 
 #include "nullconvergencewriter.hh"
+#include "newtontelemetrywriter.hh"
 
 #include "newtonmethodproperties.hh"
+#include "newtonsubdomain.hh"
 
 #include <opm/common/Exceptions.hpp>
 
 #include <opm/material/densead/Math.hpp>
 
 #include <opm/models/discretization/common/fvbaseproperties.hh>
+#include <opm/models/utils/allocationcounter.hh>
+#include <opm/models/utils/genericguard.hh>
+#include <opm/models/utils/profiler.hh>
 #include <opm/models/utils/timer.hh>
 #include <opm/models/utils/timerguard.hh>
 
@@ -44,9 +49,21 @@
 #include <dune/istl/istlexception.hh>
 #include <dune/common/classname.hh>
 #include <dune/common/parallel/mpihelper.hh>
+#include <dune/grid/common/gridenums.hh>
+#include <dune/grid/common/rangegenerators.hh>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <unistd.h>
 
@@ -78,6 +95,8 @@ struct NewtonConvergenceWriter<TypeTag, TTag::NewtonMethod> { using type = NullC
 template<class TypeTag>
 struct NewtonWriteConvergence<TypeTag, TTag::NewtonMethod> { static constexpr bool value = false; };
 template<class TypeTag>
+struct NewtonWriteTelemetry<TypeTag, TTag::NewtonMethod> { static constexpr bool value = false; };
+template<class TypeTag>
 struct NewtonVerbose<TypeTag, TTag::NewtonMethod> { static constexpr bool value = true; };
 template<class TypeTag>
 struct NewtonTolerance<TypeTag, TTag::NewtonMethod>
@@ -97,6 +116,20 @@ template<class TypeTag>
 struct NewtonTargetIterations<TypeTag, TTag::NewtonMethod> { static constexpr int value = 10; };
 template<class TypeTag>
 struct NewtonMaxIterations<TypeTag, TTag::NewtonMethod> { static constexpr int value = 20; };
+template<class TypeTag>
+struct NewtonLocalSolves<TypeTag, TTag::NewtonMethod> { static constexpr bool value = false; };
+template<class TypeTag>
+struct NewtonLocalDomainSize<TypeTag, TTag::NewtonMethod> { static constexpr int value = 1000; };
+template<class TypeTag>
+struct NewtonLocalMaxIterations<TypeTag, TTag::NewtonMethod> { static constexpr int value = 10; };
+template<class TypeTag>
+struct NewtonThreadedLocalSolves<TypeTag, TTag::NewtonMethod> { static constexpr bool value = false; };
+template<class TypeTag>
+struct NewtonMaxAllocationsPerDof<TypeTag, TTag::NewtonMethod>
+{
+    using type = GetPropType<TypeTag, Scalar>;
+    static constexpr type value = -1.0;
+};
 
 } // namespace Opm::Properties
 
@@ -119,6 +152,7 @@ class NewtonMethod
 
     using SolutionVector = GetPropType<TypeTag, Properties::SolutionVector>;
     using GlobalEqVector = GetPropType<TypeTag, Properties::GlobalEqVector>;
+    using LocalDomainMatrix = typename GetPropType<TypeTag, Properties::SparseMatrixAdapter>::IstlMatrix;
     using PrimaryVariables = GetPropType<TypeTag, Properties::PrimaryVariables>;
     using Constraints = GetPropType<TypeTag, Properties::Constraints>;
     using EqVector = GetPropType<TypeTag, Properties::EqVector>;
@@ -139,9 +173,27 @@ public:
     {
         lastError_ = 1e100;
         error_ = 1e100;
+        initialError_ = 1e100;
         tolerance_ = EWOMS_GET_PARAM(TypeTag, Scalar, NewtonTolerance);
 
         numIterations_ = 0;
+        numLinearizations_ = 0;
+
+        enableLocalSolves_ = EWOMS_GET_PARAM(TypeTag, bool, NewtonLocalSolves);
+        threadedLocalSolves_ = EWOMS_GET_PARAM(TypeTag, bool, NewtonThreadedLocalSolves);
+        if (enableLocalSolves_ && !LinearizesCellSubDomains<Linearizer>::value)
+            throw std::invalid_argument("Local Newton solves require a linearizer which is able "
+                                        "to assemble subdomains given as lists of cells");
+        numLocalDomainColors_ = 0;
+        localDomainsNumDof_ = 0;
+        numLocalDomainSolves_ = 0;
+        numLocalIterations_ = 0;
+
+        maxAllocationsPerDof_ = EWOMS_GET_PARAM(TypeTag, Scalar, NewtonMaxAllocationsPerDof);
+        numLinearizeAllocations_ = 0;
+        numUpdateAllocations_ = 0;
+
+        enableTelemetry_ = EWOMS_GET_PARAM(TypeTag, bool, NewtonWriteTelemetry);
     }
 
     /*!
@@ -157,6 +209,9 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, bool, NewtonWriteConvergence,
                              "Write the convergence behaviour of the Newton "
                              "method to a VTK file");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, NewtonWriteTelemetry,
+                             "Write the error, the number of linear iterations and the "
+                             "timings of each Newton iteration to a file per process");
         EWOMS_REGISTER_PARAM(TypeTag, int, NewtonTargetIterations,
                              "The 'optimum' number of Newton iterations per "
                              "time step");
@@ -170,6 +225,24 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, Scalar, NewtonMaxError,
                              "The maximum error tolerated by the Newton "
                              "method to which does not cause an abort");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, NewtonLocalSolves,
+                             "Solve the subdomains which exhibit large residuals "
+                             "locally before each global Newton iteration");
+        EWOMS_REGISTER_PARAM(TypeTag, int, NewtonLocalDomainSize,
+                             "The number of cells per subdomain used by the local "
+                             "Newton solves");
+        EWOMS_REGISTER_PARAM(TypeTag, int, NewtonLocalMaxIterations,
+                             "The maximum number of Newton iterations used to solve "
+                             "a subdomain locally");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, NewtonThreadedLocalSolves,
+                             "Solve subdomains which are not adjacent concurrently "
+                             "using multiple threads");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, NewtonMaxAllocationsPerDof,
+                             "The maximum number of heap allocations per degree of "
+                             "freedom which is tolerated during the linearization "
+                             "or the update of a Newton iteration. Negative values "
+                             "disable the check. Only effective if the program "
+                             "counts its allocations");
     }
 
     /*!
@@ -229,6 +302,29 @@ public:
     void setIterationIndex(int value)
     { numIterations_ = value; }
 
+    /*!
+     * \brief Returns the number of times the system of equations was linearized during
+     *        the last invocation of the Newton method.
+     *
+     * In contrast to numIterations(), this is not modified if the Newton method fails,
+     * i.e., it can be used to quantify the work spent on failed time steps.
+     */
+    int numLinearizations() const
+    { return numLinearizations_; }
+
+    /*!
+     * \brief Returns the error of the solution after the most recent linearization.
+     */
+    Scalar error() const
+    { return error_; }
+
+    /*!
+     * \brief Returns the error of the solution after the first linearization of the
+     *        last invocation of the Newton method.
+     */
+    Scalar initialError() const
+    { return initialError_; }
+
     /*!
      * \brief Return the current tolerance at which the Newton method considers itself to
      *        be converged.
@@ -265,6 +361,13 @@ public:
         linearizeTimer_.halt();
         solveTimer_.halt();
         updateTimer_.halt();
+        numLinearizations_ = 0;
+        numLocalDomainSolves_ = 0;
+        numLocalIterations_ = 0;
+        numLinearizeAllocations_ = 0;
+        numUpdateAllocations_ = 0;
+
+        EWOMS_PROFILE_SCOPE("newton");
 
         SolutionVector& nextSolution = model().solution(/*historyIdx=*/0);
         SolutionVector currentSolution(nextSolution);
@@ -274,6 +377,18 @@ public:
 
         TimerGuard prePostProcessTimerGuard(prePostProcessTimer_);
 
+        // the telemetry of the time step is written to disk once the Newton method is
+        // done, regardless of how it terminates
+        if (enableTelemetry_ && !telemetryWriter_)
+            createTelemetryWriter_();
+        auto flushTelemetryFn =
+            [this]() -> void
+            {
+                if (this->telemetryWriter_)
+                    this->telemetryWriter_->flush();
+            };
+        GenericGuard<decltype(flushTelemetryFn)> telemetryGuard(flushTelemetryFn);
+
         // tell the implementation that we begin solving
         prePostProcessTimer_.start();
         asImp_().begin_(nextSolution);
@@ -296,6 +411,15 @@ public:
                 asImp_().beginIteration_();
                 prePostProcessTimer_.stop();
 
+                if (telemetryWriter_)
+                    beginTelemetryIteration_();
+
+                // converge the parts of the spatial domain which exhibit large residuals
+                // locally. The first iteration is always a global one because the local
+                // solves require the residual of a global linearization.
+                if (enableLocalSolves_ && numIterations_ > 0)
+                    asImp_().solveLocalDomains_(nextSolution);
+
                 // make the current solution to the old one
                 currentSolution = nextSolution;
 
@@ -307,16 +431,25 @@ public:
 
                 // do the actual linearization
                 linearizeTimer_.start();
-                asImp_().linearizeDomain_();
-                asImp_().linearizeAuxiliaryEquations_();
+                std::size_t numAllocationsBefore = AllocationCounter::numAllocations();
+                {
+                    EWOMS_PROFILE_SCOPE("linearize");
+                    asImp_().linearizeDomain_();
+                    asImp_().linearizeAuxiliaryEquations_();
+                }
+                numLinearizeAllocations_ += checkAllocations_("linearization", numAllocationsBefore);
                 linearizeTimer_.stop();
+                ++numLinearizations_;
 
                 solveTimer_.start();
                 auto& residual = linearizer.residual();
                 const auto& jacobian = linearizer.jacobian();
-                linearSolver_.prepare(jacobian, residual);
-                linearSolver_.setResidual(residual);
-                linearSolver_.getResidual(residual);
+                {
+                    EWOMS_PROFILE_SCOPE("prepare linear solver");
+                    linearSolver_.prepare(jacobian, residual);
+                    linearSolver_.setResidual(residual);
+                    linearSolver_.getResidual(residual);
+                }
                 solveTimer_.stop();
 
                 // The preSolve_() method usually computes the errors, but it can do
@@ -326,11 +459,18 @@ public:
                 asImp_().preSolve_(currentSolution, residual);
                 updateTimer_.stop();
 
+                if (numIterations_ == 0)
+                    initialError_ = error_;
+
                 if (!asImp_().proceed_()) {
                     if (asImp_().verbose_() && isatty(fileno(stdout)))
                         std::cout << clearRemainingLine
                                   << std::flush;
 
+                    // no linear system is solved by the last iteration
+                    if (telemetryWriter_)
+                        writeTelemetry_(/*linearIterations=*/0, /*linearSolverConverged=*/true);
+
                     // tell the implementation that we're done with this iteration
                     prePostProcessTimer_.start();
                     asImp_().endIteration_(nextSolution, currentSolution);
@@ -349,13 +489,19 @@ public:
                 solveTimer_.start();
                 // solve A x = b, where b is the residual, A is its Jacobian and x is the
                 // update of the solution
-                linearSolver_.setMatrix(jacobian);
-                solutionUpdate = 0.0;
-                bool converged = linearSolver_.solve(solutionUpdate);
+                bool converged;
+                {
+                    EWOMS_PROFILE_SCOPE("linear solve");
+                    linearSolver_.setMatrix(jacobian);
+                    solutionUpdate = 0.0;
+                    converged = linearSolver_.solve(solutionUpdate);
+                }
                 solveTimer_.stop();
 
                 if (!converged) {
                     solveTimer_.stop();
+                    if (telemetryWriter_)
+                        writeTelemetry_(linearSolver_.iterations(), /*linearSolverConverged=*/false);
                     if (asImp_().verbose_())
                         std::cout << "Newton: Linear solver did not converge\n" << std::flush;
 
@@ -376,12 +522,20 @@ public:
                 // update the current solution (i.e. uOld) with the delta
                 // (i.e. u). The result is stored in u
                 updateTimer_.start();
-                asImp_().postSolve_(currentSolution,
-                                    residual,
-                                    solutionUpdate);
-                asImp_().update_(nextSolution, currentSolution, solutionUpdate, residual);
+                numAllocationsBefore = AllocationCounter::numAllocations();
+                {
+                    EWOMS_PROFILE_SCOPE("update");
+                    asImp_().postSolve_(currentSolution,
+                                        residual,
+                                        solutionUpdate);
+                    asImp_().update_(nextSolution, currentSolution, solutionUpdate, residual);
+                }
+                numUpdateAllocations_ += checkAllocations_("update", numAllocationsBefore);
                 updateTimer_.stop();
 
+                if (telemetryWriter_)
+                    writeTelemetry_(linearSolver_.iterations(), /*linearSolverConverged=*/true);
+
                 if (asImp_().verbose_() && isatty(fileno(stdout)))
                     // make sure that the line currently holding the cursor is prestine
                     std::cout << clearRemainingLine
@@ -442,6 +596,14 @@ public:
                       << updateTimer_.realTimeElapsed() << "("
                       << 100 * updateTimer_.realTimeElapsed()/elapsedTot << "%)"
                       << "\n" << std::flush;
+            if (enableLocalSolves_)
+                std::cout << "Local solves: " << numLocalDomainSolves_ << " subdomains, "
+                          << numLocalIterations_ << " local iterations"
+                          << "\n" << std::flush;
+            if (AllocationCounter::isActive())
+                std::cout << "Heap allocations during linearization/update: "
+                          << numLinearizeAllocations_ << "/" << numUpdateAllocations_
+                          << "\n" << std::flush;
         }
 
 
@@ -500,7 +662,13 @@ public:
      *        equations the next time it is called.
      */
     void eraseMatrix()
-    { linearSolver_.eraseMatrix(); }
+    {
+        linearSolver_.eraseMatrix();
+
+        // the subdomains of the local solves must be recreated as well
+        localDomains_.clear();
+        localDomainMatrices_.clear();
+    }
 
     /*!
      * \brief Returns the linear solver backend object for external use.
@@ -671,6 +839,352 @@ protected:
         }
     }
 
+    /*!
+     * \brief Solve the subdomains which exhibit large residuals using local Newton
+     *        iterations.
+     *
+     * The subdomains are selected using the residual of the current solution, i.e.,
+     * the one which results from the update of the most recent global Newton iteration.
+     * While a subdomain is solved, the solution of its neighborhood is
+     * kept fixed. This way, the parts of the spatial domain where the solution changes
+     * a lot converge at a fraction of the costs of a global Newton iteration, while the
+     * global iteration which follows takes care of the coupling between the subdomains.
+     *
+     * The subdomains are solved in the order of decreasing residual. If threads are
+     * used, all selected subdomains of the same color are solved concurrently. Only the
+     * interior cells of a process are part of a subdomain, so the solution of the
+     * overlap is fetched from its owners afterwards.
+     *
+     * \param nextSolution The solution which gets improved by the local solves
+     */
+    void solveLocalDomains_(SolutionVector& nextSolution)
+    {
+        if constexpr (LinearizesCellSubDomains<Linearizer>::value) {
+            if (localDomains_.empty() || localDomainsNumDof_ != model().numGridDof())
+                setupLocalDomains_();
+
+            // the residual of the last global linearization belongs to the solution
+            // before its update, so the residual of the current solution is evaluated.
+            // the linearization of a subdomain modifies the residual of its neighborhood,
+            // so the subdomains which get solved must be selected beforehand
+            localSolveResidual_.resize(nextSolution.size());
+            model().globalResidual(localSolveResidual_);
+            std::vector<std::pair<Scalar, unsigned>> selectedDomains;
+            for (const auto& domain : localDomains_) {
+                const Scalar domainError = localDomainError_(domain, localSolveResidual_);
+                if (domainError > tolerance())
+                    selectedDomains.emplace_back(domainError, domain.index);
+            }
+            std::sort(selectedDomains.begin(), selectedDomains.end(), std::greater<>());
+
+            std::vector<std::vector<unsigned>> batches;
+            if (threadedLocalSolves_) {
+                batches.resize(numLocalDomainColors_);
+                for (const auto& [domainError, domainIdx] : selectedDomains)
+                    batches[localDomains_[domainIdx].color].push_back(domainIdx);
+            }
+            else {
+                for (const auto& [domainError, domainIdx] : selectedDomains)
+                    batches.push_back({domainIdx});
+            }
+
+            int numIterations = 0;
+            for (const auto& batch : batches) {
+                if (!batch.empty())
+                    numIterations += solveLocalDomainBatch_(batch, nextSolution);
+            }
+
+            // the local solves have changed the solution of the interior cells, which
+            // the neighboring processes see as their overlap
+            if (comm_.size() > 1) {
+                updateTimer_.start();
+                model().syncOverlap();
+                model().invalidateAndUpdateIntensiveQuantitiesOfCells(/*timeIdx=*/0,
+                                                                      localDomainsOverlapCells_);
+                updateTimer_.stop();
+            }
+
+            const int numSolved = comm_.sum(static_cast<int>(selectedDomains.size()));
+            numIterations = comm_.sum(numIterations);
+            numLocalDomainSolves_ += numSolved;
+            numLocalIterations_ += numIterations;
+
+            endIterMsg() << ", local solves: " << numSolved << " subdomains, "
+                         << numIterations << " iterations";
+        }
+    }
+
+    /*!
+     * \brief Partition the local grid into the subdomains used by the local solves.
+     */
+    void setupLocalDomains_()
+    {
+        const auto& elementMapper = model().elementMapper();
+        const std::size_t numGridDof = model().numGridDof();
+
+        // only the interior cells are solved locally, the overlap is taken care of by
+        // the processes which own it
+        std::vector<bool> isInterior(numGridDof, false);
+        localDomainsOverlapCells_.clear();
+        for (const auto& elem : elements(simulator_.gridView())) {
+            const unsigned elemIdx = elementMapper.index(elem);
+            isInterior[elemIdx] = (elem.partitionType() == Dune::InteriorEntity);
+            if (!isInterior[elemIdx])
+                localDomainsOverlapCells_.push_back(elemIdx);
+        }
+
+        const int domainSize = EWOMS_GET_PARAM(TypeTag, int, NewtonLocalDomainSize);
+        localDomains_ = partitionNewtonSubDomains(model().linearizer().jacobian().istlMatrix(),
+                                                  isInterior,
+                                                  static_cast<std::size_t>(std::max(domainSize, 1)));
+
+        // the matrices of the subdomains are set up by their first local solve
+        localDomainMatrices_.clear();
+        localDomainMatrices_.resize(localDomains_.size());
+
+        numLocalDomainColors_ = 0;
+        for (const auto& domain : localDomains_)
+            numLocalDomainColors_ = std::max(numLocalDomainColors_, domain.color + 1);
+        localDomainsNumDof_ = numGridDof;
+    }
+
+    /*!
+     * \brief Apply local Newton iterations to a set of subdomains which are not adjacent.
+     *
+     * The subdomains are linearized one after the other and their systems of equations
+     * are extracted before the next subdomain is linearized. The linear solves and the
+     * updates of the intensive quantities of the subdomains are independent and are thus
+     * done concurrently. Each thread updates the intensive quantities of its subdomains
+     * serially. Subdomains for which the local Newton method breaks down are reset to
+     * their initial solution.
+     *
+     * \return The number of local iterations which have been done
+     */
+    int solveLocalDomainBatch_(const std::vector<unsigned>& batch, SolutionVector& nextSolution)
+    {
+        using ElementContext = GetPropType<TypeTag, Properties::ElementContext>;
+
+        auto& linearizer = model().linearizer();
+
+        struct LocalDomainState
+        {
+            unsigned domainIdx = 0;
+            bool active = true;
+            bool failed = false;
+            bool restored = false;
+            std::vector<PrimaryVariables> initialSolution;
+            LocalDomainMatrix* matrix = nullptr;
+            GlobalEqVector residual;
+            GlobalEqVector update;
+        };
+
+        std::vector<LocalDomainState> states(batch.size());
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            auto& state = states[i];
+            state.domainIdx = batch[i];
+            for (int cellIdx : localDomains_[state.domainIdx].cells)
+                state.initialSolution.push_back(nextSolution[cellIdx]);
+        }
+
+        const auto markFailed = [](LocalDomainState& state) {
+            state.active = false;
+            state.failed = true;
+        };
+
+        // reset the subdomains for which the local Newton method broke down
+        const auto restoreFailed = [&]() {
+            for (auto& state : states) {
+                if (!state.failed || state.restored)
+                    continue;
+
+                const auto& cells = localDomains_[state.domainIdx].cells;
+                for (std::size_t i = 0; i < cells.size(); ++i)
+                    nextSolution[cells[i]] = state.initialSolution[i];
+                model().invalidateAndUpdateIntensiveQuantitiesOfCells(/*timeIdx=*/0, cells);
+                state.restored = true;
+            }
+        };
+
+        const int maxIterations = EWOMS_GET_PARAM(TypeTag, int, NewtonLocalMaxIterations);
+        const Scalar maxError = EWOMS_GET_PARAM(TypeTag, Scalar, NewtonMaxError);
+        const bool concurrent = threadedLocalSolves_ && states.size() > 1;
+        int numIterations = 0;
+        for (int iterIdx = 0; iterIdx < maxIterations; ++iterIdx) {
+            bool anyActive = false;
+
+            linearizeTimer_.start();
+            for (auto& state : states) {
+                if (!state.active)
+                    continue;
+
+                const auto& domain = localDomains_[state.domainIdx];
+                try {
+                    linearizer.linearizeDomain(domain);
+                }
+                catch (const NumericalProblem&) {
+                    markFailed(state);
+                    continue;
+                }
+
+                const Scalar domainError = localDomainError_(domain, linearizer.residual());
+                if (!std::isfinite(domainError) || domainError > maxError) {
+                    markFailed(state);
+                    continue;
+                }
+                else if (domainError <= tolerance()) {
+                    // the subdomain is converged
+                    state.active = false;
+                    continue;
+                }
+
+                // the structure of the local matrix of a subdomain does not change until
+                // the subdomains are recreated, so it is only set up once
+                auto& matrix = localDomainMatrices_[state.domainIdx];
+                if (!matrix)
+                    matrix = std::make_unique<LocalDomainMatrix>();
+                state.matrix = matrix.get();
+                extractNewtonSubDomainSystem(linearizer.jacobian().istlMatrix(),
+                                             linearizer.residual(),
+                                             domain,
+                                             *state.matrix,
+                                             state.residual);
+                anyActive = true;
+                ++numIterations;
+            }
+            linearizeTimer_.stop();
+
+            if (!anyActive)
+                break;
+
+            solveTimer_.start();
+#ifdef _OPENMP
+#pragma omp parallel for if (concurrent)
+#endif
+            for (unsigned i = 0; i < states.size(); ++i) {
+                auto& state = states[i];
+                if (!state.active)
+                    continue;
+
+                // exceptions must not leave the parallel region
+                try {
+                    if (!solveNewtonSubDomainSystem(*state.matrix, state.residual, state.update))
+                        markFailed(state);
+                }
+                catch (...) {
+                    markFailed(state);
+                }
+            }
+            solveTimer_.stop();
+
+            updateTimer_.start();
+            for (auto& state : states) {
+                if (!state.active)
+                    continue;
+                else if (!std::isfinite(state.update.one_norm())) {
+                    markFailed(state);
+                    continue;
+                }
+
+                const auto& cells = localDomains_[state.domainIdx].cells;
+                for (std::size_t i = 0; i < cells.size(); ++i) {
+                    const unsigned dofIdx = cells[i];
+                    const PrimaryVariables currentValue(nextSolution[dofIdx]);
+                    asImp_().updatePrimaryVariables_(dofIdx,
+                                                     nextSolution[dofIdx],
+                                                     currentValue,
+                                                     state.update[i],
+                                                     state.residual[i]);
+                }
+            }
+
+            // the subdomains are distributed amongst the threads, so the update of the
+            // cells of a subdomain must not open another parallel region
+#ifdef _OPENMP
+#pragma omp parallel if (concurrent)
+#endif
+            {
+                ElementContext elemCtx(simulator_);
+#ifdef _OPENMP
+#pragma omp for
+#endif
+                for (unsigned i = 0; i < states.size(); ++i) {
+                    auto& state = states[i];
+                    if (!state.active)
+                        continue;
+
+                    try {
+                        for (int cellIdx : localDomains_[state.domainIdx].cells)
+                            model().invalidateAndUpdateIntensiveQuantities(elemCtx,
+                                                                           static_cast<unsigned>(cellIdx),
+                                                                           /*timeIdx=*/0);
+                    }
+                    catch (...) {
+                        markFailed(state);
+                    }
+                }
+            }
+
+            restoreFailed();
+            updateTimer_.stop();
+        }
+
+        updateTimer_.start();
+        restoreFailed();
+        updateTimer_.stop();
+
+        return numIterations;
+    }
+
+    /*!
+     * \brief Returns the maximum weighted residual of the cells of a subdomain.
+     */
+    Scalar localDomainError_(const NewtonSubDomain& domain,
+                             const GlobalEqVector& currentResidual) const
+    {
+        Scalar result = 0.0;
+        for (int dofIdx : domain.cells) {
+            if (model().dofTotalVolume(dofIdx) <= 0.0)
+                continue;
+
+            const auto& r = currentResidual[dofIdx];
+            for (unsigned eqIdx = 0; eqIdx < r.size(); ++eqIdx)
+                result = std::max<Scalar>(std::abs(r[eqIdx] * model().eqWeight(dofIdx, eqIdx)), result);
+        }
+
+        return result;
+    }
+
+    /*!
+     * \brief Returns the number of heap allocations since a given point and verifies
+     *        that it does not exceed the allowed number.
+     *
+     * \param phase The part of the Newton iteration which was executed
+     * \param numAllocationsBefore The number of allocations before the phase was executed
+     */
+    std::size_t checkAllocations_(const char* phase, std::size_t numAllocationsBefore)
+    {
+        if (!AllocationCounter::isActive())
+            return 0;
+
+        const std::size_t numAllocations = AllocationCounter::numAllocations() - numAllocationsBefore;
+        if (asImp_().verbose_())
+            endIterMsg() << ", " << numAllocations << " allocations during " << phase;
+
+        // the first iteration sets up the linear system and the caches of the time step
+        if (maxAllocationsPerDof_ < 0.0 || numIterations_ == 0)
+            return numAllocations;
+
+        const Scalar maxAllocations = maxAllocationsPerDof_ * model().numTotalDof();
+        if (numAllocations > maxAllocations)
+            throw std::logic_error("The " + std::string(phase) + " of Newton iteration "
+                                   + std::to_string(numIterations_) + " did "
+                                   + std::to_string(numAllocations) + " heap allocations "
+                                   "for " + std::to_string(model().numTotalDof())
+                                   + " degrees of freedom");
+
+        return numAllocations;
+    }
+
     /*!
      * \brief Update the current solution with a delta vector.
      *
@@ -779,6 +1293,7 @@ protected:
                        const SolutionVector&)
     {
         ++numIterations_;
+        EWOMS_PROFILE_COUNT("newton iterations", 1);
 
         const auto& comm = simulator_.gridView().comm();
         bool succeeded = true;
@@ -864,6 +1379,39 @@ protected:
     static bool enableConstraints_()
     { return getPropValue<TypeTag, Properties::EnableConstraints>(); }
 
+    void createTelemetryWriter_()
+    {
+        const int rank = simulator_.gridView().comm().rank();
+        const std::string fileName =
+            problem().outputDir() + "/" + problem().name()
+            + ".newton-telemetry." + std::to_string(rank) + ".jsonl";
+        telemetryWriter_ = std::make_unique<NewtonTelemetryWriter>(fileName, rank);
+    }
+
+    // remember the times accumulated by the timers before the current iteration
+    void beginTelemetryIteration_()
+    {
+        iterationStartTimes_[0] = linearizeTimer_.realTimeElapsed();
+        iterationStartTimes_[1] = solveTimer_.realTimeElapsed();
+        iterationStartTimes_[2] = updateTimer_.realTimeElapsed();
+    }
+
+    void writeTelemetry_(std::size_t linearIterations, bool linearSolverConverged)
+    {
+        NewtonTelemetryWriter::Record record;
+        record.timeStepIdx = simulator_.timeStepIndex();
+        record.time = static_cast<double>(simulator_.time());
+        record.timeStepSize = static_cast<double>(simulator_.timeStepSize());
+        record.iterationIdx = numIterations_;
+        record.error = static_cast<double>(error_);
+        record.linearIterations = linearIterations;
+        record.linearSolverConverged = linearSolverConverged;
+        record.linearizeTime = linearizeTimer_.realTimeElapsed() - iterationStartTimes_[0];
+        record.solveTime = solveTimer_.realTimeElapsed() - iterationStartTimes_[1];
+        record.updateTime = updateTimer_.realTimeElapsed() - iterationStartTimes_[2];
+        telemetryWriter_->write(record);
+    }
+
     Simulator& simulator_;
 
     Timer prePostProcessTimer_;
@@ -875,10 +1423,32 @@ protected:
 
     Scalar error_;
     Scalar lastError_;
+    Scalar initialError_;
     Scalar tolerance_;
 
     // actual number of iterations done so far
     int numIterations_;
+    // number of linearizations done by the current invocation of apply()
+    int numLinearizations_;
+
+    // the subdomains which are solved locally
+    bool enableLocalSolves_;
+    bool threadedLocalSolves_;
+    std::vector<NewtonSubDomain> localDomains_;
+    std::vector<std::unique_ptr<LocalDomainMatrix>> localDomainMatrices_;
+    std::vector<unsigned> localDomainsOverlapCells_;
+    GlobalEqVector localSolveResidual_;
+    unsigned numLocalDomainColors_;
+    std::size_t localDomainsNumDof_;
+    // statistics of the local solves of the current invocation of apply()
+    int numLocalDomainSolves_;
+    int numLocalIterations_;
+
+    // the number of heap allocations done by the current invocation of apply()
+    // and the number which is tolerated per iteration
+    Scalar maxAllocationsPerDof_;
+    std::size_t numLinearizeAllocations_;
+    std::size_t numUpdateAllocations_;
 
     // the linear solver
     LinearSolverBackend linearSolver_;
@@ -891,6 +1461,11 @@ protected:
     // method to disk
     ConvergenceWriter convergenceWriter_;
 
+    // the per-iteration performance metrics of the local process
+    bool enableTelemetry_;
+    std::unique_ptr<NewtonTelemetryWriter> telemetryWriter_;
+    std::array<double, 3> iterationStartTimes_{};
+
 private:
     Implementation& asImp_()
     { return *static_cast<Implementation *>(this); }
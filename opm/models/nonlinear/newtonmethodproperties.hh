@@ -53,6 +53,26 @@ struct NewtonWriteConvergence { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct ConvergenceWriter { using type = UndefinedProperty; };
 
+//! Specifies whether a compact history of the residual and update statistics is
+//! written instead of the full fields if the convergence is written
+template<class TypeTag, class MyTypeTag>
+struct NewtonConvergenceHistory { using type = UndefinedProperty; };
+
+//! The number of degrees of freedom with the largest residual which are recorded by
+//! the convergence history
+template<class TypeTag, class MyTypeTag>
+struct NewtonConvergenceNumWorstCells { using type = UndefinedProperty; };
+
+//! The box of the spatial domain whose degrees of freedom are fully recorded by the
+//! convergence history
+template<class TypeTag, class MyTypeTag>
+struct NewtonConvergenceBoundingBox { using type = UndefinedProperty; };
+
+//! Specifies whether the error, the number of linear iterations and the timings of
+//! each Newton iteration are written to a file by each process
+template<class TypeTag, class MyTypeTag>
+struct NewtonWriteTelemetry { using type = UndefinedProperty; };
+
 /*!
  * \brief The value for the error below which convergence is declared
  *
@@ -82,6 +102,40 @@ struct NewtonTargetIterations { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct NewtonMaxIterations { using type = UndefinedProperty; };
 
+/*!
+ * \brief Specifies whether the subdomains which exhibit a large residual are solved
+ *        locally before each global Newton iteration.
+ *
+ * This requires a linearizer which is able to assemble subdomains that are given as
+ * lists of cells, i.e., the TPFA linearizer.
+ */
+template<class TypeTag, class MyTypeTag>
+struct NewtonLocalSolves { using type = UndefinedProperty; };
+
+//! The number of cells at which the subdomains of the local solves should aim at
+template<class TypeTag, class MyTypeTag>
+struct NewtonLocalDomainSize { using type = UndefinedProperty; };
+
+//! The maximum number of Newton iterations used to solve a subdomain
+template<class TypeTag, class MyTypeTag>
+struct NewtonLocalMaxIterations { using type = UndefinedProperty; };
+
+//! Specifies whether subdomains which are not adjacent are solved concurrently by
+//! multiple threads
+template<class TypeTag, class MyTypeTag>
+struct NewtonThreadedLocalSolves { using type = UndefinedProperty; };
+
+/*!
+ * \brief The maximum number of heap allocations per degree of freedom which may be done
+ *        during the linearization or the update of a Newton iteration.
+ *
+ * This is only checked if the program counts its allocations (see
+ * Opm::AllocationCounter) and if the value is not negative. The first iteration of
+ * each time step is exempt because it sets up the data structures.
+ */
+template<class TypeTag, class MyTypeTag>
+struct NewtonMaxAllocationsPerDof { using type = UndefinedProperty; };
+
 } // end namespace  Opm::Properties
 
 #endif
@@ -0,0 +1,296 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Helpers to partition the grid into subdomains which are solved locally by the
+ *        Newton method.
+ */
+#ifndef EWOMS_NEWTON_SUBDOMAIN_HH
+#define EWOMS_NEWTON_SUBDOMAIN_HH
+
+#include <dune/common/exceptions.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/preconditioners.hh>
+#include <dune/istl/solvers.hh>
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace Opm {
+
+/*!
+ * \ingroup Newton
+ *
+ * \brief Specifies whether a linearizer is able to linearize subdomains which are given
+ *        as lists of cells.
+ *
+ * This is the case if the linearizer exhibits a static linearizesCellSubDomains member
+ * which is true. Linearizers which do not provide the member are assumed not to support
+ * subdomains.
+ */
+template <class Linearizer, class Enable = void>
+struct LinearizesCellSubDomains : public std::false_type
+{};
+
+template <class Linearizer>
+struct LinearizesCellSubDomains<Linearizer, std::void_t<decltype(Linearizer::linearizesCellSubDomains)> >
+    : public std::bool_constant<Linearizer::linearizesCellSubDomains>
+{};
+
+/*!
+ * \ingroup Newton
+ *
+ * \brief A part of the local grid which is linearized and solved independently of the
+ *        remaining grid.
+ *
+ * The subdomain is specified as a list of cells which is the format expected by
+ * TpfaLinearizer::linearizeDomain().
+ */
+struct NewtonSubDomain
+{
+    //! The index of the subdomain
+    unsigned index = 0;
+
+    //! Two adjacent subdomains never have the same color
+    unsigned color = 0;
+
+    //! The indices of the cells which belong to the subdomain in ascending order
+    std::vector<int> cells;
+};
+
+/*!
+ * \ingroup Newton
+ *
+ * \brief Partition the cells of a process into subdomains of approximately equal size.
+ *
+ * The subdomains are grown from seed cells in a breadth-first manner using the
+ * connectivity given by the sparsity pattern of the Jacobian matrix, so they are compact
+ * and their size is independent of the structure of the grid. Subdomains which end up
+ * much smaller than requested because they are enclosed by other subdomains are merged
+ * into one of their neighbors. Finally, the subdomains are colored so that subdomains of
+ * the same color do not share any face.
+ *
+ * \param matrix The matrix which specifies the connectivity of the cells
+ * \param isInterior Specifies for each cell whether it ought to be part of a subdomain
+ * \param domainSize The number of cells which a subdomain should contain
+ */
+template <class Matrix>
+std::vector<NewtonSubDomain> partitionNewtonSubDomains(const Matrix& matrix,
+                                                       const std::vector<bool>& isInterior,
+                                                       std::size_t domainSize)
+{
+    const std::size_t numCells = isInterior.size();
+    domainSize = std::max<std::size_t>(domainSize, 1);
+
+    std::vector<NewtonSubDomain> domains;
+    std::vector<int> domainIdx(numCells, -1);
+    std::vector<int> front;
+    for (std::size_t seedIdx = 0; seedIdx < numCells; ++seedIdx) {
+        if (!isInterior[seedIdx] || domainIdx[seedIdx] >= 0)
+            continue;
+
+        const int curDomainIdx = static_cast<int>(domains.size());
+        int neighborDomainIdx = -1;
+
+        front.clear();
+        front.push_back(static_cast<int>(seedIdx));
+        domainIdx[seedIdx] = curDomainIdx;
+        for (std::size_t headIdx = 0; headIdx < front.size(); ++headIdx) {
+            const auto& row = matrix[front[headIdx]];
+            for (auto colIt = row.begin(); colIt != row.end(); ++colIt) {
+                const std::size_t nbIdx = colIt.index();
+                if (nbIdx >= numCells || !isInterior[nbIdx])
+                    continue;
+                else if (domainIdx[nbIdx] >= 0) {
+                    if (domainIdx[nbIdx] != curDomainIdx)
+                        neighborDomainIdx = domainIdx[nbIdx];
+                    continue;
+                }
+                else if (front.size() >= domainSize)
+                    continue;
+
+                domainIdx[nbIdx] = curDomainIdx;
+                front.push_back(static_cast<int>(nbIdx));
+            }
+        }
+
+        if (front.size() < domainSize/4 && neighborDomainIdx >= 0) {
+            // the cells are enclosed by other subdomains. instead of creating a tiny
+            // subdomain, add them to one of the neighbors.
+            auto& neighborCells = domains[neighborDomainIdx].cells;
+            for (int cellIdx : front)
+                domainIdx[cellIdx] = neighborDomainIdx;
+            neighborCells.insert(neighborCells.end(), front.begin(), front.end());
+            continue;
+        }
+
+        domains.emplace_back();
+        domains.back().index = static_cast<unsigned>(curDomainIdx);
+        domains.back().cells = front;
+    }
+
+    for (auto& domain : domains)
+        std::sort(domain.cells.begin(), domain.cells.end());
+
+    // greedily color the subdomains
+    std::vector<int> color(domains.size(), -1);
+    std::vector<bool> colorUsed;
+    for (auto& domain : domains) {
+        colorUsed.assign(colorUsed.size(), false);
+        for (int cellIdx : domain.cells) {
+            const auto& row = matrix[cellIdx];
+            for (auto colIt = row.begin(); colIt != row.end(); ++colIt) {
+                const std::size_t nbIdx = colIt.index();
+                if (nbIdx >= numCells || domainIdx[nbIdx] < 0)
+                    continue;
+
+                const int nbColor = color[domainIdx[nbIdx]];
+                if (nbColor >= 0) {
+                    if (static_cast<std::size_t>(nbColor) >= colorUsed.size())
+                        colorUsed.resize(nbColor + 1, false);
+                    colorUsed[nbColor] = true;
+                }
+            }
+        }
+
+        const auto unusedIt = std::find(colorUsed.begin(), colorUsed.end(), false);
+        color[domain.index] = static_cast<int>(unusedIt - colorUsed.begin());
+        domain.color = static_cast<unsigned>(color[domain.index]);
+    }
+
+    return domains;
+}
+
+/*!
+ * \ingroup Newton
+ *
+ * \brief Extract the linear system of equations of a subdomain from the global one.
+ *
+ * Couplings to cells outside of the subdomain are ignored, i.e., the solution of the
+ * neighborhood of the subdomain is kept fixed. If the local matrix already exhibits one
+ * row per cell of the subdomain, it is assumed to have been set up by a previous call
+ * for the same subdomain and global sparsity pattern, so only its entries are updated.
+ */
+template <class Matrix, class Vector>
+void extractNewtonSubDomainSystem(const Matrix& globalMatrix,
+                                  const Vector& globalResidual,
+                                  const NewtonSubDomain& domain,
+                                  Matrix& localMatrix,
+                                  Vector& localResidual)
+{
+    const auto& cells = domain.cells;
+    const std::size_t numLocal = cells.size();
+
+    const auto localIndex = [&cells, numLocal](std::size_t globalIdx) {
+        const auto it = std::lower_bound(cells.begin(), cells.end(), static_cast<int>(globalIdx));
+        if (it == cells.end() || static_cast<std::size_t>(*it) != globalIdx)
+            return numLocal;
+        return static_cast<std::size_t>(it - cells.begin());
+    };
+
+    if (localMatrix.N() != numLocal) {
+        localMatrix.setBuildMode(Matrix::random);
+        localMatrix.setSize(numLocal, numLocal);
+        for (std::size_t i = 0; i < numLocal; ++i) {
+            const auto& row = globalMatrix[cells[i]];
+            std::size_t rowSize = 0;
+            for (auto colIt = row.begin(); colIt != row.end(); ++colIt)
+                if (localIndex(colIt.index()) < numLocal)
+                    ++rowSize;
+            localMatrix.setrowsize(i, rowSize);
+        }
+        localMatrix.endrowsizes();
+
+        for (std::size_t i = 0; i < numLocal; ++i) {
+            const auto& row = globalMatrix[cells[i]];
+            for (auto colIt = row.begin(); colIt != row.end(); ++colIt) {
+                const std::size_t j = localIndex(colIt.index());
+                if (j < numLocal)
+                    localMatrix.addindex(i, j);
+            }
+        }
+        localMatrix.endindices();
+    }
+
+    localResidual.resize(numLocal);
+    for (std::size_t i = 0; i < numLocal; ++i) {
+        const auto& row = globalMatrix[cells[i]];
+        for (auto colIt = row.begin(); colIt != row.end(); ++colIt) {
+            const std::size_t j = localIndex(colIt.index());
+            if (j < numLocal)
+                localMatrix[i][j] = *colIt;
+        }
+        localResidual[i] = globalResidual[cells[i]];
+    }
+}
+
+/*!
+ * \ingroup Newton
+ *
+ * \brief Solve the linear system of equations of a subdomain.
+ *
+ * The systems of subdomains are small, so a BiCGStab solver preconditioned by ILU(0)
+ * is used. Since the result is only used to update the solution of a subdomain, it does
+ * not need to be very accurate.
+ *
+ * \return true if the linear solver converged
+ */
+template <class Matrix, class Vector>
+bool solveNewtonSubDomainSystem(const Matrix& localMatrix,
+                                const Vector& localResidual,
+                                Vector& localUpdate,
+                                double reduction = 1e-2,
+                                int maxIterations = 200)
+{
+    localUpdate.resize(localResidual.size());
+    localUpdate = 0.0;
+
+    // the linear solver overwrites the right hand side
+    Vector rhs(localResidual);
+
+    try {
+        Dune::MatrixAdapter<Matrix, Vector, Vector> linearOperator(localMatrix);
+        Dune::SeqILU<Matrix, Vector, Vector> preconditioner(localMatrix, /*relaxation=*/1.0);
+        Dune::BiCGSTABSolver<Vector> solver(linearOperator,
+                                            preconditioner,
+                                            reduction,
+                                            maxIterations,
+                                            /*verbosity=*/0);
+
+        Dune::InverseOperatorResult result;
+        solver.apply(localUpdate, rhs, result);
+        return result.converged;
+    }
+    catch (const Dune::Exception&) {
+        // e.g., a singular diagonal block
+        return false;
+    }
+}
+
+} // namespace Opm
+
+#endif
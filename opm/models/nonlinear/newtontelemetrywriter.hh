@@ -0,0 +1,127 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Opm::NewtonTelemetryWriter
+ */
+#ifndef EWOMS_NEWTON_TELEMETRY_WRITER_HH
+#define EWOMS_NEWTON_TELEMETRY_WRITER_HH
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace Opm {
+
+/*!
+ * \ingroup Newton
+ *
+ * \brief Writes a few performance metrics for each Newton iteration to a file.
+ *
+ * Each process writes its own file which contains one JSON object per line and
+ * iteration, so the files can be concatenated and processed with standard tools. The
+ * records are buffered in memory and only written to the file by flush(), i.e.,
+ * writing a record does neither involve any I/O nor any communication.
+ */
+class NewtonTelemetryWriter
+{
+public:
+    //! The metrics which are recorded for a single Newton iteration
+    struct Record
+    {
+        int timeStepIdx;
+        double time;
+        double timeStepSize;
+        int iterationIdx;
+        double error;
+        std::size_t linearIterations;
+        bool linearSolverConverged;
+        double linearizeTime;
+        double solveTime;
+        double updateTime;
+    };
+
+    NewtonTelemetryWriter(const std::string& fileName, int rank)
+        : rank_(rank)
+        , os_(fileName)
+    {
+        if (!os_)
+            throw std::runtime_error("Could not open the Newton telemetry file '" + fileName + "'");
+    }
+
+    ~NewtonTelemetryWriter()
+    { flush(); }
+
+    /*!
+     * \brief Append the metrics of an iteration to the buffer.
+     */
+    void write(const Record& record)
+    {
+        char line[512];
+        const int len =
+            std::snprintf(line, sizeof(line),
+                          "{\"rank\":%d,\"timeStep\":%d,\"time\":%.9g,\"timeStepSize\":%.9g,"
+                          "\"iteration\":%d,\"error\":%.6g,\"linearIterations\":%zu,"
+                          "\"linearSolverConverged\":%s,\"linearizeTime\":%.6g,"
+                          "\"solveTime\":%.6g,\"updateTime\":%.6g}\n",
+                          rank_,
+                          record.timeStepIdx,
+                          record.time,
+                          record.timeStepSize,
+                          record.iterationIdx,
+                          record.error,
+                          record.linearIterations,
+                          record.linearSolverConverged ? "true" : "false",
+                          record.linearizeTime,
+                          record.solveTime,
+                          record.updateTime);
+        if (len > 0)
+            buffer_.append(line, std::min(static_cast<std::size_t>(len), sizeof(line) - 1));
+    }
+
+    /*!
+     * \brief Write all buffered records to the file.
+     */
+    void flush()
+    {
+        if (buffer_.empty())
+            return;
+
+        os_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        os_.flush();
+        buffer_.clear();
+    }
+
+private:
+    int rank_;
+    std::ofstream os_;
+    std::string buffer_;
+};
+
+} // namespace Opm
+
+#endif
@@ -0,0 +1,109 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Opm::FirstTouchAllocator
+ */
+#ifndef EWOMS_FIRST_TOUCH_ALLOCATOR_HH
+#define EWOMS_FIRST_TOUCH_ALLOCATOR_HH
+
+#include <opm/models/utils/alignedallocator.hh>
+
+#include <cstddef>
+
+namespace Opm {
+
+/*!
+ * \brief Touch the memory pages of a freshly allocated array using all threads.
+ *
+ * Operating systems usually place a memory page on the NUMA node of the thread which
+ * first writes to it. If the array is touched using the same static partition of the
+ * index range as the loops which later process it, each thread mostly accesses memory
+ * which is local to its socket.
+ */
+inline void firstTouchPages(void* ptr, std::size_t size)
+{
+    static constexpr std::size_t pageSize = 4096;
+
+    // small arrays are not worth the overhead of a parallel region
+    if (size < 16*pageSize)
+        return;
+
+    char* bytes = static_cast<char*>(ptr);
+    const long numPages = static_cast<long>((size + pageSize - 1)/pageSize);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (long pageIdx = 0; pageIdx < numPages; ++pageIdx)
+        bytes[pageIdx*pageSize] = 0;
+}
+
+/*!
+ * \brief An aligned allocator which distributes the memory pages of large arrays
+ *        amongst the NUMA nodes of the threads that will use them.
+ *
+ * The pages are touched in parallel directly after allocation, i.e., before the
+ * container constructs its elements using the main thread.
+ */
+template <class T, std::size_t Alignment = alignof(T)>
+class FirstTouchAllocator : public aligned_allocator<T, Alignment>
+{
+    using ParentType = aligned_allocator<T, Alignment>;
+
+public:
+    using typename ParentType::pointer;
+    using typename ParentType::size_type;
+    using typename ParentType::const_void_pointer;
+
+    template <class U>
+    struct rebind {
+        using other = FirstTouchAllocator<U, Alignment>;
+    };
+
+    FirstTouchAllocator() noexcept = default;
+
+    template <class U>
+    FirstTouchAllocator(const FirstTouchAllocator<U, Alignment>&) noexcept
+    {}
+
+    pointer allocate(size_type size, const_void_pointer hint = 0)
+    {
+        pointer ptr = ParentType::allocate(size, hint);
+        firstTouchPages(ptr, size*sizeof(T));
+        return ptr;
+    }
+};
+
+template <class T1, class T2, std::size_t Alignment>
+inline bool operator==(const FirstTouchAllocator<T1, Alignment>&,
+                       const FirstTouchAllocator<T2, Alignment>&) noexcept
+{ return true; }
+
+template <class T1, class T2, std::size_t Alignment>
+inline bool operator!=(const FirstTouchAllocator<T1, Alignment>&,
+                       const FirstTouchAllocator<T2, Alignment>&) noexcept
+{ return false; }
+
+} // namespace Opm
+
+#endif
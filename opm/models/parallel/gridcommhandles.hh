@@ -32,6 +32,9 @@
 #include <dune/grid/common/datahandleif.hh>
 #include <dune/common/version.hh>
 
+#include <map>
+#include <vector>
+
 namespace Opm {
 
 /*!
@@ -279,6 +282,70 @@ private:
     Container& container_;
 };
 
+/*!
+ * \brief Data handle which moves the values attached to the entities of a codimension
+ *        to their new owner if the grid is re-partitioned.
+ *
+ * Since the indices of the entities change during the re-partitioning, the values are
+ * stored by the global identifiers of the entities. Each entity carries the same number
+ * of values, e.g., one per time level of the solution.
+ */
+template <class FieldType, class IdSet, int commCodim>
+class GridCommHandleMigrate
+    : public Dune::CommDataHandleIF<GridCommHandleMigrate<FieldType, IdSet, commCodim>,
+                                    FieldType>
+{
+public:
+    using Container = std::map<typename IdSet::IdType, std::vector<FieldType> >;
+
+    GridCommHandleMigrate(Container& container, const IdSet& idSet, size_t numValues)
+        : idSet_(idSet), container_(container), numValues_(numValues)
+    {}
+
+    bool contains(int, int codim) const
+    {
+        // return true if the codim is the same as the codim which we
+        // are asked to communicate with.
+        return codim == commCodim;
+    }
+
+#if DUNE_VERSION_LT(DUNE_GRID, 2, 8)
+    bool fixedsize(int, int) const
+#else
+    bool fixedSize(int, int) const
+#endif
+    {
+        // every entity carries the same number of values
+        return true;
+    }
+
+    template <class EntityType>
+    size_t size(const EntityType&) const
+    { return numValues_; }
+
+    template <class MessageBufferImp, class EntityType>
+    void gather(MessageBufferImp& buff, const EntityType& e) const
+    {
+        const auto& values = container_.at(idSet_.id(e));
+        for (const auto& value : values)
+            buff.write(value);
+    }
+
+    template <class MessageBufferImp, class EntityType>
+    void scatter(MessageBufferImp& buff, const EntityType& e, size_t n)
+    {
+        auto& values = container_[idSet_.id(e)];
+        values.resize(n);
+        for (auto& value : values)
+            buff.read(value);
+    }
+
+private:
+    const IdSet& idSet_;
+    Container& container_;
+    size_t numValues_;
+};
+
 } // namespace Opm
 
 #endif
@@ -33,49 +33,139 @@
 
 #include <stddef.h>
 
-#include <type_traits>
 #include <cassert>
+#include <memory>
+#include <type_traits>
+#include <vector>
 
 namespace Opm {
 
 /*!
  * \brief Simplifies handling of buffers to be used in conjunction with MPI
+ *
+ * Besides one-off send and receive operations, a buffer can be bound to a peer process
+ * via persistent requests (initPersistentSend(), initPersistentReceive()). These are
+ * intended for communication patterns which are repeated many times, e.g., halo
+ * exchanges within linear solvers, and are then only triggered via start() and
+ * completed via wait() or waitAll(). Since persistent requests refer to the memory of the
+ * buffer, they are released if the buffer is resized.
+ *
+ * The memory of the buffer is only reallocated if it grows. A special allocator, e.g.,
+ * one which provides page-locked memory for the network hardware, can be specified as
+ * the second template parameter.
  */
-template <class DataType>
+template <class DataType, class Allocator = std::allocator<DataType> >
 class MpiBuffer
 {
 public:
     MpiBuffer()
     {
-        data_ = NULL;
-        dataSize_ = 0;
-
         setMpiDataType_();
         updateMpiDataSize_();
     }
 
     MpiBuffer(size_t size)
+        : data_(size)
     {
-        data_ = new DataType[size];
-        dataSize_ = size;
+        setMpiDataType_();
+        updateMpiDataSize_();
+    }
 
+#if HAVE_MPI
+    /*!
+     * \brief Create a buffer which communicates via a given MPI communicator and
+     *        message tag.
+     */
+    MpiBuffer(size_t size, MPI_Comm comm, int tag = 0)
+        : data_(size)
+        , mpiComm_(comm)
+        , mpiTag_(tag)
+    {
         setMpiDataType_();
         updateMpiDataSize_();
     }
+#endif // HAVE_MPI
 
-    MpiBuffer(const MpiBuffer&) = default;
+    /*!
+     * \brief Copy constructor.
+     *
+     * Only the data and the communication parameters are copied, the pending and
+     * persistent requests of the original buffer stay with it.
+     */
+    MpiBuffer(const MpiBuffer& other)
+        : data_(other.data_)
+    {
+#if HAVE_MPI
+        mpiComm_ = other.mpiComm_;
+        mpiTag_ = other.mpiTag_;
+#endif // HAVE_MPI
+        setMpiDataType_();
+        updateMpiDataSize_();
+    }
+
+    /*!
+     * \brief Assignment operator.
+     *
+     * Like the copy constructor, this only copies the data and the communication
+     * parameters.
+     */
+    MpiBuffer& operator=(const MpiBuffer& other)
+    {
+        if (this == &other)
+            return *this;
+
+        freePersistentRequest_();
+        data_ = other.data_;
+#if HAVE_MPI
+        mpiComm_ = other.mpiComm_;
+        mpiTag_ = other.mpiTag_;
+#endif // HAVE_MPI
+        updateMpiDataSize_();
+        return *this;
+    }
 
     ~MpiBuffer()
-    { delete[] data_; }
+    { freePersistentRequest_(); }
+
+#if HAVE_MPI
+    /*!
+     * \brief Set the MPI communicator and the message tag used by the buffer.
+     *
+     * By default, MPI_COMM_WORLD and tag 0 are used.
+     */
+    void setCommunicator(MPI_Comm comm, int tag = 0)
+    {
+        freePersistentRequest_();
+        mpiComm_ = comm;
+        mpiTag_ = tag;
+    }
+
+    /*!
+     * \brief Returns the MPI communicator used by the buffer.
+     */
+    MPI_Comm communicator() const
+    { return mpiComm_; }
+
+    /*!
+     * \brief Returns the message tag used by the buffer.
+     */
+    int tag() const
+    { return mpiTag_; }
+#endif // HAVE_MPI
 
     /*!
      * \brief Set the size of the buffer
+     *
+     * The contents of the buffer are undefined afterwards. The storage is only
+     * reallocated if the buffer grows beyond its capacity.
      */
     void resize(size_t newSize)
     {
-        delete[] data_;
-        data_ = new DataType[newSize];
-        dataSize_ = newSize;
+        if (newSize == data_.size())
+            return;
+
+        freePersistentRequest_();
+        data_.resize(newSize);
         updateMpiDataSize_();
     }
 
@@ -85,18 +175,19 @@ public:
     void send([[maybe_unused]] unsigned peerRank)
     {
 #if HAVE_MPI
-        MPI_Isend(data_,
+        freePersistentRequest_();
+        MPI_Isend(data_.data(),
                   static_cast<int>(mpiDataSize_),
                   mpiDataType_,
                   static_cast<int>(peerRank),
-                  0, // tag
-                  MPI_COMM_WORLD,
+                  mpiTag_,
+                  mpiComm_,
                   &mpiRequest_);
 #endif
     }
 
     /*!
-     * \brief Wait until the buffer was send to the peer completely.
+     * \brief Wait until the pending operation of the buffer has completed.
      */
     void wait()
     {
@@ -111,29 +202,168 @@ public:
     void receive([[maybe_unused]] unsigned peerRank)
     {
 #if HAVE_MPI
-        MPI_Recv(data_,
+        MPI_Recv(data_.data(),
                  static_cast<int>(mpiDataSize_),
                  mpiDataType_,
                  static_cast<int>(peerRank),
-                 0, // tag
-                 MPI_COMM_WORLD,
+                 mpiTag_,
+                 mpiComm_,
                  &mpiStatus_);
-        assert(!mpiStatus_.MPI_ERROR);
 #endif // HAVE_MPI
     }
 
+    /*!
+     * \brief Start receiving the buffer asyncronously from a peer rank.
+     *
+     * The data may only be accessed after wait() or waitAll() was called.
+     */
+    void startReceive([[maybe_unused]] unsigned peerRank)
+    {
+#if HAVE_MPI
+        freePersistentRequest_();
+        MPI_Irecv(data_.data(),
+                  static_cast<int>(mpiDataSize_),
+                  mpiDataType_,
+                  static_cast<int>(peerRank),
+                  mpiTag_,
+                  mpiComm_,
+                  &mpiRequest_);
+#endif // HAVE_MPI
+    }
+
+    /*!
+     * \brief Bind the buffer to a persistent request which sends its contents to a
+     *        peer rank.
+     *
+     * The message is sent each time start() is called.
+     */
+    void initPersistentSend([[maybe_unused]] unsigned peerRank)
+    {
+#if HAVE_MPI
+        freePersistentRequest_();
+        MPI_Send_init(data_.data(),
+                      static_cast<int>(mpiDataSize_),
+                      mpiDataType_,
+                      static_cast<int>(peerRank),
+                      mpiTag_,
+                      mpiComm_,
+                      &mpiRequest_);
+        persistent_ = true;
+#endif // HAVE_MPI
+    }
+
+    /*!
+     * \brief Bind the buffer to a persistent request which receives its contents from a
+     *        peer rank.
+     *
+     * A message is received each time start() is called.
+     */
+    void initPersistentReceive([[maybe_unused]] unsigned peerRank)
+    {
+#if HAVE_MPI
+        freePersistentRequest_();
+        MPI_Recv_init(data_.data(),
+                      static_cast<int>(mpiDataSize_),
+                      mpiDataType_,
+                      static_cast<int>(peerRank),
+                      mpiTag_,
+                      mpiComm_,
+                      &mpiRequest_);
+        persistent_ = true;
+#endif // HAVE_MPI
+    }
+
+    /*!
+     * \brief Returns true iff the buffer is bound to a persistent request.
+     */
+    bool isPersistent() const
+    { return persistent_; }
+
+    /*!
+     * \brief Start the operation of the persistent request of the buffer.
+     */
+    void start()
+    {
+        assert(persistent_);
+#if HAVE_MPI
+        MPI_Start(&mpiRequest_);
+#endif // HAVE_MPI
+    }
+
+    /*!
+     * \brief Start the persistent requests of a range of buffers.
+     *
+     * The iterators must point to pointer-like objects to MpiBuffers.
+     */
+    template <class BufferPtrIterator>
+    static void startAll(BufferPtrIterator begin, BufferPtrIterator end)
+    {
+        for (; begin != end; ++begin)
+            (*begin)->start();
+    }
+
+    //! Storage for the requests of the buffers passed to waitAll()
+#if HAVE_MPI
+    using RequestStorage = std::vector<MPI_Request>;
+#else
+    using RequestStorage = std::vector<int>;
+#endif
+
+    /*!
+     * \brief Wait until the pending operations of a range of buffers have completed.
+     *
+     * The iterators must point to pointer-like objects to MpiBuffers. The requests of
+     * the buffers are gathered in storage which is provided by the caller, so repeated
+     * calls do not allocate memory. In contrast to wait(), the status objects of the
+     * buffers are not updated.
+     */
+    template <class BufferPtrIterator>
+    static void waitAll([[maybe_unused]] BufferPtrIterator begin,
+                        [[maybe_unused]] BufferPtrIterator end,
+                        [[maybe_unused]] RequestStorage& requests)
+    {
+#if HAVE_MPI
+        requests.clear();
+        for (auto it = begin; it != end; ++it)
+            requests.push_back((*it)->request());
+        if (requests.empty())
+            return;
+
+        MPI_Waitall(static_cast<int>(requests.size()), requests.data(), MPI_STATUSES_IGNORE);
+
+        // non-persistent requests are deallocated by MPI_Waitall()
+        size_t i = 0;
+        for (auto it = begin; it != end; ++it, ++i)
+            (*it)->request() = requests[i];
+#endif // HAVE_MPI
+    }
+
+    /*!
+     * \brief Wait until the pending operations of a range of buffers have completed.
+     *
+     * This allocates the storage for the requests on each call.
+     */
+    template <class BufferPtrIterator>
+    static void waitAll(BufferPtrIterator begin, BufferPtrIterator end)
+    {
+        RequestStorage requests;
+        waitAll(begin, end, requests);
+    }
+
 #if HAVE_MPI
     /*!
      * \brief Returns the current MPI_Request object.
      *
-     * This object is only well defined after the send() method.
+     * This object is only well defined after the send(), startReceive() and
+     * initPersistent*() methods.
      */
     MPI_Request& request()
     { return mpiRequest_; }
     /*!
      * \brief Returns the current MPI_Request object.
      *
-     * This object is only well defined after the send() method.
+     * This object is only well defined after the send(), startReceive() and
+     * initPersistent*() methods.
      */
     const MPI_Request& request() const
     { return mpiRequest_; }
@@ -158,14 +388,26 @@ public:
      * \brief Returns the number of data objects in the buffer
      */
     size_t size() const
-    { return dataSize_; }
+    { return data_.size(); }
+
+    /*!
+     * \brief Provide access to the raw memory of the buffer.
+     */
+    DataType* data()
+    { return data_.data(); }
+
+    /*!
+     * \brief Provide access to the raw memory of the buffer.
+     */
+    const DataType* data() const
+    { return data_.data(); }
 
     /*!
      * \brief Provide access to the buffer data.
      */
     DataType& operator[](size_t i)
     {
-        assert(i < dataSize_);
+        assert(i < data_.size());
         return data_[i];
     }
 
@@ -174,7 +416,7 @@ public:
      */
     const DataType& operator[](size_t i) const
     {
-        assert(i < dataSize_);
+        assert(i < data_.size());
         return data_[i];
     }
 
@@ -218,18 +460,37 @@ private:
     void updateMpiDataSize_()
     {
 #if HAVE_MPI
-        mpiDataSize_ = dataSize_;
+        mpiDataSize_ = data_.size();
         if (mpiDataType_ == MPI_BYTE)
             mpiDataSize_ *= sizeof(DataType);
 #endif // HAVE_MPI
     }
 
-    DataType *data_;
-    size_t dataSize_;
+    // persistent requests refer to the memory of the buffer, so they need to be
+    // released before it is reallocated
+    void freePersistentRequest_()
+    {
+        if (!persistent_)
+            return;
+
+#if HAVE_MPI
+        int finalized;
+        MPI_Finalized(&finalized);
+        if (!finalized && mpiRequest_ != MPI_REQUEST_NULL)
+            MPI_Request_free(&mpiRequest_);
+        mpiRequest_ = MPI_REQUEST_NULL;
+#endif // HAVE_MPI
+        persistent_ = false;
+    }
+
+    std::vector<DataType, Allocator> data_;
+    bool persistent_{false};
 #if HAVE_MPI
     size_t mpiDataSize_;
     MPI_Datatype mpiDataType_;
-    MPI_Request mpiRequest_;
+    MPI_Comm mpiComm_{MPI_COMM_WORLD};
+    int mpiTag_{0};
+    MPI_Request mpiRequest_{MPI_REQUEST_NULL};
     MPI_Status mpiStatus_;
 #endif // HAVE_MPI
 };
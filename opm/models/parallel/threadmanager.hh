@@ -31,11 +31,28 @@
 #include <omp.h>
 #endif
 
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#if HAVE_MPI
+#include <mpi.h>
+#endif
+
 #include <opm/models/utils/parametersystem.hh>
 #include <opm/models/utils/propertysystem.hh>
 
 #include <dune/common/version.hh>
 
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 namespace Opm {
 
 /*!
@@ -62,6 +79,12 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, int, ThreadsPerProcess,
                              "The maximum number of threads to be instantiated per process "
                              "('-1' means 'automatic')");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, ThreadPinning,
+                             "Bind the threads of each process to the CPUs available to it. "
+                             "Possible values: 'none', 'compact' (consecutive threads on "
+                             "consecutive CPUs), 'spread' (threads evenly distributed over "
+                             "the NUMA nodes). If several processes on a machine may use the same CPUs, "
+                             "each of them is restricted to a disjoint share of them");
     }
 
     /*!
@@ -109,6 +132,43 @@ public:
         // get the number of threads which are used in the end.
         numThreads_ = omp_get_max_threads();
 #endif
+
+        detectTopology_();
+
+        if (queryCommandLineParameter) {
+            pinning_ = EWOMS_GET_PARAM(TypeTag, std::string, ThreadPinning);
+            if (pinning_ != "none" && pinning_ != "compact" && pinning_ != "spread")
+                throw std::invalid_argument("Unknown thread pinning strategy '"+pinning_+"'. "
+                                            "Valid values are 'none', 'compact' and 'spread'");
+#if !defined(__linux__)
+            if (pinning_ != "none")
+                throw std::invalid_argument("Thread pinning is only available on Linux!");
+#endif
+            if (pinning_ != "none" && !restrictToProcessShare_())
+                pinning_ = "none";
+            if (pinning_ != "none")
+                pinThreads_();
+        }
+    }
+
+    /*!
+     * \brief Return the number of NUMA nodes which feature CPUs available to the current
+     *        process.
+     */
+    static unsigned numNumaNodes()
+    { return static_cast<unsigned>(nodeCpus_.size()); }
+
+    /*!
+     * \brief Print the number of threads, the detected NUMA topology and the pinning of
+     *        the threads.
+     */
+    static void printTopology(std::ostream& os)
+    {
+        os << "Threads per process: " << maxThreads()
+           << ", NUMA nodes: " << numNumaNodes() << " (available CPUs per node:";
+        for (const auto& cpus : nodeCpus_)
+            os << " " << cpus.size();
+        os << "), thread pinning: " << pinning_ << "\n";
     }
 
     /*!
@@ -130,11 +190,198 @@ public:
     }
 
 private:
+    // parse a list of CPUs in the format used by the Linux kernel, e.g. "0-3,8,10-11"
+    static std::vector<int> parseCpuList_(const std::string& cpuList)
+    {
+        std::vector<int> result;
+        std::istringstream iss(cpuList);
+        std::string range;
+        while (std::getline(iss, range, ',')) {
+            if (range.empty() || range == "\n")
+                continue;
+
+            const auto dashPos = range.find('-');
+            const int first = std::stoi(range.substr(0, dashPos));
+            const int last = (dashPos == std::string::npos) ? first : std::stoi(range.substr(dashPos + 1));
+            for (int cpuIdx = first; cpuIdx <= last; ++cpuIdx)
+                result.push_back(cpuIdx);
+        }
+        return result;
+    }
+
+    // determine the CPUs of each NUMA node which the process is allowed to use. If the
+    // topology cannot be determined, all CPUs are assumed to be on a single node.
+    static void detectTopology_()
+    {
+        nodeCpus_.clear();
+
+#if defined(__linux__)
+        cpu_set_t allowedSet;
+        CPU_ZERO(&allowedSet);
+        if (sched_getaffinity(/*pid=*/0, sizeof(allowedSet), &allowedSet) != 0)
+            return;
+
+        std::vector<int> allowedCpus;
+        for (int cpuIdx = 0; cpuIdx < CPU_SETSIZE; ++cpuIdx) {
+            if (CPU_ISSET(cpuIdx, &allowedSet))
+                allowedCpus.push_back(cpuIdx);
+        }
+
+        for (unsigned nodeIdx = 0; ; ++nodeIdx) {
+            std::ifstream cpuListFile("/sys/devices/system/node/node"+std::to_string(nodeIdx)+"/cpulist");
+            if (!cpuListFile)
+                break;
+
+            std::string cpuList;
+            std::getline(cpuListFile, cpuList);
+
+            std::vector<int> cpus;
+            for (int cpuIdx : parseCpuList_(cpuList)) {
+                if (CPU_ISSET(cpuIdx, &allowedSet))
+                    cpus.push_back(cpuIdx);
+            }
+            if (!cpus.empty())
+                nodeCpus_.push_back(cpus);
+        }
+
+        if (nodeCpus_.empty() && !allowedCpus.empty())
+            nodeCpus_.push_back(allowedCpus);
+#endif
+    }
+
+    // if several processes on the same machine are allowed to use the same CPUs, assign
+    // a disjoint share of these CPUs to each of them. Returns false if the threads of the
+    // current process cannot be pinned without interfering with the other processes.
+    static bool restrictToProcessShare_()
+    {
+#if defined(__linux__)
+        int shareIdx = 0;
+        int numShares = 1;
+#if HAVE_MPI
+        int mpiInitialized = 0;
+        MPI_Initialized(&mpiInitialized);
+        if (mpiInitialized) {
+            MPI_Comm nodeComm;
+            MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, /*key=*/0, MPI_INFO_NULL, &nodeComm);
+            int nodeRank = 0;
+            MPI_Comm_rank(nodeComm, &nodeRank);
+
+            // count the processes of the machine which are allowed to use each CPU
+            std::vector<int> numCpuUsers(CPU_SETSIZE, 0);
+            for (const auto& nodeCpus : nodeCpus_)
+                for (int cpuIdx : nodeCpus)
+                    numCpuUsers[cpuIdx] = 1;
+            MPI_Allreduce(MPI_IN_PLACE, numCpuUsers.data(), CPU_SETSIZE, MPI_INT, MPI_SUM, nodeComm);
+
+            bool cpusShared = false;
+            for (const auto& nodeCpus : nodeCpus_)
+                for (int cpuIdx : nodeCpus)
+                    cpusShared = cpusShared || numCpuUsers[cpuIdx] > 1;
+
+            // the processes which use the same first CPU are assumed to have been started
+            // with the same set of allowed CPUs
+            const int firstCpu = cpusShared ? nodeCpus_.front().front() : CPU_SETSIZE + nodeRank;
+            MPI_Comm shareComm;
+            MPI_Comm_split(nodeComm, firstCpu, nodeRank, &shareComm);
+            MPI_Comm_rank(shareComm, &shareIdx);
+            MPI_Comm_size(shareComm, &numShares);
+            MPI_Comm_free(&shareComm);
+            MPI_Comm_free(&nodeComm);
+        }
+        else if (numLauncherProcesses_() > 1)
+            // MPI has not been initialized yet, so it is unknown which CPUs are used by
+            // the other processes
+            return false;
+#endif
+
+        if (numShares == 1)
+            return true;
+
+        std::vector<int> cpus;
+        for (const auto& nodeCpus : nodeCpus_)
+            cpus.insert(cpus.end(), nodeCpus.begin(), nodeCpus.end());
+        const std::size_t shareBegin = cpus.size()*shareIdx/numShares;
+        const std::size_t shareEnd = cpus.size()*(shareIdx + 1)/numShares;
+        if (shareBegin == shareEnd)
+            return false;
+
+        std::vector<std::vector<int>> shareNodeCpus;
+        std::size_t cpuPos = 0;
+        for (const auto& nodeCpus : nodeCpus_) {
+            std::vector<int> shareCpus;
+            for (int cpuIdx : nodeCpus) {
+                if (shareBegin <= cpuPos && cpuPos < shareEnd)
+                    shareCpus.push_back(cpuIdx);
+                ++cpuPos;
+            }
+            if (!shareCpus.empty())
+                shareNodeCpus.push_back(shareCpus);
+        }
+        nodeCpus_ = shareNodeCpus;
+#endif
+        return true;
+    }
+
+    // return the number of processes on the current machine which have been started by
+    // the MPI launcher, or 1 if this is unknown
+    static int numLauncherProcesses_()
+    {
+        for (const char* envVar : { "OMPI_COMM_WORLD_LOCAL_SIZE", "MPI_LOCALNRANKS" }) {
+            const char* value = std::getenv(envVar);
+            if (value)
+                return std::max(std::atoi(value), 1);
+        }
+        return 1;
+    }
+
+    // bind each OpenMP thread to a single CPU
+    static void pinThreads_()
+    {
+#if defined(__linux__) && defined(_OPENMP)
+        if (nodeCpus_.empty())
+            return;
+
+        // the order in which the threads get assigned to CPUs
+        std::vector<int> cpus;
+        if (pinning_ == "compact") {
+            for (const auto& nodeCpus : nodeCpus_)
+                cpus.insert(cpus.end(), nodeCpus.begin(), nodeCpus.end());
+        }
+        else {
+            // distribute the threads evenly over the NUMA nodes, but keep consecutive
+            // threads on the same node because they usually process neighboring parts
+            // of the grid
+            const unsigned numNodes = numNumaNodes();
+            const unsigned threadsPerNode = (maxThreads() + numNodes - 1)/numNodes;
+            for (unsigned threadIdx = 0; threadIdx < maxThreads(); ++threadIdx) {
+                const auto& nodeCpus = nodeCpus_[std::min(threadIdx/threadsPerNode, numNodes - 1)];
+                cpus.push_back(nodeCpus[(threadIdx % threadsPerNode) % nodeCpus.size()]);
+            }
+        }
+
+#pragma omp parallel
+        {
+            cpu_set_t cpuSet;
+            CPU_ZERO(&cpuSet);
+            CPU_SET(cpus[threadId() % cpus.size()], &cpuSet);
+            sched_setaffinity(/*pid=*/0, sizeof(cpuSet), &cpuSet);
+        }
+#endif
+    }
+
     static int numThreads_;
+    static std::string pinning_;
+    static std::vector<std::vector<int>> nodeCpus_;
 };
 
 template <class TypeTag>
 int ThreadManager<TypeTag>::numThreads_ = 1;
+
+template <class TypeTag>
+std::string ThreadManager<TypeTag>::pinning_ = "none";
+
+template <class TypeTag>
+std::vector<std::vector<int>> ThreadManager<TypeTag>::nodeCpus_;
 } // namespace Opm
 
 #endif
@@ -0,0 +1,162 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Opm::WeightedLoadBalancing
+ */
+#ifndef EWOMS_WEIGHTED_LOAD_BALANCING_HH
+#define EWOMS_WEIGHTED_LOAD_BALANCING_HH
+
+#if HAVE_DUNE_ALUGRID
+#include <dune/alugrid/grid.hh>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+namespace Opm {
+
+/*!
+ * \brief Re-partitions a grid such that the processes get elements of roughly the same
+ *        total weight.
+ *
+ * The weights are indexed by an element mapper of the leaf grid view. They only need to
+ * be specified for the interior elements of the process. The primary template is used
+ * for grids whose load balancer does not accept weights for the elements.
+ */
+template <class Grid>
+class WeightedLoadBalancing
+{
+public:
+    //! Specifies whether the load balancer of the grid can use weights for the elements
+    static constexpr bool isSupported = false;
+
+    /*!
+     * \brief Re-distribute the grid and move the data attached to its entities.
+     *
+     * \return true iff the partitioning of the grid has changed on the local process
+     */
+    template <class ElementMapper, class DataHandle>
+    static bool repartition(Grid&,
+                            const ElementMapper&,
+                            const std::vector<double>&,
+                            DataHandle&)
+    {
+        throw std::logic_error("The load balancer of the grid does not support weights "
+                               "for the elements");
+    }
+};
+
+#if HAVE_DUNE_ALUGRID
+/*!
+ * \brief Passes the weights of the elements to the load balancer of dune-alugrid.
+ *
+ * dune-alugrid partitions the grid by its macro elements, so the weight of a macro
+ * element is the sum of the weights of its leaf elements. The weights are scaled such
+ * that an element of weight 1 corresponds to an integer weight of 100.
+ */
+template <class Grid, class ElementMapper>
+class AluGridLoadBalanceHandle
+{
+    using Element = typename Grid::template Codim<0>::Entity;
+
+public:
+    AluGridLoadBalanceHandle(const Grid& grid,
+                             const ElementMapper& elementMapper,
+                             const std::vector<double>& elementWeights)
+        : elementMapper_(elementMapper)
+        , elementWeights_(elementWeights)
+        , maxLevel_(grid.maxLevel())
+    {}
+
+    // the partition is computed by the load balancer of the grid, only the weights are
+    // user defined
+    bool userDefinedPartitioning() const
+    { return false; }
+
+    bool userDefinedLoadWeights() const
+    { return true; }
+
+    bool repartition() const
+    { return true; }
+
+    int loadWeight(const Element& element) const
+    {
+        double weight = 0.0;
+        if (element.isLeaf())
+            weight = leafWeight_(element);
+        else {
+            const auto endIt = element.hend(maxLevel_);
+            for (auto it = element.hbegin(maxLevel_); it != endIt; ++it)
+                if (it->isLeaf())
+                    weight += leafWeight_(*it);
+        }
+
+        return std::max(1, static_cast<int>(std::round(100*weight)));
+    }
+
+    int destination(const Element&) const
+    { return -1; }
+
+    bool importRanks(std::set<int>&) const
+    { return false; }
+
+private:
+    double leafWeight_(const Element& element) const
+    {
+        const auto elemIdx = static_cast<std::size_t>(elementMapper_.index(element));
+        return elemIdx < elementWeights_.size() ? elementWeights_[elemIdx] : 0.0;
+    }
+
+    const ElementMapper& elementMapper_;
+    const std::vector<double>& elementWeights_;
+    int maxLevel_;
+};
+
+template <int dim, int dimWorld, Dune::ALUGridElementType elType,
+          Dune::ALUGridRefinementType refinementType, class Comm>
+class WeightedLoadBalancing<Dune::ALUGrid<dim, dimWorld, elType, refinementType, Comm> >
+{
+    using Grid = Dune::ALUGrid<dim, dimWorld, elType, refinementType, Comm>;
+
+public:
+    static constexpr bool isSupported = true;
+
+    template <class ElementMapper, class DataHandle>
+    static bool repartition(Grid& grid,
+                            const ElementMapper& elementMapper,
+                            const std::vector<double>& elementWeights,
+                            DataHandle& dataHandle)
+    {
+        AluGridLoadBalanceHandle<Grid, ElementMapper> ldbHandle(grid, elementMapper, elementWeights);
+        return grid.loadBalance(ldbHandle, dataHandle);
+    }
+};
+#endif // HAVE_DUNE_ALUGRID
+
+} // namespace Opm
+
+#endif
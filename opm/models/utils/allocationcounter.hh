@@ -0,0 +1,151 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Opm::AllocationCounter
+ */
+#ifndef EWOMS_ALLOCATION_COUNTER_HH
+#define EWOMS_ALLOCATION_COUNTER_HH
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace Opm {
+/*!
+ * \ingroup Common
+ *
+ * \brief Counts the number of heap allocations done by the program.
+ *
+ * The counter is only active if the global allocation functions of the program are
+ * replaced by counting ones. This is done by putting the
+ * EWOMS_DEFINE_COUNTING_ALLOCATOR macro into exactly one translation unit of the
+ * program, e.g., the one which contains the main() function. Otherwise, isActive()
+ * returns false and the number of allocations is always zero.
+ */
+class AllocationCounter
+{
+public:
+    /*!
+     * \brief Returns true iff the allocations of the program are counted.
+     */
+    static bool isActive()
+    { return active_.load(std::memory_order_relaxed); }
+
+    /*!
+     * \brief Returns the number of heap allocations done by all threads so far.
+     */
+    static std::size_t numAllocations()
+    { return numAllocations_.load(std::memory_order_relaxed); }
+
+    /*!
+     * \brief Allocate memory and count the allocation.
+     *
+     * This is only supposed to be called by the replaced global allocation functions.
+     */
+    static void* allocate(std::size_t size)
+    {
+        numAllocations_.fetch_add(1, std::memory_order_relaxed);
+
+        void* ptr = std::malloc(size > 0 ? size : 1);
+        if (!ptr)
+            throw std::bad_alloc();
+        return ptr;
+    }
+
+    /*!
+     * \brief Allocate aligned memory and count the allocation.
+     */
+    static void* allocate(std::size_t size, std::size_t alignment)
+    {
+        numAllocations_.fetch_add(1, std::memory_order_relaxed);
+
+        // aligned_alloc() requires the size to be a multiple of the alignment
+        size = ((size + alignment - 1)/alignment)*alignment;
+        void* ptr = std::aligned_alloc(alignment, size > 0 ? size : alignment);
+        if (!ptr)
+            throw std::bad_alloc();
+        return ptr;
+    }
+
+    /*!
+     * \brief Release memory which was allocated by allocate().
+     */
+    static void deallocate(void* ptr) noexcept
+    { std::free(ptr); }
+
+    /*!
+     * \brief Mark the counter as active.
+     */
+    static bool activate()
+    {
+        active_.store(true, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    static inline std::atomic<bool> active_{false};
+    static inline std::atomic<std::size_t> numAllocations_{0};
+};
+
+} // namespace Opm
+
+/*!
+ * \brief Replace the global allocation functions of the program by ones which count
+ *        the number of allocations.
+ *
+ * This must be used in exactly one translation unit of a program.
+ */
+#define EWOMS_DEFINE_COUNTING_ALLOCATOR                                         \
+    void* operator new(std::size_t size)                                        \
+    { return ::Opm::AllocationCounter::allocate(size); }                        \
+    void* operator new[](std::size_t size)                                      \
+    { return ::Opm::AllocationCounter::allocate(size); }                        \
+    void* operator new(std::size_t size, std::align_val_t alignment)            \
+    { return ::Opm::AllocationCounter::allocate(size,                           \
+                                                static_cast<std::size_t>(alignment)); } \
+    void* operator new[](std::size_t size, std::align_val_t alignment)          \
+    { return ::Opm::AllocationCounter::allocate(size,                           \
+                                                static_cast<std::size_t>(alignment)); } \
+    void operator delete(void* ptr) noexcept                                    \
+    { ::Opm::AllocationCounter::deallocate(ptr); }                              \
+    void operator delete[](void* ptr) noexcept                                  \
+    { ::Opm::AllocationCounter::deallocate(ptr); }                              \
+    void operator delete(void* ptr, std::size_t) noexcept                       \
+    { ::Opm::AllocationCounter::deallocate(ptr); }                              \
+    void operator delete[](void* ptr, std::size_t) noexcept                     \
+    { ::Opm::AllocationCounter::deallocate(ptr); }                              \
+    void operator delete(void* ptr, std::align_val_t) noexcept                  \
+    { ::Opm::AllocationCounter::deallocate(ptr); }                              \
+    void operator delete[](void* ptr, std::align_val_t) noexcept                \
+    { ::Opm::AllocationCounter::deallocate(ptr); }                              \
+    void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept     \
+    { ::Opm::AllocationCounter::deallocate(ptr); }                              \
+    void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept   \
+    { ::Opm::AllocationCounter::deallocate(ptr); }                              \
+    static const bool ewomsAllocationCounterIsActive_ =                         \
+        ::Opm::AllocationCounter::activate();
+
+#endif
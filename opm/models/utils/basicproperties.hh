@@ -144,6 +144,18 @@ struct RestartTime { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct PredeterminedTimeStepsFile { using type = UndefinedProperty; };
 
+//! Specify whether the hierarchical profiler records scopes and counters
+template<class TypeTag, class MyTypeTag>
+struct EnableProfiling { using type = UndefinedProperty; };
+
+//! The name of the JSON file to which the profile is written
+template<class TypeTag, class MyTypeTag>
+struct ProfileOutputFile { using type = UndefinedProperty; };
+
+//! The name of the file to which the profiled scopes are written in the Chrome trace format
+template<class TypeTag, class MyTypeTag>
+struct ProfileTraceFile { using type = UndefinedProperty; };
+
 //! domain size
 template<class TypeTag, class MyTypeTag>
 struct DomainSizeX { using type = UndefinedProperty; };
@@ -274,6 +286,18 @@ struct RestartTime<TypeTag, TTag::NumericModel>
 template<class TypeTag>
 struct PredeterminedTimeStepsFile<TypeTag, TTag::NumericModel> { static constexpr auto value = ""; };
 
+//! By default, do not profile the simulation
+template<class TypeTag>
+struct EnableProfiling<TypeTag, TTag::NumericModel> { static constexpr bool value = false; };
+
+//! By default, the profile is written to '$OUTPUT_DIR/$PROBLEM_NAME.profile.json'
+template<class TypeTag>
+struct ProfileOutputFile<TypeTag, TTag::NumericModel> { static constexpr auto value = ""; };
+
+//! By default, no trace of the profiled scopes is written
+template<class TypeTag>
+struct ProfileTraceFile<TypeTag, TTag::NumericModel> { static constexpr auto value = ""; };
+
 
 } // namespace Opm::Properties
 
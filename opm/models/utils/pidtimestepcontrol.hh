@@ -0,0 +1,177 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Opm::PidTimeStepControl
+ */
+#ifndef EWOMS_PID_TIME_STEP_CONTROL_HH
+#define EWOMS_PID_TIME_STEP_CONTROL_HH
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace Opm {
+/*!
+ * \ingroup Common
+ *
+ * \brief An error based time step controller.
+ *
+ * The size of the next time step is determined from the relative change of the
+ * solution over the last three time steps using the PID formula of
+ *
+ * G. Söderlind: "Automatic control and adaptive time-stepping", Numerical Algorithms
+ * 31, pp. 281-310, 2002.
+ *
+ * If the Newton method failed, the time step size for the retry is estimated from the
+ * observed reduction of the Newton error instead of blindly halving the step.
+ */
+template <class Scalar>
+class PidTimeStepControl
+{
+public:
+    PidTimeStepControl(Scalar tolerance = 1e-1)
+        : tolerance_(tolerance)
+        , numChanges_(0)
+    { relChange_.fill(1.0); }
+
+    /*!
+     * \brief Set the relative change of the solution per time step at which the
+     *        controller aims at.
+     */
+    void setTolerance(Scalar value)
+    { tolerance_ = value; }
+
+    /*!
+     * \brief Return the relative change of the solution per time step at which the
+     *        controller aims at.
+     */
+    Scalar tolerance() const
+    { return tolerance_; }
+
+    /*!
+     * \brief Forget about the history of the solution changes.
+     */
+    void reset()
+    {
+        relChange_.fill(1.0);
+        numChanges_ = 0;
+    }
+
+    /*!
+     * \brief Record the relative change of the solution of a successful time step.
+     */
+    void registerSolutionChange(Scalar relChange)
+    {
+        relChange_[0] = relChange_[1];
+        relChange_[1] = relChange_[2];
+        relChange_[2] = std::max(relChange, minChange_);
+        ++numChanges_;
+    }
+
+    /*!
+     * \brief Suggest the size of the next time step after a successful one.
+     */
+    Scalar suggestTimeStepSize(Scalar oldDt) const
+    {
+        if (numChanges_ == 0)
+            return oldDt;
+
+        const Scalar en = relChange_[2];
+        // the solution changed too much: reduce proportionally
+        if (en > tolerance_)
+            return oldDt*std::max(minFactor_, tolerance_/en);
+
+        // integral control only as long as we do not have a sufficient history
+        if (numChanges_ < 3)
+            return oldDt*std::clamp(std::pow(tolerance_/en, kI_), minFactor_, maxFactor_);
+
+        const Scalar enm1 = relChange_[1];
+        const Scalar enm2 = relChange_[0];
+        const Scalar factor =
+            std::pow(enm1/en, kP_)
+            * std::pow(tolerance_/en, kI_)
+            * std::pow(enm1*enm1/(en*enm2), kD_);
+
+        return oldDt*std::clamp(factor, minFactor_, maxFactor_);
+    }
+
+    /*!
+     * \brief Suggest the time step size to be used after the Newton method failed.
+     *
+     * The number of iterations which would have been required for convergence is
+     * extrapolated from the error reduction achieved by the failed attempt, assuming
+     * linear convergence. The time step size is then scaled by the ratio of the target
+     * number of iterations and this estimate, but it is always reduced by at least a
+     * factor of two.
+     *
+     * \param failedDt The time step size which could not be solved
+     * \param initialError The Newton error after the first linearization
+     * \param finalError The Newton error when the Newton method was aborted
+     * \param tolerance The error below which the Newton method is considered converged
+     * \param numIterations The number of iterations done by the failed attempt
+     * \param targetIterations The optimum number of Newton iterations per time step
+     */
+    Scalar suggestRetryTimeStepSize(Scalar failedDt,
+                                    Scalar initialError,
+                                    Scalar finalError,
+                                    Scalar tolerance,
+                                    int numIterations,
+                                    int targetIterations) const
+    {
+        if (!std::isfinite(finalError)
+            || numIterations < 1
+            || finalError >= initialError
+            || initialError <= tolerance)
+            return failedDt*minRetryFactor_;
+
+        // average logarithmic error reduction per iteration
+        const Scalar rate = std::log(finalError/initialError)/numIterations;
+        const Scalar requiredIterations = std::log(tolerance/initialError)/rate;
+        const Scalar factor = Scalar(targetIterations)/std::max(requiredIterations, Scalar(1.0));
+
+        return failedDt*std::clamp(factor, minRetryFactor_, maxRetryFactor_);
+    }
+
+private:
+    // the PID parameters recommended by Söderlind
+    static constexpr Scalar kP_ = 0.075;
+    static constexpr Scalar kI_ = 0.175;
+    static constexpr Scalar kD_ = 0.01;
+
+    static constexpr Scalar minChange_ = 1e-10;
+    static constexpr Scalar minFactor_ = 0.2;
+    static constexpr Scalar maxFactor_ = 3.0;
+    static constexpr Scalar minRetryFactor_ = 0.1;
+    static constexpr Scalar maxRetryFactor_ = 0.5;
+
+    Scalar tolerance_;
+    // relative solution changes of the last three successful time steps, the most
+    // recent one is stored last
+    std::array<Scalar, 3> relChange_;
+    unsigned numChanges_;
+};
+
+} // namespace Opm
+
+#endif
@@ -0,0 +1,590 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Opm::Profiler
+ */
+#ifndef EWOMS_PROFILER_HH
+#define EWOMS_PROFILER_HH
+
+#include <opm/models/parallel/mpiutil.hh>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Opm {
+/*!
+ * \ingroup Common
+ *
+ * \brief A low-overhead hierarchical profiler.
+ *
+ * The profiler records nested scopes and named event counters. Every thread records
+ * into its own data structures, so the hot paths do not need any locks. The data of
+ * all threads is merged when a report is generated, and the reports of all processes
+ * are reduced to their minimum, maximum and average values.
+ *
+ * Scopes and counters are usually recorded using the EWOMS_PROFILE_SCOPE() and
+ * EWOMS_PROFILE_COUNT() macros. If the profiler is disabled at runtime, these only
+ * load a flag. If the EWOMS_DISABLE_PROFILER preprocessor macro is defined, they do
+ * not produce any code at all.
+ *
+ * Scopes entered by a thread are nested into the scopes which are currently open on
+ * the same thread, i.e., scopes of worker threads show up at the top level of the
+ * hierarchy. Reports must only be generated while no thread is within a profiled scope.
+ */
+class Profiler
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Node_
+    {
+        const char* name;
+        int parentIdx;
+        std::uint64_t numCalls;
+        std::int64_t duration; // [ns]
+        std::vector<int> childIdx;
+    };
+
+    struct TraceEvent_
+    {
+        int nodeIdx;
+        std::int64_t start; // [ns]
+        std::int64_t duration; // [ns]
+    };
+
+public:
+    //! The maximum number of distinct counters
+    static constexpr unsigned maxCounters = 64;
+
+private:
+    struct ThreadData_
+    {
+        ThreadData_(unsigned idx)
+            : threadIdx(idx)
+        {
+            nodes.push_back(Node_{"", /*parentIdx=*/-1, 0, 0, {}});
+            for (auto& counter : counters)
+                counter.store(0, std::memory_order_relaxed);
+        }
+
+        unsigned threadIdx;
+        std::vector<Node_> nodes;
+        std::vector<std::pair<int, std::int64_t>> stack;
+        std::vector<TraceEvent_> traceEvents;
+        int curNodeIdx = 0;
+
+        // only the owning thread modifies the counters, but they can be read by other
+        // threads when a report is generated
+        std::array<std::atomic<std::uint64_t>, maxCounters> counters;
+    };
+
+public:
+    /*!
+     * \brief Returns true iff the profiler records anything.
+     */
+    static bool isEnabled()
+    { return enabled_.load(std::memory_order_relaxed); }
+
+    /*!
+     * \brief Enable or disable the recording of scopes and counters.
+     */
+    static void setEnabled(bool yesno)
+    {
+        if (yesno && !isEnabled())
+            epoch_ = now_();
+        enabled_.store(yesno, std::memory_order_relaxed);
+    }
+
+    /*!
+     * \brief Specify whether the individual invocations of the scopes should be
+     *        recorded in addition to their accumulated durations.
+     *
+     * This is required to export a Chrome trace, but the memory required grows with
+     * the number of scope invocations.
+     */
+    static void setTraceEnabled(bool yesno)
+    { traceEnabled_.store(yesno, std::memory_order_relaxed); }
+
+    /*!
+     * \brief Returns true iff the individual scope invocations are recorded.
+     */
+    static bool traceEnabled()
+    { return traceEnabled_.load(std::memory_order_relaxed); }
+
+    /*!
+     * \brief Return the index of a counter and create it if it does not exist yet.
+     */
+    static unsigned counterIndex(const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find(counterNames_.begin(), counterNames_.end(), name);
+        if (it != counterNames_.end())
+            return static_cast<unsigned>(it - counterNames_.begin());
+
+        if (counterNames_.size() >= maxCounters)
+            throw std::logic_error("Too many profiler counters: cannot create counter '"+name+"'");
+        counterNames_.push_back(name);
+        return static_cast<unsigned>(counterNames_.size() - 1);
+    }
+
+    /*!
+     * \brief Add a value to a counter of the calling thread.
+     */
+    static void addToCounter(unsigned counterIdx, std::uint64_t value)
+    {
+        auto& counter = localThreadData_().counters[counterIdx];
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    /*!
+     * \brief Returns the sum of a counter over all threads of the local process.
+     */
+    static std::uint64_t counterValue(const std::string& name)
+    {
+        const unsigned counterIdx = counterIndex(name);
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::uint64_t result = 0;
+        for (const auto& data : threadDataPool_)
+            result += data->counters[counterIdx].load(std::memory_order_relaxed);
+        return result;
+    }
+
+    /*!
+     * \brief Enter a scope.
+     *
+     * The name must be a string which stays alive until the program ends, e.g., a
+     * string literal.
+     */
+    static void beginScope(const char* name)
+    {
+        auto& data = localThreadData_();
+        int nodeIdx = findChild_(data, name);
+        if (nodeIdx < 0) {
+            nodeIdx = static_cast<int>(data.nodes.size());
+            data.nodes.push_back(Node_{name, data.curNodeIdx, 0, 0, {}});
+            data.nodes[data.curNodeIdx].childIdx.push_back(nodeIdx);
+        }
+
+        data.curNodeIdx = nodeIdx;
+        data.stack.emplace_back(nodeIdx, now_());
+    }
+
+    /*!
+     * \brief Leave the scope which was entered most recently.
+     */
+    static void endScope()
+    {
+        auto& data = localThreadData_();
+        if (data.stack.empty())
+            return;
+
+        const auto [nodeIdx, startTime] = data.stack.back();
+        data.stack.pop_back();
+
+        const std::int64_t duration = now_() - startTime;
+        auto& node = data.nodes[nodeIdx];
+        ++node.numCalls;
+        node.duration += duration;
+        data.curNodeIdx = node.parentIdx;
+
+        if (traceEnabled())
+            data.traceEvents.push_back(TraceEvent_{nodeIdx, startTime - epoch_, duration});
+    }
+
+    /*!
+     * \brief Discard everything which has been recorded so far.
+     */
+    static void reset()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& data : threadDataPool_) {
+            data->nodes.resize(1);
+            data->nodes[0].childIdx.clear();
+            data->stack.clear();
+            data->traceEvents.clear();
+            data->curNodeIdx = 0;
+            for (auto& counter : data->counters)
+                counter.store(0, std::memory_order_relaxed);
+        }
+        epoch_ = now_();
+    }
+
+    /*!
+     * \brief Write the scopes and counters of all processes to a JSON file.
+     *
+     * This method must be called by all processes. Each scope is reported with
+     * the minimum, maximum and average of its number of invocations and its
+     * accumulated duration in seconds over the processes. The counters are reduced
+     * the same way and their sum over all processes is added. Only the process of
+     * rank 0 writes the file.
+     */
+    static void writeReport(int rank, const std::string& fileName)
+    {
+        std::ostringstream oss;
+        oss.precision(std::numeric_limits<double>::max_digits10);
+        oss << "R\t" << rank << "\n";
+        for (const auto& [path, entry] : localScopes_())
+            oss << "S\t" << path << "\t" << entry.first << "\t" << entry.second << "\n";
+        for (const auto& [name, value] : localCounters_())
+            oss << "C\t" << name << "\t" << value << "\n";
+
+        const auto allProcesses = gatherStrings(oss.str());
+        if (rank != 0)
+            return;
+
+        // reduce the values of all processes
+        const double numProcesses = static_cast<double>(allProcesses.size());
+        std::map<std::string, std::pair<Statistics_, Statistics_>> scopes;
+        std::map<std::string, Statistics_> counters;
+        for (const auto& processData : allProcesses) {
+            std::istringstream iss(processData);
+            std::string line;
+            while (std::getline(iss, line)) {
+                const auto fields = splitFields_(line);
+                if (fields[0] == "S" && fields.size() == 4) {
+                    auto& stats = scopes[fields[1]];
+                    stats.first.add(std::stod(fields[2]));
+                    stats.second.add(std::stod(fields[3]));
+                }
+                else if (fields[0] == "C" && fields.size() == 3)
+                    counters[fields[1]].add(std::stod(fields[2]));
+            }
+        }
+
+        std::ofstream os(fileName);
+        if (!os) {
+            std::cerr << "Warning: Could not open profile file '" << fileName << "'\n";
+            return;
+        }
+
+        os.precision(9);
+        os << "{\n"
+           << "  \"processes\": " << allProcesses.size() << ",\n"
+           << "  \"scopes\": [";
+        writeScopes_(os, scopes, /*prefix=*/"", numProcesses, /*indent=*/2);
+        os << "\n  ],\n"
+           << "  \"counters\": {";
+        bool first = true;
+        for (const auto& [name, stats] : counters) {
+            os << (first ? "\n" : ",\n")
+               << "    \"" << jsonEscape_(name) << "\": ";
+            stats.write(os, numProcesses, /*withSum=*/true);
+            first = false;
+        }
+        os << "\n  }\n"
+           << "}\n";
+    }
+
+    /*!
+     * \brief Write the recorded scope invocations of all processes and threads to a
+     *        file in the Chrome trace event format.
+     *
+     * The file can be inspected using chrome://tracing or Perfetto. The process ID of
+     * the events is the MPI rank. This method must be called by all processes and
+     * only the process of rank 0 writes the file. Nothing is recorded unless
+     * setTraceEnabled() was called.
+     */
+    static void writeChromeTrace(int rank, const std::string& fileName)
+    {
+        // one event per line. the time stamps are specified in microseconds
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(3);
+        oss << "R\t" << rank << "\n";
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& data : threadDataPool_) {
+                for (const auto& event : data->traceEvents) {
+                    oss << "{\"name\":\"" << jsonEscape_(data->nodes[event.nodeIdx].name) << "\""
+                        << ",\"ph\":\"X\""
+                        << ",\"ts\":" << event.start*1e-3
+                        << ",\"dur\":" << event.duration*1e-3
+                        << ",\"pid\":" << rank
+                        << ",\"tid\":" << data->threadIdx << "}\n";
+                }
+            }
+        }
+
+        const auto allProcesses = gatherStrings(oss.str());
+        if (rank != 0)
+            return;
+
+        std::ofstream os(fileName);
+        if (!os) {
+            std::cerr << "Warning: Could not open trace file '" << fileName << "'\n";
+            return;
+        }
+
+        os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        for (const auto& processData : allProcesses) {
+            std::istringstream iss(processData);
+            std::string line;
+            while (std::getline(iss, line)) {
+                if (line.empty() || line[0] != '{')
+                    continue;
+                os << (first ? "\n" : ",\n") << line;
+                first = false;
+            }
+        }
+        os << "\n]}\n";
+    }
+
+private:
+    class Statistics_
+    {
+    public:
+        void add(double value)
+        {
+            min_ = std::min(min_, value);
+            max_ = std::max(max_, value);
+            sum_ += value;
+            ++num_;
+        }
+
+        // processes which did not report a value are considered to be zero
+        void write(std::ostream& os, double numProcesses, bool withSum) const
+        {
+            const double min = (num_ < numProcesses) ? std::min(min_, 0.0) : min_;
+            os << "{\"min\": " << min
+               << ", \"max\": " << max_
+               << ", \"avg\": " << sum_/numProcesses;
+            if (withSum)
+                os << ", \"sum\": " << sum_;
+            os << "}";
+        }
+
+    private:
+        double min_ = std::numeric_limits<double>::max();
+        double max_ = std::numeric_limits<double>::lowest();
+        double sum_ = 0.0;
+        double num_ = 0.0;
+    };
+
+    using ScopeStatistics_ = std::map<std::string, std::pair<Statistics_, Statistics_>>;
+
+    static std::int64_t now_()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now().time_since_epoch()).count();
+    }
+
+    static ThreadData_& localThreadData_()
+    {
+        thread_local ThreadData_* data = registerThread_();
+        return *data;
+    }
+
+    // the data is owned by the profiler instead of the thread, so it stays alive if
+    // the thread terminates before a report is generated
+    static ThreadData_* registerThread_()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const unsigned threadIdx = static_cast<unsigned>(threadDataPool_.size());
+        threadDataPool_.push_back(std::make_unique<ThreadData_>(threadIdx));
+        return threadDataPool_.back().get();
+    }
+
+    static int findChild_(const ThreadData_& data, const char* name)
+    {
+        for (int childIdx : data.nodes[data.curNodeIdx].childIdx) {
+            const char* childName = data.nodes[childIdx].name;
+            if (childName == name || std::strcmp(childName, name) == 0)
+                return childIdx;
+        }
+        return -1;
+    }
+
+    static std::string nodePath_(const ThreadData_& data, int nodeIdx)
+    {
+        std::string path = data.nodes[nodeIdx].name;
+        for (int idx = data.nodes[nodeIdx].parentIdx; idx > 0; idx = data.nodes[idx].parentIdx)
+            path = std::string(data.nodes[idx].name) + "/" + path;
+        return path;
+    }
+
+    // the number of calls and the duration in seconds of all scopes of the local
+    // process, merged over the threads
+    static std::map<std::string, std::pair<std::uint64_t, double>> localScopes_()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::map<std::string, std::pair<std::uint64_t, double>> result;
+        for (const auto& data : threadDataPool_) {
+            for (std::size_t nodeIdx = 1; nodeIdx < data->nodes.size(); ++nodeIdx) {
+                const auto& node = data->nodes[nodeIdx];
+                auto& entry = result[nodePath_(*data, static_cast<int>(nodeIdx))];
+                entry.first += node.numCalls;
+                entry.second += node.duration*1e-9;
+            }
+        }
+        return result;
+    }
+
+    static std::map<std::string, std::uint64_t> localCounters_()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::map<std::string, std::uint64_t> result;
+        for (std::size_t counterIdx = 0; counterIdx < counterNames_.size(); ++counterIdx) {
+            auto& value = result[counterNames_[counterIdx]];
+            for (const auto& data : threadDataPool_)
+                value += data->counters[counterIdx].load(std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+    static void writeScopes_(std::ostream& os,
+                             const ScopeStatistics_& scopes,
+                             const std::string& prefix,
+                             double numProcesses,
+                             int indent)
+    {
+        const std::string pad(2*indent, ' ');
+        bool first = true;
+        for (const auto& [path, stats] : scopes) {
+            // only consider the direct children of the prefix
+            if (path.compare(0, prefix.size(), prefix) != 0
+                || path.find('/', prefix.size()) != std::string::npos)
+                continue;
+
+            os << (first ? "\n" : ",\n")
+               << pad << "{\"name\": \"" << jsonEscape_(path.substr(prefix.size())) << "\",\n"
+               << pad << " \"calls\": ";
+            stats.first.write(os, numProcesses, /*withSum=*/false);
+            os << ",\n"
+               << pad << " \"time\": ";
+            stats.second.write(os, numProcesses, /*withSum=*/false);
+            os << ",\n"
+               << pad << " \"children\": [";
+            writeScopes_(os, scopes, path + "/", numProcesses, indent + 1);
+            os << "]}";
+            first = false;
+        }
+    }
+
+    static std::vector<std::string> splitFields_(const std::string& line)
+    {
+        std::vector<std::string> fields;
+        std::istringstream iss(line);
+        std::string field;
+        while (std::getline(iss, field, '\t'))
+            fields.push_back(field);
+        if (fields.empty())
+            fields.emplace_back();
+        return fields;
+    }
+
+    static std::string jsonEscape_(const std::string& s)
+    {
+        std::string result;
+        for (char c : s) {
+            if (c == '"' || c == '\\')
+                result += '\\';
+            result += c;
+        }
+        return result;
+    }
+
+    static inline std::atomic<bool> enabled_{false};
+    static inline std::atomic<bool> traceEnabled_{false};
+    static inline std::int64_t epoch_ = 0;
+
+    static inline std::mutex mutex_;
+    static inline std::vector<std::string> counterNames_;
+    static inline std::vector<std::unique_ptr<ThreadData_>> threadDataPool_;
+};
+
+/*!
+ * \ingroup Common
+ *
+ * \brief Records a scope of the profiler for the lifetime of the object.
+ */
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char* name)
+        : active_(Profiler::isEnabled())
+    {
+        if (active_)
+            Profiler::beginScope(name);
+    }
+
+    ~ProfileScope()
+    {
+        if (active_)
+            Profiler::endScope();
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    bool active_;
+};
+
+} // namespace Opm
+
+#define EWOMS_PROFILE_CONCAT_IMPL_(a, b) a ## b
+#define EWOMS_PROFILE_CONCAT_(a, b) EWOMS_PROFILE_CONCAT_IMPL_(a, b)
+
+#ifdef EWOMS_DISABLE_PROFILER
+#define EWOMS_PROFILE_SCOPE(name) do { } while (false)
+#define EWOMS_PROFILE_COUNT(name, value) do { } while (false)
+#else
+/*!
+ * \brief Record the remainder of the enclosing block as a scope of the profiler.
+ *
+ * The name must be a string literal.
+ */
+#define EWOMS_PROFILE_SCOPE(name)                                       \
+    ::Opm::ProfileScope EWOMS_PROFILE_CONCAT_(ewomsProfileScope, __LINE__)(name)
+
+/*!
+ * \brief Add a value to a counter of the profiler.
+ */
+#define EWOMS_PROFILE_COUNT(name, value)                                \
+    do {                                                                \
+        if (::Opm::Profiler::isEnabled()) {                             \
+            static const unsigned ewomsProfileCounterIdx =              \
+                ::Opm::Profiler::counterIndex(name);                    \
+            ::Opm::Profiler::addToCounter(ewomsProfileCounterIdx,       \
+                                          static_cast<std::uint64_t>(value)); \
+        }                                                               \
+    } while (false)
+#endif
+
+#endif
@@ -33,6 +33,7 @@
 
 #include <opm/models/utils/basicproperties.hh>
 #include <opm/models/utils/propertysystem.hh>
+#include <opm/models/utils/profiler.hh>
 #include <opm/models/utils/timer.hh>
 #include <opm/models/utils/timerguard.hh>
 #include <opm/models/parallel/mpiutil.hh>
@@ -124,6 +125,10 @@ public:
 
         setupTimer_.start();
 
+        Profiler::setEnabled(EWOMS_GET_PARAM(TypeTag, bool, EnableProfiling));
+        Profiler::setTraceEnabled(!EWOMS_GET_PARAM(TypeTag, std::string, ProfileTraceFile).empty());
+        EWOMS_PROFILE_SCOPE("setup");
+
         verbose_ = verbose && comm.rank() == 0;
 
         timeStepIdx_ = 0;
@@ -152,6 +157,8 @@ public:
         if (verbose_)
             std::cout << "Allocating the simulation vanguard\n" << std::flush;
 
+        vanguardTimer_.start();
+
         int exceptionThrown = 0;
         std::string what;
         try
@@ -193,6 +200,8 @@ public:
             throw std::runtime_error("Could not distribute the vanguard data: " + all_what.front());
         }
 
+        vanguardTimer_.stop();
+
         if (verbose_)
             std::cout << "Allocating the model\n" << std::flush;
         model_.reset(new Model(*this));
@@ -263,6 +272,15 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, std::string, PredeterminedTimeStepsFile,
                              "A file with a list of predetermined time step sizes (one "
                              "time step per line)");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableProfiling,
+                             "Record the time spent in the individual parts of the simulator "
+                             "and the number of events like linear iterations");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, ProfileOutputFile,
+                             "The JSON file to which the profile is written. By default, this is "
+                             "'$OUTPUT_DIR/$PROBLEM_NAME.profile.json'");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, ProfileTraceFile,
+                             "The file to which the individual invocations of the profiled scopes "
+                             "are written in the Chrome trace format. Empty means no trace");
 
         Vanguard::registerParameters();
         Model::registerParameters();
@@ -380,6 +398,15 @@ public:
     const Timer& setupTimer() const
     { return setupTimer_; }
 
+    /*!
+     * \brief Returns a reference to the timer object which measures the time needed to
+     *        create the grid and to distribute it to the processes
+     *
+     * This is a part of the setup time.
+     */
+    const Timer& vanguardTimer() const
+    { return vanguardTimer_; }
+
     /*!
      * \brief Returns a reference to the timer object which measures the time needed to
      *        run the simulation
@@ -417,6 +444,14 @@ public:
     const Timer& updateTimer() const
     { return updateTimer_; }
 
+    /*!
+     * \brief Returns a reference to the timer object which measures the time needed to
+     *        adapt and re-partition the grid and to rebuild the data structures which
+     *        depend on it
+     */
+    const Timer& adaptTimer() const
+    { return adaptTimer_; }
+
     /*!
      * \brief Returns a reference to the timer object which measures the time needed to
      *        write the visualization output
@@ -735,6 +770,7 @@ public:
 
             try {
                 // execute the time integration scheme
+                EWOMS_PROFILE_SCOPE("time integration");
                 problem_->timeIntegration();
             }
             catch (...) {
@@ -769,6 +805,7 @@ public:
             // do the next time integration
             Scalar oldDt = timeStepSize();
             EWOMS_CATCH_PARALLEL_EXCEPTIONS_FATAL(problem_->advanceTimeLevel());
+            adaptTimer_ += problem_->model().adaptTimer();
 
             if (verbose_) {
                 std::cout << "Time step " << timeStepIndex() + 1 << " done. "
@@ -811,6 +848,8 @@ public:
         executionTimer_.stop();
 
         EWOMS_CATCH_PARALLEL_EXCEPTIONS_FATAL(problem_->finalize());
+
+        writeProfile_();
     }
 
     /*!
@@ -905,6 +944,8 @@ public:
      */
     void serialize()
     {
+        EWOMS_PROFILE_SCOPE("restart");
+
         using Restarter = Restart;
         Restarter res;
         res.serializeBegin(*this);
@@ -976,6 +1017,25 @@ public:
     }
 
 private:
+    void writeProfile_() const
+    {
+        if (!Profiler::isEnabled())
+            return;
+
+        const int rank = gridView().comm().rank();
+        std::string fileName = EWOMS_GET_PARAM(TypeTag, std::string, ProfileOutputFile);
+        if (fileName.empty())
+            fileName = problem_->outputDir() + "/" + problem_->name() + ".profile.json";
+        Profiler::writeReport(rank, fileName);
+
+        const std::string& traceFileName = EWOMS_GET_PARAM(TypeTag, std::string, ProfileTraceFile);
+        if (!traceFileName.empty())
+            Profiler::writeChromeTrace(rank, traceFileName);
+
+        if (verbose_)
+            std::cout << "Profile written to '" << fileName << "'\n" << std::flush;
+    }
+
     std::unique_ptr<Vanguard> vanguard_;
     std::unique_ptr<Model> model_;
     std::unique_ptr<Problem> problem_;
@@ -985,11 +1045,13 @@ private:
     Scalar episodeLength_;
 
     Timer setupTimer_;
+    Timer vanguardTimer_;
     Timer executionTimer_;
     Timer prePostProcessTimer_;
     Timer linearizeTimer_;
     Timer solveTimer_;
     Timer updateTimer_;
+    Timer adaptTimer_;
     Timer writeTimer_;
 
     std::vector<Scalar> forcedTimeSteps_;
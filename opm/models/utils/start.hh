@@ -307,8 +307,6 @@ static inline int start(int argc, char **argv,  bool registerParams=true)
         if (paramStatus == 2)
             return 0;
 
-        ThreadManager::init();
-
         // initialize MPI, finalize is done automatically on exit
 #if HAVE_DUNE_FEM
         Dune::Fem::MPIManager::initialize(argc, argv);
@@ -317,6 +315,10 @@ static inline int start(int argc, char **argv,  bool registerParams=true)
         myRank = Dune::MPIHelper::instance(argc, argv).rank();
 #endif
 
+        // the thread manager is initialized after MPI because the pinning of the threads
+        // takes the other processes on the same machine into account
+        ThreadManager::init();
+
         // read the initial time step and the end time
         Scalar endTime = EWOMS_GET_PARAM(TypeTag, Scalar, EndTime);
         if (endTime < -1e50) {
@@ -351,6 +353,8 @@ static inline int start(int argc, char **argv,  bool registerParams=true)
             else
                 std::cout << "opm models " << versionString
                           << " will now start the simulation. " << std::endl;
+
+            ThreadManager::printTopology(std::cout);
         }
 
         // print the parameters if requested
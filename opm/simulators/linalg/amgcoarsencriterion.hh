@@ -0,0 +1,70 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Opm::Linear::amgCoarsenCriterion
+ */
+#ifndef EWOMS_AMG_COARSEN_CRITERION_HH
+#define EWOMS_AMG_COARSEN_CRITERION_HH
+
+#include <dune/istl/paamg/amg.hh>
+
+namespace Opm {
+namespace Linear {
+
+//! The criterion used to coarsen the matrices for the AMG preconditioners
+template <class Matrix>
+using AmgCoarsenCriterion =
+    Dune::Amg::CoarsenCriterion<Dune::Amg::SymmetricCriterion<Matrix, Dune::Amg::FrobeniusNorm> >;
+
+/*!
+ * \brief Returns the coarsening criterion used by the AMG preconditioners.
+ *
+ * \param coarsenTarget The number of degrees of freedom at which coarsening stops
+ * \param dimension The dimension of the grid
+ * \param verbosity If larger than zero, the AMG prints information about the hierarchy
+ */
+template <class Matrix>
+AmgCoarsenCriterion<Matrix> amgCoarsenCriterion(int coarsenTarget, int dimension, int verbosity)
+{
+    // alternatively, Dune::Amg::FirstDiagonal can be used instead of the Frobenius norm
+    AmgCoarsenCriterion<Matrix> coarsenCriterion(/*maxLevel=*/15, coarsenTarget);
+    coarsenCriterion.setDefaultValuesAnisotropic(dimension,
+                                                 /*aggregateSizePerDim=*/3);
+    if (verbosity > 0)
+        coarsenCriterion.setDebugLevel(1);
+    else
+        coarsenCriterion.setDebugLevel(0); // make the AMG shut up
+
+    // reduce the minium coarsen rate (default is 1.2)
+    coarsenCriterion.setMinCoarsenRate(1.05);
+    // coarsenCriterion.setAccumulate(Dune::Amg::noAccu);
+    coarsenCriterion.setAccumulate(Dune::Amg::atOnceAccu);
+    coarsenCriterion.setSkipIsolated(false);
+
+    return coarsenCriterion;
+}
+
+}} // namespace Linear, Opm
+
+#endif
@@ -0,0 +1,80 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Opm::Linear::setupAmgIndexSet
+ */
+#ifndef EWOMS_AMG_INDEX_SET_HH
+#define EWOMS_AMG_INDEX_SET_HH
+
+#include <opm/simulators/linalg/overlaptypes.hh>
+
+#if HAVE_MPI
+#include <dune/istl/owneroverlapcopy.hh>
+#endif
+
+#include <cassert>
+#include <cstddef>
+
+namespace Opm {
+namespace Linear {
+
+#if HAVE_MPI
+/*!
+ * \brief Create the parallel index set of DUNE's OwnerOverlapCopyCommunication from a
+ *        domestic overlap.
+ *
+ * This allows the parallel AMG of dune-istl to operate on the rows of an overlapping
+ * matrix.
+ */
+template <class Overlap, class ParallelIndexSet>
+void setupAmgIndexSet(const Overlap& overlap, ParallelIndexSet& istlIndices)
+{
+    using GridAttributes = Dune::OwnerOverlapCopyAttributeSet;
+    using GridAttributeSet = Dune::OwnerOverlapCopyAttributeSet::AttributeSet;
+
+    // create DUNE's ParallelIndexSet from a domestic overlap
+    istlIndices.beginResize();
+    for (Index curIdx = 0; static_cast<std::size_t>(curIdx) < overlap.numDomestic(); ++curIdx) {
+        GridAttributeSet gridFlag =
+            overlap.iAmMasterOf(curIdx)
+            ? GridAttributes::owner
+            : GridAttributes::copy;
+
+        // an index is used by other processes if it is in the
+        // domestic or in the foreign overlap.
+        bool isShared = overlap.isInOverlap(curIdx);
+
+        assert(curIdx == overlap.globalToDomestic(overlap.domesticToGlobal(curIdx)));
+        istlIndices.add(/*globalIdx=*/overlap.domesticToGlobal(curIdx),
+                        Dune::ParallelLocalIndex<GridAttributeSet>(static_cast<std::size_t>(curIdx),
+                                                                   gridFlag,
+                                                                   isShared));
+    }
+    istlIndices.endResize();
+}
+#endif
+
+}} // namespace Linear, Opm
+
+#endif
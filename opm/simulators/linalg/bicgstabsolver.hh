@@ -36,6 +36,7 @@
 
 #include <opm/common/Exceptions.hpp>
 
+#include <cmath>
 #include <memory>
 
 namespace Opm {
@@ -229,6 +230,8 @@ public:
 
             // alpha = rho_i/(r0hat,v_i)
             Scalar denom = scalarProduct_.dot(r0hat, v);
+            if (!std::isfinite(denom))
+                throw NumericalProblem("Breakdown of the BiCGStab solver (non-finite values)");
             if (std::abs(denom) <= breakdownEps)
                 throw NumericalProblem("Breakdown of the BiCGStab solver (division by zero)");
             alpha = rho_i/denom;
@@ -285,6 +288,8 @@ public:
 
             // omega_i = (t*s)/(t*t)
             denom = scalarProduct_.dot(t, t);
+            if (!std::isfinite(denom))
+                throw NumericalProblem("Breakdown of the BiCGStab solver (non-finite values)");
             if (std::abs(denom) <= breakdownEps)
                 throw NumericalProblem("Breakdown of the BiCGStab solver (division by zero)");
             omega = scalarProduct_.dot(t, s)/denom;
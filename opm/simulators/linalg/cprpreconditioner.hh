@@ -0,0 +1,371 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Opm::Linear::CprPreconditioner
+ */
+#ifndef EWOMS_CPR_PRECONDITIONER_HH
+#define EWOMS_CPR_PRECONDITIONER_HH
+
+#include "amgcoarsencriterion.hh"
+#include "sparsitypatterntracker.hh"
+
+#include <opm/simulators/linalg/ilufirstelement.hh> //definitions needed in next header
+#include <dune/istl/ilu.hh>
+#include <dune/istl/preconditioners.hh>
+#include <dune/istl/preconditioner.hh>
+#include <dune/istl/solvercategory.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/schwarz.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/paamg/amg.hh>
+#include <dune/istl/paamg/pinfo.hh>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace Opm {
+namespace Linear {
+
+/*!
+ * \brief A two-stage constrained pressure residual (CPR) preconditioner.
+ *
+ * The first stage decouples the pressure from the remaining primary variables using
+ * quasi-IMPES weights: For each row, the weights \f$w_i\f$ are chosen such that
+ * \f$w_i^T D_i\f$ only exhibits a non-zero entry for the pressure, where \f$D_i\f$ is
+ * the diagonal block of the row. The resulting scalar pressure system is approximately
+ * solved by one cycle of an algebraic multi-grid method. The second stage applies ILU(0)
+ * to the residual of the full system which is left after the pressure correction.
+ *
+ * The sparsity pattern of the pressure matrix, the storage of the ILU(0) factorization and
+ * the aggregates of the AMG are kept if the values of the matrix are updated via
+ * updateMatrix(). They are recreated if the sparsity pattern of the matrix changes.
+ *
+ * If the communication is not Dune::Amg::SequentialInformation, the AMG for the pressure
+ * operates on the pressure system of all processes, i.e., the coarse levels are shared
+ * by the processes in the same way as for the ParallelAmgBackend. The second stage is
+ * always applied to the local matrix of each process.
+ */
+template <class Matrix, class Vector, class Communication = Dune::Amg::SequentialInformation>
+class CprPreconditioner : public Dune::Preconditioner<Vector, Vector>
+{
+    using MatrixBlock = typename Matrix::block_type;
+    using VectorBlock = typename Vector::block_type;
+    using field_type_ = typename Vector::field_type;
+
+    static constexpr bool isParallel = !std::is_same_v<Communication, Dune::Amg::SequentialInformation>;
+
+    using PressureMatrix = Dune::BCRSMatrix<Dune::FieldMatrix<field_type_, 1, 1> >;
+    using PressureVector = Dune::BlockVector<Dune::FieldVector<field_type_, 1> >;
+    using SequentialPressureSmoother = Dune::SeqSSOR<PressureMatrix, PressureVector, PressureVector>;
+    using PressureOperator =
+        std::conditional_t<isParallel,
+                           Dune::OverlappingSchwarzOperator<PressureMatrix, PressureVector,
+                                                            PressureVector, Communication>,
+                           Dune::MatrixAdapter<PressureMatrix, PressureVector, PressureVector> >;
+    using PressureSmoother =
+        std::conditional_t<isParallel,
+                           Dune::BlockPreconditioner<PressureVector, PressureVector,
+                                                     Communication, SequentialPressureSmoother>,
+                           SequentialPressureSmoother>;
+    using PressureAmg = Dune::Amg::AMG<PressureOperator, PressureVector, PressureSmoother, Communication>;
+
+    // the second stage factorizes a copy of the matrix in place
+    using IluMatrix = Dune::BCRSMatrix<MatrixBlock>;
+
+public:
+    using matrix_type = Matrix;
+    using domain_type = Vector;
+    using range_type = Vector;
+    using field_type = field_type_;
+
+    /*!
+     * \brief Create the preconditioner.
+     *
+     * \param pressureIdx The index of the pressure within the blocks of the vectors
+     * \param coarsenTarget The coarsening target of the AMG for the pressure system
+     * \param dimension The dimension of the grid
+     * \param refreshInterval The number of matrix updates after which the aggregates of
+     *                        the AMG are recomputed
+     * \param relaxationFactor The relaxation factor of the second stage
+     * \param comm The communication used by the AMG for the pressure. It must stay alive
+     *             as long as the preconditioner and is not considered by the sequential
+     *             variant of the preconditioner.
+     */
+    CprPreconditioner(unsigned pressureIdx,
+                      int coarsenTarget,
+                      int dimension,
+                      int refreshInterval,
+                      field_type relaxationFactor,
+                      const Communication* comm = nullptr)
+        : pressureIdx_(pressureIdx)
+        , coarsenTarget_(coarsenTarget)
+        , dimension_(dimension)
+        , refreshInterval_(refreshInterval)
+        , relaxationFactor_(relaxationFactor)
+        , comm_(comm)
+    {
+        if (isParallel && !comm_)
+            throw std::invalid_argument("The parallel CPR preconditioner requires a communication");
+    }
+
+    ~CprPreconditioner()
+    { resetAmg_(); }
+
+    /*!
+     * \brief Compute the pressure system and both stages of the preconditioner for a
+     *        matrix.
+     *
+     * The matrix must stay alive and unmodified as long as the preconditioner is applied.
+     */
+    void updateMatrix(const Matrix& matrix)
+    {
+        matrix_ = &matrix;
+
+        if (pattern_.update(matrix))
+            createPattern_(matrix);
+
+        updateWeights_(matrix);
+        updatePressureMatrix_(matrix);
+
+        if (!amg_ || numUpdatesSinceAmgSetup_ >= refreshInterval_) {
+            resetAmg_();
+
+            using SmootherArgs = typename Dune::Amg::SmootherTraits<PressureSmoother>::Arguments;
+            SmootherArgs smootherArgs;
+            smootherArgs.iterations = 1;
+            smootherArgs.relaxationFactor = 1.0;
+
+            auto coarsenCriterion = amgCoarsenCriterion<PressureMatrix>(coarsenTarget_,
+                                                                        dimension_,
+                                                                        /*verbosity=*/0);
+            if constexpr (isParallel)
+                amg_ = std::make_unique<PressureAmg>(*pressureOperator_, coarsenCriterion,
+                                                     smootherArgs, *comm_);
+            else
+                amg_ = std::make_unique<PressureAmg>(*pressureOperator_, coarsenCriterion,
+                                                     smootherArgs);
+
+            // this creates the vectors of the hierarchy. they only need to be recreated
+            // together with the hierarchy itself
+            pressureSolution_ = 0.0;
+            pressureRhs_ = 0.0;
+            amg_->pre(pressureSolution_, pressureRhs_);
+            numUpdatesSinceAmgSetup_ = 0;
+        }
+        else
+            // keep the aggregates and only recompute the matrices of the coarse levels
+            amg_->recalculateHierarchy();
+        ++numUpdatesSinceAmgSetup_;
+
+        updateSecondStage_(matrix);
+    }
+
+    void pre(domain_type&, range_type&) override
+    {}
+
+    void apply(domain_type& v, const range_type& d) override
+    {
+        const long numRows = static_cast<long>(weights_.size());
+
+        // first stage: solve the decoupled pressure system
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (long rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+            const std::size_t i = static_cast<std::size_t>(rowIdx);
+            pressureRhs_[i] = weights_[i]*d[i];
+        }
+
+        pressureSolution_ = 0.0;
+        amg_->apply(pressureSolution_, pressureRhs_);
+
+        // compute the residual which is left after the pressure correction
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (long rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+            const std::size_t i = static_cast<std::size_t>(rowIdx);
+            const auto& row = (*matrix_)[i];
+            residual_[i] = d[i];
+            for (auto colIt = row.begin(); colIt != row.end(); ++colIt) {
+                const field_type p = pressureSolution_[colIt.index()][0];
+                for (unsigned eqIdx = 0; eqIdx < VectorBlock::dimension; ++eqIdx)
+                    residual_[i][eqIdx] -= (*colIt)[eqIdx][pressureIdx_]*p;
+            }
+        }
+
+        // second stage: smooth the remaining residual of the full system
+        Dune::ILU::blockILUBacksolve(*iluMatrix_, v, residual_);
+        v *= relaxationFactor_;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (long rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+            const std::size_t i = static_cast<std::size_t>(rowIdx);
+            v[i][pressureIdx_] += pressureSolution_[i][0];
+        }
+    }
+
+    void post(domain_type&) override
+    {}
+
+    Dune::SolverCategory::Category category() const override
+    { return Dune::SolverCategory::sequential; }
+
+private:
+    void createPattern_(const Matrix& matrix)
+    {
+        resetAmg_();
+
+        const std::size_t numRows = matrix.N();
+        pressureMatrix_ = std::make_unique<PressureMatrix>();
+        copyPattern_(*pressureMatrix_, matrix);
+        iluMatrix_ = std::make_unique<IluMatrix>();
+        copyPattern_(*iluMatrix_, matrix);
+
+        if constexpr (isParallel)
+            pressureOperator_ = std::make_unique<PressureOperator>(*pressureMatrix_, *comm_);
+        else
+            pressureOperator_ = std::make_unique<PressureOperator>(*pressureMatrix_);
+
+        weights_.resize(numRows);
+        pressureRhs_.resize(numRows);
+        pressureSolution_.resize(numRows);
+        residual_.resize(numRows);
+    }
+
+    template <class TargetMatrix>
+    static void copyPattern_(TargetMatrix& target, const Matrix& matrix)
+    {
+        const std::size_t numRows = matrix.N();
+        target.setBuildMode(TargetMatrix::random);
+        target.setSize(numRows, numRows);
+        for (std::size_t rowIdx = 0; rowIdx < numRows; ++rowIdx)
+            target.setrowsize(rowIdx, matrix[rowIdx].size());
+        target.endrowsizes();
+
+        for (std::size_t rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+            const auto& row = matrix[rowIdx];
+            for (auto colIt = row.begin(); colIt != row.end(); ++colIt)
+                target.addindex(rowIdx, colIt.index());
+        }
+        target.endindices();
+    }
+
+    // copy the entries of the matrix into the storage of the ILU(0) factorization and
+    // factorize it in place. this avoids allocating the factorization for each update.
+    void updateSecondStage_(const Matrix& matrix)
+    {
+        const long numRows = static_cast<long>(matrix.N());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (long rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+            const std::size_t i = static_cast<std::size_t>(rowIdx);
+            const auto& row = matrix[i];
+            auto iluColIt = (*iluMatrix_)[i].begin();
+            for (auto colIt = row.begin(); colIt != row.end(); ++colIt, ++iluColIt)
+                *iluColIt = *colIt;
+        }
+
+        Dune::ILU::blockILU0Decomposition(*iluMatrix_);
+    }
+
+    // quasi-IMPES weights: w_i = D_i^-T e_p, i.e., the row of the inverse diagonal block
+    // which corresponds to the pressure
+    void updateWeights_(const Matrix& matrix)
+    {
+        const long numRows = static_cast<long>(matrix.N());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (long rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+            const std::size_t i = static_cast<std::size_t>(rowIdx);
+            MatrixBlock invDiag = matrix[i][i];
+            invDiag.invert();
+            for (unsigned eqIdx = 0; eqIdx < VectorBlock::dimension; ++eqIdx)
+                weights_[i][eqIdx] = invDiag[pressureIdx_][eqIdx];
+        }
+    }
+
+    void updatePressureMatrix_(const Matrix& matrix)
+    {
+        const long numRows = static_cast<long>(matrix.N());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (long rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+            const std::size_t i = static_cast<std::size_t>(rowIdx);
+            const auto& row = matrix[i];
+            auto& pressureRow = (*pressureMatrix_)[i];
+            auto pressureColIt = pressureRow.begin();
+            for (auto colIt = row.begin(); colIt != row.end(); ++colIt, ++pressureColIt) {
+                field_type value = 0.0;
+                for (unsigned eqIdx = 0; eqIdx < VectorBlock::dimension; ++eqIdx)
+                    value += weights_[i][eqIdx]*(*colIt)[eqIdx][pressureIdx_];
+                (*pressureColIt)[0][0] = value;
+            }
+        }
+    }
+
+    void resetAmg_()
+    {
+        if (amg_)
+            amg_->post(pressureSolution_);
+        amg_.reset();
+    }
+
+    unsigned pressureIdx_;
+    int coarsenTarget_;
+    int dimension_;
+    int refreshInterval_;
+    field_type relaxationFactor_;
+    const Communication* comm_;
+
+    const Matrix* matrix_ = nullptr;
+    SparsityPatternTracker pattern_;
+    std::vector<VectorBlock> weights_;
+
+    std::unique_ptr<PressureMatrix> pressureMatrix_;
+    std::unique_ptr<PressureOperator> pressureOperator_;
+    PressureVector pressureRhs_;
+    PressureVector pressureSolution_;
+    std::unique_ptr<PressureAmg> amg_;
+    int numUpdatesSinceAmgSetup_ = 0;
+
+    Vector residual_;
+    std::unique_ptr<IluMatrix> iluMatrix_;
+};
+
+}} // namespace Linear, Opm
+
+#endif
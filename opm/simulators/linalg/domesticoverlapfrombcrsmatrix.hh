@@ -31,7 +31,9 @@
 #include "blacklist.hh"
 #include "globalindices.hh"
 
-#include <opm/models/parallel/mpibuffer.hh>
+#if HAVE_MPI
+#include <mpi.h>
+#endif // HAVE_MPI
 
 #include <algorithm>
 #include <limits>
@@ -98,32 +100,29 @@ public:
         }
 #endif // NDEBUG
 
-        // send the foreign overlap for which we are master to the
-        // peers
-        std::map<int, MpiBuffer<unsigned> *> sizeBufferMap;
-
-        auto peerIt = peerSet_.begin();
-        const auto& peerEndIt = peerSet_.end();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            auto& buffer = *(new MpiBuffer<unsigned>(1));
-            sizeBufferMap[*peerIt] = &buffer;
-            buffer[0] = foreignOverlap_.foreignOverlapWithPeer(*peerIt).size();
-            buffer.send(*peerIt);
-        }
-
-        peerIt = peerSet_.begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            MpiBuffer<unsigned> rcvBuffer(1);
-            rcvBuffer.receive(*peerIt);
-
-            assert(rcvBuffer[0] == domesticOverlapWithPeer_.find(*peerIt)->second.size());
+#if HAVE_MPI
+        // send the size of the foreign overlap to the peers and
+        // receive the size of their foreign overlap with us
+        size_t numPeers = peerSet_.size();
+        std::vector<unsigned> sendSizes(numPeers);
+        std::vector<unsigned> rcvSizes(numPeers);
+        std::vector<MPI_Request> requests(2*numPeers);
+
+        size_t peerPos = 0;
+        for (auto peerIt = peerSet_.begin(); peerIt != peerSet_.end(); ++peerIt, ++peerPos) {
+            sendSizes[peerPos] =
+                static_cast<unsigned>(foreignOverlap_.foreignOverlapWithPeer(*peerIt).size());
+            MPI_Irecv(&rcvSizes[peerPos], 1, MPI_UNSIGNED, static_cast<int>(*peerIt),
+                      /*tag=*/0, MPI_COMM_WORLD, &requests[peerPos]);
+            MPI_Isend(&sendSizes[peerPos], 1, MPI_UNSIGNED, static_cast<int>(*peerIt),
+                      /*tag=*/0, MPI_COMM_WORLD, &requests[numPeers + peerPos]);
         }
+        MPI_Waitall(static_cast<int>(requests.size()), requests.data(), MPI_STATUSES_IGNORE);
 
-        peerIt = peerSet_.begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            sizeBufferMap[*peerIt]->wait();
-            delete sizeBufferMap[*peerIt];
-        }
+        peerPos = 0;
+        for (auto peerIt = peerSet_.begin(); peerIt != peerSet_.end(); ++peerIt, ++peerPos)
+            assert(rcvSizes[peerPos] == domesticOverlapWithPeer_.find(*peerIt)->second.size());
+#endif // HAVE_MPI
     }
 
     /*!
@@ -384,29 +383,63 @@ protected:
         domesticOverlapByIndex_.resize(numLocal());
         borderDistance_.resize(numLocal(), 0);
 
-        PeerSet::const_iterator peerIt;
-        PeerSet::const_iterator peerEndIt = peerSet_.end();
+#if HAVE_MPI
+        // the overlap indices of all peer processes are exchanged
+        // concurrently: first the number of indices, then the indices
+        // themselfs.
+        size_t numPeers = peerSet_.size();
+        std::vector<size_t> numIndicesSendBufs(numPeers);
+        std::vector<size_t> numIndicesRecvBufs(numPeers);
+        std::vector<std::vector<IndexDistanceNpeers> > indicesSendBufs(numPeers);
+        std::vector<std::vector<IndexDistanceNpeers> > indicesRecvBufs(numPeers);
+        std::vector<MPI_Request> sendRequests(2*numPeers);
+        std::vector<MPI_Request> recvRequests(numPeers);
+
+        size_t peerPos = 0;
+        for (auto peerIt = peerSet_.begin(); peerIt != peerSet_.end(); ++peerIt, ++peerPos) {
+            MPI_Irecv(&numIndicesRecvBufs[peerPos],
+                      sizeof(size_t),
+                      MPI_BYTE,
+                      static_cast<int>(*peerIt),
+                      /*tag=*/0,
+                      MPI_COMM_WORLD,
+                      &recvRequests[peerPos]);
+        }
 
         // send the overlap indices to all peer processes
-        peerIt = peerSet_.begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank peerRank = *peerIt;
-            sendIndicesToPeer_(peerRank);
+        peerPos = 0;
+        for (auto peerIt = peerSet_.begin(); peerIt != peerSet_.end(); ++peerIt, ++peerPos)
+            sendIndicesToPeer_(*peerIt,
+                               numIndicesSendBufs[peerPos],
+                               indicesSendBufs[peerPos],
+                               &sendRequests[2*peerPos]);
+
+        // receive our overlap from all peer processes
+        MPI_Waitall(static_cast<int>(recvRequests.size()), recvRequests.data(), MPI_STATUSES_IGNORE);
+        peerPos = 0;
+        for (auto peerIt = peerSet_.begin(); peerIt != peerSet_.end(); ++peerIt, ++peerPos) {
+            auto& recvBuf = indicesRecvBufs[peerPos];
+            recvBuf.resize(numIndicesRecvBufs[peerPos]);
+            MPI_Irecv(recvBuf.data(),
+                      static_cast<int>(recvBuf.size()*sizeof(IndexDistanceNpeers)),
+                      MPI_BYTE,
+                      static_cast<int>(*peerIt),
+                      /*tag=*/0,
+                      MPI_COMM_WORLD,
+                      &recvRequests[peerPos]);
         }
+        MPI_Waitall(static_cast<int>(recvRequests.size()), recvRequests.data(), MPI_STATUSES_IGNORE);
 
-        // receive our overlap from the processes to all peer processes
-        peerIt = peerSet_.begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank peerRank = *peerIt;
-            receiveIndicesFromPeer_(peerRank);
-        }
+        // new domestic indices are assigned in the order of the peer
+        // ranks, i.e., independently of the order in which the
+        // messages arrived
+        peerPos = 0;
+        for (auto peerIt = peerSet_.begin(); peerIt != peerSet_.end(); ++peerIt, ++peerPos)
+            addIndicesFromPeer_(*peerIt, indicesRecvBufs[peerPos]);
 
         // wait until all send operations complete
-        peerIt = peerSet_.begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank peerRank = *peerIt;
-            waitSendIndices_(peerRank);
-        }
+        MPI_Waitall(static_cast<int>(sendRequests.size()), sendRequests.data(), MPI_STATUSES_IGNORE);
+#endif // HAVE_MPI
     }
 
     void updateMasterRanks_()
@@ -444,23 +477,29 @@ protected:
         }
     }
 
-    void sendIndicesToPeer_([[maybe_unused]] ProcessRank peerRank)
-    {
 #if HAVE_MPI
+    void sendIndicesToPeer_(ProcessRank peerRank,
+                            size_t& numIndicesSendBuf,
+                            std::vector<IndexDistanceNpeers>& indicesSendBuf,
+                            MPI_Request* requests)
+    {
         const auto& foreignOverlap = foreignOverlap_.foreignOverlapWithPeer(peerRank);
 
         // first, send a message containing the number of additional
         // indices stemming from the overlap (i.e. without the border
         // indices)
         size_t numIndices = foreignOverlap.size();
-        numIndicesSendBuffer_[peerRank] = new MpiBuffer<size_t>(1);
-        (*numIndicesSendBuffer_[peerRank])[0] = numIndices;
-        numIndicesSendBuffer_[peerRank]->send(peerRank);
-
-        // create MPI buffers
-        indicesSendBuffer_[peerRank] = new MpiBuffer<IndexDistanceNpeers>(numIndices);
+        numIndicesSendBuf = numIndices;
+        MPI_Isend(&numIndicesSendBuf,
+                  sizeof(size_t),
+                  MPI_BYTE,
+                  static_cast<int>(peerRank),
+                  /*tag=*/0,
+                  MPI_COMM_WORLD,
+                  &requests[0]);
 
         // then send the additional indices themselfs
+        indicesSendBuf.resize(numIndices);
         auto overlapIt = foreignOverlap.begin();
         const auto& overlapEndIt = foreignOverlap.end();
         for (unsigned i = 0; overlapIt != overlapEndIt; ++overlapIt, ++i) {
@@ -473,37 +512,27 @@ protected:
             tmp.borderDistance = borderDistance;
             tmp.numPeers = static_cast<unsigned>(numPeers);
 
-            (*indicesSendBuffer_[peerRank])[i] = tmp;
+            indicesSendBuf[i] = tmp;
         }
 
-        indicesSendBuffer_[peerRank]->send(peerRank);
-#endif // HAVE_MPI
-    }
-
-    void waitSendIndices_(ProcessRank peerRank)
-    {
-        numIndicesSendBuffer_[peerRank]->wait();
-        delete numIndicesSendBuffer_[peerRank];
-
-        indicesSendBuffer_[peerRank]->wait();
-        delete indicesSendBuffer_[peerRank];
+        MPI_Isend(indicesSendBuf.data(),
+                  static_cast<int>(numIndices*sizeof(IndexDistanceNpeers)),
+                  MPI_BYTE,
+                  static_cast<int>(peerRank),
+                  /*tag=*/0,
+                  MPI_COMM_WORLD,
+                  &requests[1]);
     }
+#endif // HAVE_MPI
 
-    void receiveIndicesFromPeer_([[maybe_unused]] ProcessRank peerRank)
+    void addIndicesFromPeer_(ProcessRank peerRank,
+                             const std::vector<IndexDistanceNpeers>& recvBuff)
     {
-#if HAVE_MPI
-        // receive the number of additional indices
-        int numIndices = -1;
-        MpiBuffer<size_t> numIndicesRecvBuff(1);
-        numIndicesRecvBuff.receive(peerRank);
-        numIndices = static_cast<int>(numIndicesRecvBuff[0]);
-
-        // receive the additional indices themselfs
-        MpiBuffer<IndexDistanceNpeers> recvBuff(static_cast<size_t>(numIndices));
-        recvBuff.receive(peerRank);
-        for (unsigned i = 0; i < static_cast<unsigned>(numIndices); ++i) {
-            Index globalIdx = recvBuff[i].index;
-            BorderDistance borderDistance = recvBuff[i].borderDistance;
+        auto& overlapWithPeer = domesticOverlapWithPeer_[peerRank];
+        overlapWithPeer.reserve(overlapWithPeer.size() + recvBuff.size());
+        for (const auto& entry : recvBuff) {
+            Index globalIdx = entry.index;
+            BorderDistance borderDistance = entry.borderDistance;
 
             // if the index is not already known, add it to the
             // domestic indices
@@ -521,7 +550,7 @@ protected:
 
             // extend the domestic overlap
             domesticOverlapByIndex_[static_cast<unsigned>(domesticIdx)][static_cast<unsigned>(peerRank)] = borderDistance;
-            domesticOverlapWithPeer_[static_cast<unsigned>(peerRank)].push_back(domesticIdx);
+            overlapWithPeer.push_back(domesticIdx);
 
             //assert(borderDistance >= 0);
             assert(globalIdx >= 0);
@@ -531,7 +560,6 @@ protected:
 
             borderDistance_[static_cast<unsigned>(domesticIdx)] = std::min(borderDistance, borderDistance_[static_cast<unsigned>(domesticIdx)]);
         }
-#endif // HAVE_MPI
     }
 
     // this method is intended to set up the code mapping code for
@@ -571,8 +599,6 @@ protected:
     std::vector<BorderDistance> borderDistance_;
     std::vector<ProcessRank> masterRank_;
 
-    std::map<ProcessRank, MpiBuffer<size_t> *> numIndicesSendBuffer_;
-    std::map<ProcessRank, MpiBuffer<IndexDistanceNpeers> *> indicesSendBuffer_;
     GlobalIndices globalIndices_;
     PeerSet peerSet_;
 };
@@ -30,16 +30,16 @@
 #include "overlaptypes.hh"
 #include "blacklist.hh"
 
-#include <opm/models/parallel/mpibuffer.hh>
-
 #include <dune/grid/common/datahandleif.hh>
 #include <dune/istl/bcrsmatrix.hh>
 #include <dune/istl/scalarproducts.hh>
 #include <dune/istl/operators.hh>
 
 #include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <map>
+#include <unordered_set>
 #include <vector>
 
 #if HAVE_MPI
@@ -90,6 +90,7 @@ public:
 
         // calculate the set of local indices on the border (beware:
         // _not_ the native ones)
+        isLocalBorder_.resize(numLocal(), false);
         auto it = borderList.begin();
         const auto& endIt = borderList.end();
         for (; it != endIt; ++it) {
@@ -97,9 +98,19 @@ public:
             if (localIdx < 0)
                 continue;
 
-            localBorderIndices_.insert(localIdx);
+            isLocalBorder_[static_cast<unsigned>(localIdx)] = true;
         }
 
+        // sort a copy of the border list by index and peer rank to allow fast look-ups
+        // of the index of a border entity on a peer process
+        sortedBorderList_.assign(borderList.begin(), borderList.end());
+        std::stable_sort(sortedBorderList_.begin(), sortedBorderList_.end(),
+                         [](const BorderIndex& a, const BorderIndex& b)
+                         {
+                             return a.localIdx < b.localIdx
+                                 || (a.localIdx == b.localIdx && a.peerRank < b.peerRank);
+                         });
+
         // compute the set of processes which are neighbors of the
         // local process ...
         neighborPeerSet_.update(borderList);
@@ -147,7 +158,11 @@ public:
      * \brief Returns true iff a local index is a border index.
      */
     bool isBorder(Index localIdx) const
-    { return localBorderIndices_.count(localIdx) > 0; }
+    {
+        return localIdx >= 0
+            && static_cast<size_t>(localIdx) < isLocalBorder_.size()
+            && isLocalBorder_[static_cast<unsigned>(localIdx)];
+    }
 
     /*!
      * \brief Returns true iff a local index is a border index shared with a
@@ -375,6 +390,7 @@ protected:
         // find the seed list for the next overlap level using the
         // seed set for the current level
         SeedList nextSeedList;
+        std::unordered_set<std::uint64_t> nextSeedKeys;
         seedIt = seedList.begin();
         for (; seedIt != seedEndIt; ++seedIt) {
             Index nativeRowIdx = seedIt->index;
@@ -401,16 +417,7 @@ protected:
                     continue;
 
                 // check whether the new index is already in the overlap
-                bool hasIndex = false;
-                typename SeedList::iterator sIt = nextSeedList.begin();
-                typename SeedList::iterator sEndIt = nextSeedList.end();
-                for (; sIt != sEndIt; ++sIt) {
-                    if (sIt->index == nativeColIdx && sIt->peerRank == peerRank) {
-                        hasIndex = true;
-                        break;
-                    }
-                }
-                if (hasIndex)
+                if (!nextSeedKeys.insert(seedKey_(nativeColIdx, peerRank)).second)
                     continue; // we already have this index
 
                 // add the current processes to the seed list for the
@@ -453,16 +460,26 @@ protected:
 
     Index localToPeerIdx_(Index localIdx, ProcessRank peerRank) const
     {
-        auto it = borderList_.begin();
-        const auto& endIt = borderList_.end();
-        for (; it != endIt; ++it) {
-            if (it->localIdx == localIdx && it->peerRank == peerRank)
-                return it->peerIdx;
-        }
+        auto it = std::lower_bound(sortedBorderList_.begin(), sortedBorderList_.end(),
+                                   std::make_pair(localIdx, peerRank),
+                                   [](const BorderIndex& a, const std::pair<Index, ProcessRank>& b)
+                                   {
+                                       return a.localIdx < b.first
+                                           || (a.localIdx == b.first && a.peerRank < b.second);
+                                   });
+        if (it != sortedBorderList_.end() && it->localIdx == localIdx && it->peerRank == peerRank)
+            return it->peerIdx;
 
         return -1;
     }
 
+    // combines an index and a process rank into a single key for hash sets
+    static std::uint64_t seedKey_(Index idx, ProcessRank peerRank)
+    {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(idx)) << 32)
+            | static_cast<std::uint64_t>(peerRank);
+    }
+
     template <class BCRSMatrix>
     void addNonNeighborOverlapIndices_(const BCRSMatrix&,
                                        [[maybe_unused]] SeedList& seedList,
@@ -513,61 +530,68 @@ protected:
         // now borderIndices contains the lists of indices which we
         // would like to send to each neighbor. Let's create the MPI
         // buffers.
-        std::map<ProcessRank, Opm::MpiBuffer<unsigned> > numIndicesSendBufs;
-        std::map<ProcessRank, Opm::MpiBuffer<BorderIndex> > indicesSendBufs;
-        auto peerIt = neighborPeerSet().begin();
-        const auto& peerEndIt = neighborPeerSet().end();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank peerRank = *peerIt;
-            size_t numIndices = borderIndices[peerRank].size();
-            numIndicesSendBufs[peerRank].resize(1);
-            numIndicesSendBufs[peerRank][0] = static_cast<unsigned>(numIndices);
-
-            const auto& peerBorderIndices = borderIndices[peerRank];
-            indicesSendBufs[peerRank].resize(numIndices);
-
-            auto tmpIt = peerBorderIndices.begin();
-            const auto& tmpEndIt = peerBorderIndices.end();
-            size_t i = 0;
-            for (; tmpIt != tmpEndIt; ++tmpIt, ++i) {
-                indicesSendBufs[peerRank][i] = *tmpIt;
-            }
+        const PeerSet& neighborPeers = neighborPeerSet();
+        size_t numNeighbors = neighborPeers.size();
+        std::vector<unsigned> numIndicesSendBufs(numNeighbors);
+        std::vector<unsigned> numIndicesRcvBufs(numNeighbors);
+        std::vector<std::vector<BorderIndex> > indicesRcvBufs(numNeighbors);
+        std::vector<MPI_Request> sendRequests(2*numNeighbors);
+        std::vector<MPI_Request> rcvRequests(numNeighbors);
+
+        // post the receives for the number of indices of all neighbors and send all
+        // these nice buffers to our neighbors. the messages of all neighbors are
+        // exchanged concurrently.
+        size_t peerPos = 0;
+        for (auto peerIt = neighborPeers.begin(); peerIt != neighborPeers.end(); ++peerIt, ++peerPos) {
+            int neighborPeer = static_cast<int>(*peerIt);
+            MPI_Irecv(&numIndicesRcvBufs[peerPos], 1, MPI_UNSIGNED, neighborPeer,
+                      /*tag=*/0, MPI_COMM_WORLD, &rcvRequests[peerPos]);
         }
 
-        // now, send all these nice buffers to our neighbors
-        peerIt = neighborPeerSet().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank neighborPeer = *peerIt;
-            numIndicesSendBufs[neighborPeer].send(neighborPeer);
-            indicesSendBufs[neighborPeer].send(neighborPeer);
+        peerPos = 0;
+        for (auto peerIt = neighborPeers.begin(); peerIt != neighborPeers.end(); ++peerIt, ++peerPos) {
+            const auto& peerBorderIndices = borderIndices[*peerIt];
+            int neighborPeer = static_cast<int>(*peerIt);
+            numIndicesSendBufs[peerPos] = static_cast<unsigned>(peerBorderIndices.size());
+            MPI_Isend(&numIndicesSendBufs[peerPos], 1, MPI_UNSIGNED, neighborPeer,
+                      /*tag=*/0, MPI_COMM_WORLD, &sendRequests[2*peerPos]);
+            MPI_Isend(peerBorderIndices.data(),
+                      static_cast<int>(peerBorderIndices.size()*sizeof(BorderIndex)),
+                      MPI_BYTE, neighborPeer,
+                      /*tag=*/0, MPI_COMM_WORLD, &sendRequests[2*peerPos + 1]);
         }
 
         // receive all data from the neighbors
-        std::map<ProcessRank, MpiBuffer<unsigned> > numIndicesRcvBufs;
-        std::map<ProcessRank, MpiBuffer<BorderIndex> > indicesRcvBufs;
-        peerIt = neighborPeerSet().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank neighborPeer = *peerIt;
-            auto& numIndicesRcvBuf = numIndicesRcvBufs[neighborPeer];
-            auto& indicesRcvBuf = indicesRcvBufs[neighborPeer];
-
-            numIndicesRcvBuf.resize(1);
-            numIndicesRcvBuf.receive(neighborPeer);
-            unsigned numIndices = numIndicesRcvBufs[neighborPeer][0];
-            indicesRcvBuf.resize(numIndices);
-            indicesRcvBuf.receive(neighborPeer);
+        MPI_Waitall(static_cast<int>(rcvRequests.size()), rcvRequests.data(), MPI_STATUSES_IGNORE);
+        peerPos = 0;
+        for (auto peerIt = neighborPeers.begin(); peerIt != neighborPeers.end(); ++peerIt, ++peerPos) {
+            auto& indicesRcvBuf = indicesRcvBufs[peerPos];
+            indicesRcvBuf.resize(numIndicesRcvBufs[peerPos]);
+            MPI_Irecv(indicesRcvBuf.data(),
+                      static_cast<int>(indicesRcvBuf.size()*sizeof(BorderIndex)),
+                      MPI_BYTE, static_cast<int>(*peerIt),
+                      /*tag=*/0, MPI_COMM_WORLD, &rcvRequests[peerPos]);
+        }
+        MPI_Waitall(static_cast<int>(rcvRequests.size()), rcvRequests.data(), MPI_STATUSES_IGNORE);
 
+        // the set of (index, peer rank) pairs which are already in the seed list
+        std::unordered_set<std::uint64_t> seedKeys;
+        for (const auto& seed : seedList)
+            seedKeys.insert(seedKey_(seed.index, seed.peerRank));
+
+        // process the received indices in the order of the neighbor ranks to keep the
+        // result independent of the order in which the messages arrived
+        for (auto& indicesRcvBuf : indicesRcvBufs) {
             // filter out all indices which are already in the peer
             // processes' overlap and add them to the seed list. also
             // extend the set of peer processes.
-            for (unsigned i = 0; i < numIndices; ++i) {
+            for (auto& rcvIdx : indicesRcvBuf) {
                 // swap the local and the peer indices, because they were
                 // created with the point view of the sender
-                std::swap(indicesRcvBuf[i].localIdx, indicesRcvBuf[i].peerIdx);
+                std::swap(rcvIdx.localIdx, rcvIdx.peerIdx);
 
-                ProcessRank peerRank = indicesRcvBuf[i].peerRank;
-                // Index peerIdx = indicesRcvBuf[i].peerIdx;
-                Index localIdx = indicesRcvBuf[i].localIdx;
+                ProcessRank peerRank = rcvIdx.peerRank;
+                Index localIdx = rcvIdx.localIdx;
 
                 // check if the index is already in the overlap for
                 // the peer
@@ -576,16 +600,7 @@ protected:
                     continue;
 
                 // make sure the index is not already in the seed list
-                bool inSeedList = false;
-                auto seedIt = seedList.begin();
-                const auto& seedEndIt = seedList.end();
-                for (; seedIt != seedEndIt; ++seedIt) {
-                    if (seedIt->index == localIdx && seedIt->peerRank == peerRank) {
-                        inSeedList = true;
-                        break;
-                    }
-                }
-                if (inSeedList)
+                if (!seedKeys.insert(seedKey_(localIdx, peerRank)).second)
                     continue;
 
                 IndexRankDist seedEntry;
@@ -600,12 +615,7 @@ protected:
         }
 
         // make sure all data was send
-        peerIt = neighborPeerSet().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank neighborPeer = *peerIt;
-            numIndicesSendBufs[neighborPeer].wait();
-            indicesSendBufs[neighborPeer].wait();
-        }
+        MPI_Waitall(static_cast<int>(sendRequests.size()), sendRequests.data(), MPI_STATUSES_IGNORE);
 #endif // HAVE_MPI
     }
 
@@ -616,7 +626,11 @@ protected:
     {
         // determine the minimum rank for all indices
         masterRank_.resize(numLocal_);
-        for (unsigned localIdx = 0; localIdx < numLocal_; ++localIdx) {
+        const long numLocal = static_cast<long>(numLocal_);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (long localIdx = 0; localIdx < numLocal; ++localIdx) {
             unsigned masterRank = myRank_;
             if (isBorder(static_cast<Index>(localIdx))) {
                 // if the local index is a border index, loop over all ranks
@@ -679,9 +693,12 @@ protected:
     // index
     std::vector<ProcessRank> masterRank_;
 
-    // set of all local indices which are on the border of some remote
+    // specifies for each local index whether it is on the border of some remote
     // process
-    std::set<Index> localBorderIndices_;
+    std::vector<bool> isLocalBorder_;
+
+    // the border list sorted by index and peer rank
+    std::vector<BorderIndex> sortedBorderList_;
 
     // stores the set of process ranks which are in the overlap for a
     // given row index "owned" by the current rank. The second value
@@ -33,10 +33,12 @@
 #include <dune/istl/operators.hh>
 
 #include <algorithm>
-#include <set>
-#include <map>
+#include <cassert>
 #include <iostream>
-#include <tuple>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #if HAVE_MPI
 #include <mpi.h>
@@ -56,8 +58,10 @@ class GlobalIndices
 {
     GlobalIndices(const GlobalIndices& ) = delete;
 
-    using GlobalToDomesticMap = std::map<Index, Index>;
-    using DomesticToGlobalMap = std::map<Index, Index>;
+    // domestic indices are contiguous, so the domestic to global mapping can be stored
+    // as a flat array. -1 marks domestic indices which are not yet known.
+    using GlobalToDomesticMap = std::unordered_map<Index, Index>;
+    using DomesticToGlobalMap = std::vector<Index>;
 
 public:
     GlobalIndices(const ForeignOverlap& foreignOverlap)
@@ -87,9 +91,11 @@ public:
      */
     Index domesticToGlobal(Index domesticIdx) const
     {
-        assert(domesticToGlobal_.find(domesticIdx) != domesticToGlobal_.end());
+        assert(domesticIdx >= 0);
+        assert(static_cast<size_t>(domesticIdx) < domesticToGlobal_.size());
+        assert(domesticToGlobal_[static_cast<size_t>(domesticIdx)] >= 0);
 
-        return domesticToGlobal_.find(domesticIdx)->second;
+        return domesticToGlobal_[static_cast<size_t>(domesticIdx)];
     }
 
     /*!
@@ -126,55 +132,18 @@ public:
      */
     void addIndex(Index domesticIdx, Index globalIdx)
     {
-        domesticToGlobal_[domesticIdx] = globalIdx;
-        globalToDomestic_[globalIdx] = domesticIdx;
-        numDomestic_ = domesticToGlobal_.size();
+        assert(domesticIdx >= 0 && globalIdx >= 0);
 
-        assert(domesticToGlobal_.size() == globalToDomestic_.size());
-    }
+        size_t idx = static_cast<size_t>(domesticIdx);
+        if (idx >= domesticToGlobal_.size())
+            domesticToGlobal_.resize(idx + 1, -1);
 
-    /*!
-     * \brief Send a border index to a remote process.
-     */
-    void sendBorderIndex([[maybe_unused]] ProcessRank peerRank,
-                         [[maybe_unused]] Index domesticIdx,
-                         [[maybe_unused]] Index peerLocalIdx)
-    {
-#if HAVE_MPI
-        PeerIndexGlobalIndex sendBuf;
-        sendBuf.peerIdx = peerLocalIdx;
-        sendBuf.globalIdx = domesticToGlobal(domesticIdx);
-        MPI_Send(&sendBuf,                     // buff
-                 sizeof(PeerIndexGlobalIndex), // count
-                 MPI_BYTE,                     // data type
-                 static_cast<int>(peerRank),   // peer process
-                 0,                            // tag
-                 MPI_COMM_WORLD);              // communicator
-#endif
-    }
+        if (domesticToGlobal_[idx] < 0)
+            ++numDomestic_;
+        domesticToGlobal_[idx] = globalIdx;
+        globalToDomestic_[globalIdx] = domesticIdx;
 
-    /*!
-     * \brief Receive an index on the border from a remote
-     *        process and add it the translation maps.
-     */
-    void receiveBorderIndex([[maybe_unused]] ProcessRank peerRank)
-    {
-#if HAVE_MPI
-        PeerIndexGlobalIndex recvBuf;
-        MPI_Recv(&recvBuf,                     // buff
-                 sizeof(PeerIndexGlobalIndex), // count
-                 MPI_BYTE,                     // data type
-                 static_cast<int>(peerRank),   // peer process
-                 0,                            // tag
-                 MPI_COMM_WORLD,               // communicator
-                 MPI_STATUS_IGNORE);           // status
-
-        Index domesticIdx = foreignOverlap_.nativeToLocal(recvBuf.peerIdx);
-        if (domesticIdx >= 0) {
-            Index globalIdx = recvBuf.globalIdx;
-            addIndex(domesticIdx, globalIdx);
-        }
-#endif // HAVE_MPI
+        assert(numDomestic_ == globalToDomestic_.size());
     }
 
     /*!
@@ -192,7 +161,7 @@ public:
         std::cout << "(domestic index, global index, domestic->global->domestic)"
                   << " list for rank " << myRank_ << "\n";
 
-        for (size_t domIdx = 0; domIdx < domesticToGlobal_.size(); ++domIdx)
+        for (size_t domIdx = 0; domIdx < numDomestic_; ++domIdx)
             std::cout << "(" << domIdx << ", " << domesticToGlobal(domIdx)
                       << ", " << globalToDomestic(domesticToGlobal(domIdx)) << ") ";
         std::cout << "\n" << std::flush;
@@ -203,131 +172,121 @@ protected:
     // global index list
     void buildGlobalIndices_()
     {
-#if HAVE_MPI
         numDomestic_ = 0;
-#else
-        numDomestic_ = foreignOverlap_.numLocal();
-#endif
+        domesticToGlobal_.assign(foreignOverlap_.numLocal(), -1);
+        globalToDomestic_.reserve(foreignOverlap_.numLocal());
 
 #if HAVE_MPI
-        if (myRank_ == 0) {
-            // the first rank starts at index zero
-            domesticOffset_ = 0;
-        }
-        else {
-            // all other ranks retrieve their offset from the next
-            // lower rank
-            MPI_Recv(&domesticOffset_, // buffer
-                     1,                // count
-                     MPI_INT,          // data type
-                     static_cast<int>(myRank_ - 1), // peer rank
-                     0,                // tag
-                     MPI_COMM_WORLD,   // communicator
-                     MPI_STATUS_IGNORE);
+        // count the indices for which the current process is the master
+        int numMaster = 0;
+        for (unsigned i = 0; i < foreignOverlap_.numLocal(); ++i) {
+            if (foreignOverlap_.iAmMasterOf(static_cast<Index>(i)))
+                ++numMaster;
         }
 
+        // the offset of the current rank is the number of master indices of all
+        // lower ranks. the result of the exclusive scan is undefined on the first
+        // rank which starts at index zero.
+        domesticOffset_ = 0;
+        MPI_Exscan(&numMaster, &domesticOffset_, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+        if (myRank_ == 0)
+            domesticOffset_ = 0;
+
         // create maps for all indices for which the current process
         // is the master
-        int numMaster = 0;
+        Index nextGlobalIdx = static_cast<Index>(domesticOffset_);
         for (unsigned i = 0; i < foreignOverlap_.numLocal(); ++i) {
-            if (!foreignOverlap_.iAmMasterOf(static_cast<Index>(i)))
-                continue;
-
-            addIndex(static_cast<Index>(i),
-                     static_cast<Index>(domesticOffset_ + numMaster));
-            ++numMaster;
+            if (foreignOverlap_.iAmMasterOf(static_cast<Index>(i)))
+                addIndex(static_cast<Index>(i), nextGlobalIdx++);
         }
 
-        if (myRank_ < mpiSize_ - 1) {
-            // send the domestic offset plus the number of master
-            // indices to the process which is one rank higher
-            int tmp = domesticOffset_ + numMaster;
-            MPI_Send(&tmp,            // buff
-                     1,               // count
-                     MPI_INT,         // data type
-                     static_cast<int>(myRank_ + 1), // peer rank
-                     0,               // tag
-                     MPI_COMM_WORLD); // communicator
-        }
+        exchangeBorderIndices_();
+#else
+        for (unsigned i = 0; i < foreignOverlap_.numLocal(); ++i)
+            addIndex(static_cast<Index>(i), static_cast<Index>(i));
+#endif // HAVE_MPI
+    }
 
-        typename PeerSet::const_iterator peerIt;
-        typename PeerSet::const_iterator peerEndIt = peerSet_().end();
-        // receive the border indices from the lower ranks
-        peerIt = peerSet_().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            if (*peerIt < myRank_)
-                receiveBorderFrom_(*peerIt);
+#if HAVE_MPI
+    // send the global indices of the border indices for which we are master to all
+    // neighbors and receive the ones for which a neighbor is master. Since the global
+    // indices of the master indices are known at this point, all messages are
+    // independent of each other. There is exactly one message per neighbor and
+    // direction. The size of the received messages is determined by probing, so the
+    // receive buffers always fit the messages which are actually sent by the peers.
+    void exchangeBorderIndices_()
+    {
+        const PeerSet& peerSet = foreignOverlap_.neighborPeerSet();
+        size_t numPeers = peerSet.size();
+
+        std::vector<std::vector<PeerIndexGlobalIndex> > sendBufs(numPeers);
+        std::vector<PeerIndexGlobalIndex> recvBuf;
+        std::vector<MPI_Request> sendRequests(numPeers);
+
+        size_t peerPos = 0;
+        for (auto peerIt = peerSet.begin(); peerIt != peerSet.end(); ++peerIt, ++peerPos) {
+            fillBorderSendBuffer_(sendBufs[peerPos], *peerIt);
+            MPI_Isend(sendBufs[peerPos].data(),
+                      static_cast<int>(sendBufs[peerPos].size()*sizeof(PeerIndexGlobalIndex)),
+                      MPI_BYTE,
+                      static_cast<int>(*peerIt),
+                      0, // tag
+                      MPI_COMM_WORLD,
+                      &sendRequests[peerPos]);
         }
 
-        // send the border indices to the higher ranks
-        peerIt = peerSet_().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            if (*peerIt > myRank_)
-                sendBorderTo_(*peerIt);
-        }
+        for (auto peerIt = peerSet.begin(); peerIt != peerSet.end(); ++peerIt) {
+            MPI_Status status;
+            MPI_Probe(static_cast<int>(*peerIt), /*tag=*/0, MPI_COMM_WORLD, &status);
+
+            int numBytes;
+            MPI_Get_count(&status, MPI_BYTE, &numBytes);
+            if (numBytes == MPI_UNDEFINED
+                || static_cast<size_t>(numBytes) % sizeof(PeerIndexGlobalIndex) != 0)
+                throw std::runtime_error("Received a message of invalid size while exchanging "
+                                         "the global indices of the border with rank "
+                                         + std::to_string(*peerIt));
+
+            recvBuf.resize(static_cast<size_t>(numBytes)/sizeof(PeerIndexGlobalIndex));
+            MPI_Recv(recvBuf.data(),
+                     numBytes,
+                     MPI_BYTE,
+                     static_cast<int>(*peerIt),
+                     0, // tag
+                     MPI_COMM_WORLD,
+                     MPI_STATUS_IGNORE);
 
-        // receive the border indices from the higher ranks
-        peerIt = peerSet_().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            if (*peerIt > myRank_)
-                receiveBorderFrom_(*peerIt);
+            for (const auto& entry : recvBuf) {
+                Index domesticIdx = foreignOverlap_.nativeToLocal(entry.peerIdx);
+                if (domesticIdx >= 0)
+                    addIndex(domesticIdx, entry.globalIdx);
+            }
         }
 
-        // send the border indices to the lower ranks
-        peerIt = peerSet_().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            if (*peerIt < myRank_)
-                sendBorderTo_(*peerIt);
-        }
-#endif // HAVE_MPI
+        MPI_Waitall(static_cast<int>(sendRequests.size()), sendRequests.data(), MPI_STATUSES_IGNORE);
     }
 
-    void sendBorderTo_([[maybe_unused]] ProcessRank peerRank)
+    // collect the (local index on the peer rank, global index) pairs of all border
+    // indices shared with a peer for which the current process is the master
+    void fillBorderSendBuffer_(std::vector<PeerIndexGlobalIndex>& sendBuf,
+                               ProcessRank peerRank) const
     {
-#if HAVE_MPI
-        // send (local index on myRank, global index) pairs to the
-        // peers
-        BorderList::const_iterator borderIt = borderList_().begin();
-        BorderList::const_iterator borderEndIt = borderList_().end();
-        for (; borderIt != borderEndIt; ++borderIt) {
-            ProcessRank borderPeer = borderIt->peerRank;
-            BorderDistance borderDistance = borderIt->borderDistance;
-            if (borderPeer != peerRank || borderDistance != 0)
+        sendBuf.clear();
+        for (const auto& borderIdx : borderList_()) {
+            if (borderIdx.peerRank != peerRank || borderIdx.borderDistance != 0)
                 continue;
 
-            Index localIdx = foreignOverlap_.nativeToLocal(borderIt->localIdx);
-            Index peerIdx = borderIt->peerIdx;
+            Index localIdx = foreignOverlap_.nativeToLocal(borderIdx.localIdx);
             assert(localIdx >= 0);
             if (foreignOverlap_.iAmMasterOf(localIdx)) {
-                sendBorderIndex(borderPeer, localIdx, peerIdx);
+                PeerIndexGlobalIndex entry;
+                entry.peerIdx = borderIdx.peerIdx;
+                entry.globalIdx = domesticToGlobal(localIdx);
+                sendBuf.push_back(entry);
             }
         }
-#endif // HAVE_MPI
     }
-
-    void receiveBorderFrom_([[maybe_unused]] ProcessRank peerRank)
-    {
-#if HAVE_MPI
-        // retrieve the global indices for which we are not master
-        // from the processes with lower rank
-        BorderList::const_iterator borderIt = borderList_().begin();
-        BorderList::const_iterator borderEndIt = borderList_().end();
-        for (; borderIt != borderEndIt; ++borderIt) {
-            ProcessRank borderPeer = borderIt->peerRank;
-            BorderDistance borderDistance = borderIt->borderDistance;
-            if (borderPeer != peerRank || borderDistance != 0)
-                continue;
-
-            Index nativeIdx = borderIt->localIdx;
-            Index localIdx = foreignOverlap_.nativeToLocal(nativeIdx);
-            if (localIdx >= 0 && foreignOverlap_.masterRank(localIdx) == borderPeer)
-                receiveBorderIndex(borderPeer);
-        }
 #endif // HAVE_MPI
-    }
-
-    const PeerSet& peerSet_() const
-    { return foreignOverlap_.peerSet(); }
 
     const BorderList& borderList_() const
     { return foreignOverlap_.borderList(); }
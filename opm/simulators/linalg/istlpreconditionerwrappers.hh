@@ -40,6 +40,15 @@
  * - \c SOR: A successive overrelaxation (SOR) preconditioner
  * - \c ILUn: An ILU(n) preconditioner
  * - \c ILU0: A specialized (and optimized) ILU(0) preconditioner
+ * - \c ReorderedILU: An ILU(0) preconditioner which operates on the linear system of
+ *                    equations in reverse Cuthill-McKee ordering
+ * - \c CPR: A two-stage constrained pressure residual preconditioner which combines
+ *           an AMG for the pressure with ILU(0) for the full system
+ * - \c MultiColor: A multi-threaded block-Jacobi, block-Gauss-Seidel or block-ILU(0)
+ *                  preconditioner which processes the rows color by color. The method
+ *                  is selected by the "PreconditionerMultiColorMethod" parameter.
+ * - \c Runtime: Selects ILU(0), ReorderedILU, MultiColor or CPR using the
+ *               "PreconditionerType" parameter.
  */
 #ifndef EWOMS_ISTL_PRECONDITIONER_WRAPPERS_HH
 #define EWOMS_ISTL_PRECONDITIONER_WRAPPERS_HH
@@ -48,10 +57,23 @@
 #include <opm/models/utils/parametersystem.hh>
 #include <opm/simulators/linalg/linalgproperties.hh>
 #include <opm/simulators/linalg/ilufirstelement.hh> //definitions needed in next header
+#include <opm/simulators/linalg/reorderedpreconditioner.hh>
+#include <opm/simulators/linalg/multicolorpreconditioner.hh>
+#include <opm/simulators/linalg/cprpreconditioner.hh>
+#include <opm/simulators/linalg/amgindexset.hh>
+#include <opm/simulators/linalg/sparsitypatterntracker.hh>
 #include <dune/istl/preconditioners.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
 
 #include <dune/common/version.hh>
 
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
 namespace Opm {
 namespace Linear {
 #define EWOMS_WRAP_ISTL_PRECONDITIONER(PREC_NAME, ISTL_PREC_TYPE)               \
@@ -186,6 +208,427 @@ private:
     SequentialPreconditioner *seqPreCond_;
 };
 
+/*!
+ * \brief An ILU(0) preconditioner which factorizes the matrix in reverse Cuthill-McKee
+ *        ordering.
+ *
+ * The ordering is computed from the sparsity pattern of the matrix and is reused until
+ * the structure of the matrix changes. Everything outside of the preconditioner keeps
+ * using the numbering of the degrees of freedom which is given by the grid.
+ */
+template <class TypeTag>
+class PreconditionerWrapperReorderedILU
+{
+    using Scalar = GetPropType<TypeTag, Properties::Scalar>;
+    using OverlappingMatrix = GetPropType<TypeTag, Properties::OverlappingMatrix>;
+    using OverlappingVector = GetPropType<TypeTag, Properties::OverlappingVector>;
+
+    using PermutedMatrix = Dune::BCRSMatrix<typename OverlappingMatrix::block_type>;
+    using PermutedVector = Dune::BlockVector<typename OverlappingVector::block_type>;
+    using InnerPreconditioner = Dune::SeqILU<PermutedMatrix, PermutedVector, PermutedVector>;
+
+public:
+    using SequentialPreconditioner = ReorderedPreconditioner<InnerPreconditioner, OverlappingVector>;
+
+    PreconditionerWrapperReorderedILU()
+    {}
+
+    static void registerParameters()
+    {
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, PreconditionerRelaxation,
+                             "The relaxation factor of the preconditioner");
+    }
+
+    void prepare(OverlappingMatrix& matrix)
+    {
+        // the ordering and the structure of the permuted matrix only depend on the
+        // sparsity pattern of the matrix
+        if (pattern_.update(matrix) || !seqPreCond_)
+            seqPreCond_ = std::make_unique<SequentialPreconditioner>(reverseCuthillMcKeeOrdering(matrix));
+
+        seqPreCond_->updateMatrix(matrix);
+
+        Scalar relaxationFactor = EWOMS_GET_PARAM(TypeTag, Scalar, PreconditionerRelaxation);
+        seqPreCond_->setInnerPreconditioner(
+            std::make_unique<InnerPreconditioner>(seqPreCond_->permutedMatrix(), relaxationFactor));
+    }
+
+    SequentialPreconditioner& get()
+    { return *seqPreCond_; }
+
+    void cleanup()
+    {
+        // keep the ordering and the structure of the permuted matrix for the next
+        // linear solve
+        seqPreCond_->setInnerPreconditioner(nullptr);
+    }
+
+    void invalidate()
+    {
+        seqPreCond_.reset();
+        pattern_ = SparsityPatternTracker();
+    }
+
+private:
+    std::unique_ptr<SequentialPreconditioner> seqPreCond_;
+    SparsityPatternTracker pattern_;
+};
+
+/*!
+ * \brief A preconditioner which uses all threads of the process.
+ *
+ * The rows of the matrix are colored such that rows of the same color are independent of
+ * each other. The coloring is computed from the sparsity pattern of the matrix and is
+ * reused until the structure of the matrix changes.
+ */
+template <class TypeTag>
+class PreconditionerWrapperMultiColor
+{
+    using Scalar = GetPropType<TypeTag, Properties::Scalar>;
+    using OverlappingMatrix = GetPropType<TypeTag, Properties::OverlappingMatrix>;
+    using OverlappingVector = GetPropType<TypeTag, Properties::OverlappingVector>;
+
+public:
+    using SequentialPreconditioner = MultiColorPreconditioner<OverlappingMatrix, OverlappingVector>;
+
+    PreconditionerWrapperMultiColor()
+    {}
+
+    static void registerParameters()
+    {
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, PreconditionerRelaxation,
+                             "The relaxation factor of the preconditioner");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, PreconditionerMultiColorMethod,
+                             "The method used by the multi-color preconditioner. "
+                             "Possible values: 'ilu0', 'jacobi' and 'gauss-seidel'");
+    }
+
+    void prepare(OverlappingMatrix& matrix)
+    {
+        Scalar relaxationFactor = EWOMS_GET_PARAM(TypeTag, Scalar, PreconditionerRelaxation);
+        if (!seqPreCond_)
+            seqPreCond_ = std::make_unique<SequentialPreconditioner>(method_(), relaxationFactor);
+        else
+            seqPreCond_->setRelaxationFactor(relaxationFactor);
+
+        seqPreCond_->updateMatrix(matrix);
+    }
+
+    SequentialPreconditioner& get()
+    { return *seqPreCond_; }
+
+    void cleanup()
+    {
+        // keep the coloring and the storage of the factorization for the next linear
+        // solve
+    }
+
+    void invalidate()
+    { seqPreCond_.reset(); }
+
+private:
+    static typename SequentialPreconditioner::Method method_()
+    {
+        using Method = typename SequentialPreconditioner::Method;
+
+        const std::string method = EWOMS_GET_PARAM(TypeTag, std::string, PreconditionerMultiColorMethod);
+        if (method == "ilu0")
+            return Method::ILU0;
+        else if (method == "jacobi")
+            return Method::Jacobi;
+        else if (method == "gauss-seidel")
+            return Method::GaussSeidel;
+
+        throw std::invalid_argument("Unknown multi-color preconditioner method '"+method+"'. "
+                                    "Valid values are 'ilu0', 'jacobi' and 'gauss-seidel'");
+    }
+
+    std::unique_ptr<SequentialPreconditioner> seqPreCond_;
+};
+
+// wrappers which keep data across linear solves provide an invalidate() method which
+// discards all data that depends on the overlapping matrix
+template <class Wrapper, class Enable = void>
+struct HasPreconditionerInvalidate : public std::false_type
+{};
+
+template <class Wrapper>
+struct HasPreconditionerInvalidate<Wrapper, std::void_t<decltype(std::declval<Wrapper&>().invalidate())> >
+    : public std::true_type
+{};
+
+// the black-oil model calls its pressure primary variable 'pressureSwitchIdx', the
+// other models 'pressure0Idx'
+template <class Indices, class Enable = void>
+struct CprPressureIndex
+{ static constexpr int value = Indices::pressure0Idx; };
+
+template <class Indices>
+struct CprPressureIndex<Indices, std::void_t<decltype(Indices::pressureSwitchIdx)> >
+{ static constexpr int value = Indices::pressureSwitchIdx; };
+
+// models which exhibit neither of them (e.g., the Richards model) cannot use CPR
+template <class Indices>
+constexpr auto hasCprPressureIndex_(int) -> decltype(Indices::pressureSwitchIdx, true)
+{ return true; }
+
+template <class Indices>
+constexpr auto hasCprPressureIndex_(long) -> decltype(Indices::pressure0Idx, true)
+{ return true; }
+
+template <class Indices>
+constexpr bool hasCprPressureIndex_(...)
+{ return false; }
+
+template <class Indices>
+struct HasCprPressureIndex
+    : public std::integral_constant<bool, hasCprPressureIndex_<Indices>(0)>
+{};
+
+/*!
+ * \brief A constrained pressure residual (CPR) preconditioner.
+ *
+ * The pressure system is decoupled using quasi-IMPES weights and solved by an AMG, the
+ * remaining error is treated by ILU(0). The AMG uses the same parameters and, if MPI is
+ * available, the same communication as the one of the ParallelAmgBackend, i.e., the
+ * pressure system is solved globally while ILU(0) is applied to the local matrix of
+ * each process.
+ */
+template <class TypeTag>
+class PreconditionerWrapperCPR
+{
+    using Scalar = GetPropType<TypeTag, Properties::Scalar>;
+    using GridView = GetPropType<TypeTag, Properties::GridView>;
+    using Indices = GetPropType<TypeTag, Properties::Indices>;
+    using OverlappingMatrix = GetPropType<TypeTag, Properties::OverlappingMatrix>;
+    using OverlappingVector = GetPropType<TypeTag, Properties::OverlappingVector>;
+
+#if HAVE_MPI
+    using Communication = Dune::OwnerOverlapCopyCommunication<Opm::Linear::Index>;
+#else
+    using Communication = Dune::Amg::SequentialInformation;
+#endif
+
+public:
+    using SequentialPreconditioner = CprPreconditioner<OverlappingMatrix, OverlappingVector, Communication>;
+
+    PreconditionerWrapperCPR()
+    {}
+
+    static void registerParameters()
+    {
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, PreconditionerRelaxation,
+                             "The relaxation factor of the preconditioner");
+        EWOMS_REGISTER_PARAM(TypeTag, int, AmgCoarsenTarget,
+                             "The coarsening target for the agglomerations of "
+                             "the AMG preconditioner");
+        EWOMS_REGISTER_PARAM(TypeTag, int, AmgHierarchyRefreshInterval,
+                             "The number of linear solves after which the aggregates of "
+                             "the AMG preconditioner are recomputed");
+    }
+
+    void prepare(OverlappingMatrix& matrix)
+    {
+        // the parallel index set of the AMG only depends on the overlap. it is kept
+        // until the overlapping matrix is recreated, which invalidates the wrapper.
+        if (!seqPreCond_) {
+#if HAVE_MPI
+            comm_ = std::make_unique<Communication>(MPI_COMM_WORLD);
+            setupAmgIndexSet(matrix.overlap(), comm_->indexSet());
+            comm_->remoteIndices().template rebuild<false>();
+            const Communication* comm = comm_.get();
+#else
+            const Communication* comm = nullptr;
+#endif
+
+            seqPreCond_ = std::make_unique<SequentialPreconditioner>(
+                CprPressureIndex<Indices>::value,
+                EWOMS_GET_PARAM(TypeTag, int, AmgCoarsenTarget),
+                GridView::dimension,
+                EWOMS_GET_PARAM(TypeTag, int, AmgHierarchyRefreshInterval),
+                EWOMS_GET_PARAM(TypeTag, Scalar, PreconditionerRelaxation),
+                comm);
+        }
+
+        seqPreCond_->updateMatrix(matrix);
+    }
+
+    SequentialPreconditioner& get()
+    { return *seqPreCond_; }
+
+    void cleanup()
+    {
+        // keep the pressure matrix and the AMG hierarchy for the next linear solve
+    }
+
+    void invalidate()
+    {
+        seqPreCond_.reset();
+#if HAVE_MPI
+        comm_.reset();
+#endif
+    }
+
+private:
+#if HAVE_MPI
+    std::unique_ptr<Communication> comm_;
+#endif
+    std::unique_ptr<SequentialPreconditioner> seqPreCond_;
+};
+
+/*!
+ * \brief Selects the preconditioner at run time.
+ *
+ * The preconditioner is specified by the "PreconditionerType" parameter. Possible values
+ * are 'ilu0', 'reordered-ilu0', 'multicolor' and 'cpr'. The latter is only available if
+ * the model exhibits a pressure primary variable. Since the linear solver only sees the
+ * interface of dune-istl's preconditioners, each application of the preconditioner
+ * requires an additional virtual function call compared to the wrapper of the selected
+ * preconditioner.
+ */
+template <class TypeTag>
+class PreconditionerWrapperRuntime
+{
+    using Scalar = GetPropType<TypeTag, Properties::Scalar>;
+    using Indices = GetPropType<TypeTag, Properties::Indices>;
+    using OverlappingMatrix = GetPropType<TypeTag, Properties::OverlappingMatrix>;
+    using OverlappingVector = GetPropType<TypeTag, Properties::OverlappingVector>;
+
+    static constexpr bool cprAvailable = HasCprPressureIndex<Indices>::value;
+
+    enum class Type {
+        ILU0,
+        ReorderedILU0,
+        MultiColor,
+        CPR
+    };
+
+public:
+    using SequentialPreconditioner = Dune::Preconditioner<OverlappingVector, OverlappingVector>;
+
+    PreconditionerWrapperRuntime()
+    {}
+
+    static void registerParameters()
+    {
+        // the parameters of all preconditioners which can be selected. they cannot be
+        // registered by the individual wrappers because this would register some of
+        // them multiple times.
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, PreconditionerType,
+                             "The preconditioner used by the linear solver. "
+                             "Possible values: 'ilu0', 'reordered-ilu0', 'multicolor' and 'cpr'");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, PreconditionerRelaxation,
+                             "The relaxation factor of the preconditioner");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, PreconditionerMultiColorMethod,
+                             "The method used by the multi-color preconditioner. "
+                             "Possible values: 'ilu0', 'jacobi' and 'gauss-seidel'");
+        EWOMS_REGISTER_PARAM(TypeTag, int, AmgCoarsenTarget,
+                             "The coarsening target for the agglomerations of "
+                             "the AMG preconditioner");
+        EWOMS_REGISTER_PARAM(TypeTag, int, AmgHierarchyRefreshInterval,
+                             "The number of linear solves after which the aggregates of "
+                             "the AMG preconditioner are recomputed");
+    }
+
+    void prepare(OverlappingMatrix& matrix)
+    {
+        if (!typeSelected_) {
+            type_ = selectedType_();
+            typeSelected_ = true;
+        }
+
+        switch (type_) {
+        case Type::ILU0:
+            iluWrapper_.prepare(matrix);
+            break;
+        case Type::ReorderedILU0:
+            reorderedIluWrapper_.prepare(matrix);
+            break;
+        case Type::MultiColor:
+            multiColorWrapper_.prepare(matrix);
+            break;
+        case Type::CPR:
+            if constexpr (cprAvailable)
+                cprWrapper_.prepare(matrix);
+            break;
+        }
+    }
+
+    SequentialPreconditioner& get()
+    {
+        switch (type_) {
+        case Type::ReorderedILU0:
+            return reorderedIluWrapper_.get();
+        case Type::MultiColor:
+            return multiColorWrapper_.get();
+        case Type::CPR:
+            if constexpr (cprAvailable)
+                return cprWrapper_.get();
+            break;
+        case Type::ILU0:
+            break;
+        }
+
+        return iluWrapper_.get();
+    }
+
+    void cleanup()
+    {
+        switch (type_) {
+        case Type::ILU0:
+            iluWrapper_.cleanup();
+            break;
+        case Type::ReorderedILU0:
+            reorderedIluWrapper_.cleanup();
+            break;
+        case Type::MultiColor:
+            multiColorWrapper_.cleanup();
+            break;
+        case Type::CPR:
+            if constexpr (cprAvailable)
+                cprWrapper_.cleanup();
+            break;
+        }
+    }
+
+    void invalidate()
+    {
+        reorderedIluWrapper_.invalidate();
+        multiColorWrapper_.invalidate();
+        if constexpr (cprAvailable)
+            cprWrapper_.invalidate();
+    }
+
+private:
+    static Type selectedType_()
+    {
+        const std::string type = EWOMS_GET_PARAM(TypeTag, std::string, PreconditionerType);
+        if (type == "ilu0")
+            return Type::ILU0;
+        else if (type == "reordered-ilu0")
+            return Type::ReorderedILU0;
+        else if (type == "multicolor")
+            return Type::MultiColor;
+        else if (type == "cpr") {
+            if (!cprAvailable)
+                throw std::invalid_argument("The CPR preconditioner requires a model which "
+                                            "exhibits a pressure primary variable");
+            return Type::CPR;
+        }
+
+        throw std::invalid_argument("Unknown preconditioner '"+type+"'. Valid values are "
+                                    "'ilu0', 'reordered-ilu0', 'multicolor' and 'cpr'");
+    }
+
+    Type type_ = Type::ILU0;
+    bool typeSelected_ = false;
+
+    PreconditionerWrapperILU<TypeTag> iluWrapper_;
+    PreconditionerWrapperReorderedILU<TypeTag> reorderedIluWrapper_;
+    PreconditionerWrapperMultiColor<TypeTag> multiColorWrapper_;
+    PreconditionerWrapperCPR<TypeTag> cprWrapper_;
+};
+
 #undef EWOMS_WRAP_ISTL_PRECONDITIONER
 }} // namespace Linear, Opm
 
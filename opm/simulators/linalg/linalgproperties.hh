@@ -56,6 +56,15 @@ struct LinearSolverScalar { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct LinearSolverOverlapSize { using type = UndefinedProperty; };
 
+/*!
+ * \brief Specifies whether the entries of overlapping vectors are exchanged with the
+ *        peer processes using MPI-3 neighborhood collectives.
+ *
+ * If false, non-blocking point-to-point communication is used.
+ */
+template<class TypeTag, class MyTypeTag>
+struct LinearSolverUseNeighborCollectives { using type = UndefinedProperty; };
+
 /*!
  * \brief Maximum accepted error of the solution of the linear solver.
  */
@@ -90,6 +99,34 @@ struct PreconditionerOrder { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct PreconditionerRelaxation { using type = UndefinedProperty; };
 
+/*!
+ * \brief The preconditioner which is used if it is selected at run time.
+ *
+ * Possible values are "ilu0", "reordered-ilu0", "multicolor" and "cpr". This is only
+ * considered if the PreconditionerWrapper property is set to
+ * Opm::Linear::PreconditionerWrapperRuntime.
+ */
+template<class TypeTag, class MyTypeTag>
+struct PreconditionerType { using type = UndefinedProperty; };
+
+/*!
+ * \brief The method used by the multi-color preconditioner.
+ *
+ * Possible values are "ilu0", "jacobi" and "gauss-seidel".
+ */
+template<class TypeTag, class MyTypeTag>
+struct PreconditionerMultiColorMethod { using type = UndefinedProperty; };
+
+/*!
+ * \brief Specifies whether all processes agree on the success of the preconditioner
+ *        after each of its applications.
+ *
+ * If false, a failure of the sequential preconditioner is propagated by NaNs which
+ * saves a global reduction per application.
+ */
+template<class TypeTag, class MyTypeTag>
+struct PreconditionerCollectiveErrorCheck { using type = UndefinedProperty; };
+
 //! number of iterations between solver restarts for the GMRES solver
 template<class TypeTag, class MyTypeTag>
 struct GMResRestart { using type = UndefinedProperty; };
@@ -104,6 +141,21 @@ struct GlobalEqVector { using type = UndefinedProperty; };
 
 template<class TypeTag, class MyTypeTag>
 struct AmgCoarsenTarget { using type = UndefinedProperty; };
+/*!
+ * \brief The number of linear solves after which the aggregates of the AMG are
+ *        recomputed.
+ *
+ * In between, only the Galerkin products of the coarse levels are recomputed for the new
+ * values of the matrix.
+ */
+template<class TypeTag, class MyTypeTag>
+struct AmgHierarchyRefreshInterval { using type = UndefinedProperty; };
+/*!
+ * \brief Use the multi-color Gauss-Seidel method, which uses all threads of the process,
+ *        as the smoother of the AMG instead of the sequential SOR method.
+ */
+template<class TypeTag, class MyTypeTag>
+struct EnableThreadedAmgSmoother { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct LinearSolverMaxError { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
@@ -0,0 +1,126 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Opm::Linear::MultiColorAmgSmoother
+ */
+#ifndef EWOMS_MULTI_COLOR_AMG_SMOOTHER_HH
+#define EWOMS_MULTI_COLOR_AMG_SMOOTHER_HH
+
+#include "multicolorpreconditioner.hh"
+
+#include <dune/istl/paamg/construction.hh>
+#include <dune/istl/paamg/smoother.hh>
+#include <dune/istl/preconditioner.hh>
+#include <dune/istl/solvercategory.hh>
+
+#include <memory>
+
+namespace Opm {
+namespace Linear {
+
+/*!
+ * \brief A smoother for the AMG of dune-istl which uses all threads of the process.
+ *
+ * Each application is a sweep of the multi-color Gauss-Seidel method. The smoother
+ * references the matrix of its level of the AMG hierarchy and copies its entries at the
+ * first application after pre() was called. This way, it also picks up the values of the
+ * coarse level matrices which are recomputed by Dune::Amg::AMG::recalculateHierarchy().
+ */
+template <class Matrix, class Vector>
+class MultiColorAmgSmoother : public Dune::Preconditioner<Vector, Vector>
+{
+    using Preconditioner = MultiColorPreconditioner<Matrix, Vector>;
+
+public:
+    using matrix_type = Matrix;
+    using domain_type = Vector;
+    using range_type = Vector;
+    using field_type = typename Vector::field_type;
+
+    MultiColorAmgSmoother(const Matrix& matrix, int iterations, field_type relaxationFactor)
+        : matrix_(matrix)
+        , preCond_(Preconditioner::Method::GaussSeidel, relaxationFactor)
+        , iterations_(iterations)
+    {}
+
+    void pre(domain_type&, range_type&) override
+    { matrixChanged_ = true; }
+
+    void apply(domain_type& v, const range_type& d) override
+    {
+        if (matrixChanged_) {
+            preCond_.updateMatrix(matrix_);
+            matrixChanged_ = false;
+        }
+
+        preCond_.apply(v, d);
+        if (iterations_ < 2)
+            return;
+
+        // the multi-color preconditioner starts its sweep at zero, so further sweeps
+        // are applied to the remaining defect
+        range_type defect(d);
+        domain_type update(v.size());
+        for (int i = 1; i < iterations_; ++i) {
+            defect = d;
+            matrix_.mmv(v, defect);
+            preCond_.apply(update, defect);
+            v += update;
+        }
+    }
+
+    void post(domain_type&) override
+    {}
+
+    Dune::SolverCategory::Category category() const override
+    { return Dune::SolverCategory::sequential; }
+
+private:
+    const Matrix& matrix_;
+    Preconditioner preCond_;
+    int iterations_;
+    bool matrixChanged_ = true;
+};
+
+}} // namespace Linear, Opm
+
+namespace Dune::Amg {
+
+template <class Matrix, class Vector>
+struct ConstructionTraits<Opm::Linear::MultiColorAmgSmoother<Matrix, Vector> >
+{
+    using Smoother = Opm::Linear::MultiColorAmgSmoother<Matrix, Vector>;
+    using Arguments = DefaultConstructionArgs<Smoother>;
+
+    static std::shared_ptr<Smoother> construct(Arguments& args)
+    {
+        return std::make_shared<Smoother>(args.getMatrix(),
+                                          args.getArgs().iterations,
+                                          args.getArgs().relaxationFactor);
+    }
+};
+
+} // namespace Dune::Amg
+
+#endif
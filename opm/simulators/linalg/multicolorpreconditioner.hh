@@ -0,0 +1,465 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Opm::Linear::MultiColorPreconditioner
+ */
+#ifndef EWOMS_MULTI_COLOR_PRECONDITIONER_HH
+#define EWOMS_MULTI_COLOR_PRECONDITIONER_HH
+
+#include <dune/istl/preconditioner.hh>
+#include <dune/istl/solvercategory.hh>
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace Opm {
+namespace Linear {
+
+/*!
+ * \brief Compute a greedy coloring of the rows of a sparse matrix.
+ *
+ * Rows of the same color are not coupled with each other, so they can be processed
+ * concurrently by Gauss-Seidel sweeps and triangular solves. The sparsity pattern is
+ * assumed to be structurally symmetric.
+ *
+ * \return The color of each row. Colors are numbered consecutively starting at zero.
+ */
+template <class Matrix>
+std::vector<unsigned> greedyMultiColoring(const Matrix& matrix)
+{
+    static constexpr unsigned unColored = ~0u;
+
+    const std::size_t numRows = matrix.N();
+    std::vector<unsigned> rowColor(numRows, unColored);
+
+    // the last row for which a color was found to be taken by a neighbor
+    std::vector<std::size_t> colorTakenBy;
+    for (std::size_t rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+        const auto& row = matrix[rowIdx];
+        for (auto colIt = row.begin(); colIt != row.end(); ++colIt) {
+            const std::size_t colIdx = colIt.index();
+            if (colIdx < numRows && rowColor[colIdx] != unColored)
+                colorTakenBy[rowColor[colIdx]] = rowIdx;
+        }
+
+        unsigned color = 0;
+        while (color < colorTakenBy.size() && colorTakenBy[color] == rowIdx)
+            ++color;
+        if (color == colorTakenBy.size())
+            colorTakenBy.push_back(numRows);
+
+        rowColor[rowIdx] = color;
+    }
+
+    return rowColor;
+}
+
+/*!
+ * \brief A preconditioner which uses all threads of the process by operating on the
+ *        rows of the linear system of equations color by color.
+ *
+ * The available methods are a block-Jacobi step, a block-Gauss-Seidel sweep and
+ * block-ILU(0). The coloring is computed from the sparsity pattern of the matrix and is
+ * kept if the values of the matrix are updated via updateMatrix(). Since Gauss-Seidel
+ * and ILU(0) process the rows in the order of their colors instead of the one given by
+ * the grid, their results are different from the ones of Dune::SeqGS and Dune::SeqILU,
+ * but they do not depend on the number of threads.
+ */
+template <class Matrix, class Vector>
+class MultiColorPreconditioner : public Dune::Preconditioner<Vector, Vector>
+{
+    using MatrixBlock = typename Matrix::block_type;
+    using VectorBlock = typename Vector::block_type;
+
+public:
+    using matrix_type = Matrix;
+    using domain_type = Vector;
+    using range_type = Vector;
+    using field_type = typename Vector::field_type;
+
+    enum class Method {
+        Jacobi,
+        GaussSeidel,
+        ILU0
+    };
+
+    MultiColorPreconditioner(Method method, field_type relaxationFactor)
+        : method_(method)
+        , relaxationFactor_(relaxationFactor)
+    {}
+
+    /*!
+     * \brief Returns the number of rows of the matrices which can be handled.
+     */
+    std::size_t size() const
+    { return rowColor_.size(); }
+
+    /*!
+     * \brief Returns the number of colors used for the rows of the matrix.
+     */
+    std::size_t numColors() const
+    { return colorStart_.empty() ? 0 : colorStart_.size() - 1; }
+
+    /*!
+     * \brief Set the relaxation factor which is applied to the result.
+     */
+    void setRelaxationFactor(field_type relaxationFactor)
+    { relaxationFactor_ = relaxationFactor; }
+
+    /*!
+     * \brief Copy the entries of a matrix and compute the data required by the
+     *        preconditioner.
+     *
+     * The coloring and the sparsity pattern are only recomputed if the sparsity pattern
+     * of the matrix changes. The column indices are compared while the entries are
+     * copied, so this does not require an additional pass over the matrix.
+     */
+    void updateMatrix(const Matrix& matrix)
+    {
+        if (!copyValues_(matrix)) {
+            updatePattern_(matrix);
+            copyValues_(matrix);
+        }
+
+        if (method_ == Method::ILU0)
+            factorize_();
+        else
+            invertDiagonal_();
+    }
+
+    void pre(domain_type&, range_type&) override
+    {}
+
+    void apply(domain_type& v, const range_type& d) override
+    {
+        switch (method_) {
+        case Method::Jacobi:
+            applyJacobi_(v, d);
+            break;
+        case Method::GaussSeidel:
+            applyGaussSeidel_(v, d);
+            break;
+        case Method::ILU0:
+            applyILU0_(v, d);
+            break;
+        }
+    }
+
+    void post(domain_type&) override
+    {}
+
+    Dune::SolverCategory::Category category() const override
+    { return Dune::SolverCategory::sequential; }
+
+private:
+    // copy the entries of the matrix. returns false if the sparsity pattern of the matrix
+    // is different from the one which was used to compute the coloring.
+    bool copyValues_(const Matrix& matrix)
+    {
+        if (rowColor_.size() != matrix.N() || cols_.size() != matrix.nonzeroes())
+            return false;
+
+        bool patternMatches = true;
+        const long numRows = static_cast<long>(rowColor_.size());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) reduction(&&:patternMatches)
+#endif
+        for (long rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+            const std::size_t i = static_cast<std::size_t>(rowIdx);
+            const auto& row = matrix[i];
+            if (row.size() != rowStart_[i + 1] - rowStart_[i]) {
+                patternMatches = false;
+                continue;
+            }
+
+            std::size_t pos = rowStart_[i];
+            for (auto colIt = row.begin(); colIt != row.end(); ++colIt, ++pos) {
+                patternMatches = patternMatches && (colIt.index() == cols_[pos]);
+                values_[pos] = *colIt;
+            }
+        }
+
+        return patternMatches;
+    }
+
+    void updatePattern_(const Matrix& matrix)
+    {
+        const std::size_t numRows = matrix.N();
+        rowColor_ = greedyMultiColoring(matrix);
+
+        // group the rows by their colors
+        std::size_t numColors = 0;
+        for (unsigned color : rowColor_)
+            numColors = std::max<std::size_t>(numColors, color + 1);
+        colorStart_.assign(numColors + 1, 0);
+        for (unsigned color : rowColor_)
+            ++colorStart_[color + 1];
+        for (std::size_t color = 0; color < numColors; ++color)
+            colorStart_[color + 1] += colorStart_[color];
+        rowsByColor_.resize(numRows);
+        std::vector<std::size_t> fillPos(colorStart_.begin(), colorStart_.end() - 1);
+        for (std::size_t rowIdx = 0; rowIdx < numRows; ++rowIdx)
+            rowsByColor_[fillPos[rowColor_[rowIdx]]++] = rowIdx;
+
+        // compressed row storage of the pattern. the entries of the lower and upper
+        // triangle w.r.t. the order of the colors are stored separately. the ones of
+        // the lower triangle are sorted by color because ILU(0) must eliminate them in
+        // that order.
+        rowStart_.resize(numRows + 1);
+        cols_.clear();
+        cols_.reserve(matrix.nonzeroes());
+        diagPos_.resize(numRows);
+        lowerStart_.resize(numRows + 1);
+        lowerPos_.clear();
+        upperStart_.resize(numRows + 1);
+        upperPos_.clear();
+        rowStart_[0] = lowerStart_[0] = upperStart_[0] = 0;
+        for (std::size_t rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+            const auto& row = matrix[rowIdx];
+            const unsigned rowColor = rowColor_[rowIdx];
+            bool hasDiagonal = false;
+            for (auto colIt = row.begin(); colIt != row.end(); ++colIt) {
+                const std::size_t colIdx = colIt.index();
+                const std::size_t pos = cols_.size();
+                cols_.push_back(colIdx);
+
+                if (colIdx == rowIdx) {
+                    diagPos_[rowIdx] = pos;
+                    hasDiagonal = true;
+                }
+                else if (rowColor_[colIdx] < rowColor)
+                    lowerPos_.push_back(pos);
+                else
+                    upperPos_.push_back(pos);
+            }
+
+            if (!hasDiagonal)
+                throw std::logic_error("The multi-color preconditioner requires all diagonal "
+                                       "entries of the matrix to be present");
+
+            std::stable_sort(lowerPos_.begin() + static_cast<long>(lowerStart_[rowIdx]),
+                             lowerPos_.end(),
+                             [this](std::size_t a, std::size_t b)
+                             { return rowColor_[cols_[a]] < rowColor_[cols_[b]]; });
+
+            rowStart_[rowIdx + 1] = cols_.size();
+            lowerStart_[rowIdx + 1] = lowerPos_.size();
+            upperStart_[rowIdx + 1] = upperPos_.size();
+        }
+
+        values_.resize(cols_.size());
+        invDiag_.resize(numRows);
+    }
+
+    void invertDiagonal_()
+    {
+        const long numRows = static_cast<long>(rowColor_.size());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (long rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+            invDiag_[static_cast<std::size_t>(rowIdx)] = values_[diagPos_[static_cast<std::size_t>(rowIdx)]];
+            invDiag_[static_cast<std::size_t>(rowIdx)].invert();
+        }
+    }
+
+    // returns the position of an entry in the compressed row storage or -1 if the entry
+    // is not part of the sparsity pattern
+    long findEntry_(std::size_t rowIdx, std::size_t colIdx) const
+    {
+        const auto rowBegin = cols_.begin() + static_cast<long>(rowStart_[rowIdx]);
+        const auto rowEnd = cols_.begin() + static_cast<long>(rowStart_[rowIdx + 1]);
+        const auto it = std::lower_bound(rowBegin, rowEnd, colIdx);
+        if (it == rowEnd || *it != colIdx)
+            return -1;
+        return it - cols_.begin();
+    }
+
+    // block-ILU(0) in the ordering of the colors. all rows of a color only depend on the
+    // rows of the previous colors, so they can be factorized concurrently.
+    void factorize_()
+    {
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            MatrixBlock tmp;
+            for (std::size_t color = 0; color < numColors(); ++color) {
+                const long colorBegin = static_cast<long>(colorStart_[color]);
+                const long colorEnd = static_cast<long>(colorStart_[color + 1]);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+                for (long i = colorBegin; i < colorEnd; ++i) {
+                    const std::size_t rowIdx = rowsByColor_[static_cast<std::size_t>(i)];
+                    for (std::size_t l = lowerStart_[rowIdx]; l < lowerStart_[rowIdx + 1]; ++l) {
+                        const std::size_t lowerPos = lowerPos_[l];
+                        const std::size_t k = cols_[lowerPos];
+
+                        // L_ik = A_ik * U_kk^-1
+                        values_[lowerPos].rightmultiply(invDiag_[k]);
+
+                        // A_ij -= L_ik * U_kj for all entries (i, j) of the pattern
+                        for (std::size_t u = upperStart_[k]; u < upperStart_[k + 1]; ++u) {
+                            const std::size_t upperPos = upperPos_[u];
+                            const long pos = findEntry_(rowIdx, cols_[upperPos]);
+                            if (pos < 0)
+                                continue;
+
+                            tmp = values_[lowerPos];
+                            tmp.rightmultiply(values_[upperPos]);
+                            values_[static_cast<std::size_t>(pos)] -= tmp;
+                        }
+                    }
+
+                    invDiag_[rowIdx] = values_[diagPos_[rowIdx]];
+                    invDiag_[rowIdx].invert();
+                }
+            }
+        }
+    }
+
+    void applyJacobi_(domain_type& v, const range_type& d) const
+    {
+        const long numRows = static_cast<long>(rowColor_.size());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (long rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+            const std::size_t i = static_cast<std::size_t>(rowIdx);
+            invDiag_[i].mv(d[i], v[i]);
+            v[i] *= relaxationFactor_;
+        }
+    }
+
+    // a forward sweep starting at zero. since the rows of the later colors are still
+    // zero, only the lower triangle needs to be considered.
+    void applyGaussSeidel_(domain_type& v, const range_type& d) const
+    {
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            VectorBlock tmp;
+            for (std::size_t color = 0; color < numColors(); ++color) {
+                const long colorBegin = static_cast<long>(colorStart_[color]);
+                const long colorEnd = static_cast<long>(colorStart_[color + 1]);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+                for (long i = colorBegin; i < colorEnd; ++i) {
+                    const std::size_t rowIdx = rowsByColor_[static_cast<std::size_t>(i)];
+                    tmp = d[rowIdx];
+                    for (std::size_t l = lowerStart_[rowIdx]; l < lowerStart_[rowIdx + 1]; ++l) {
+                        const std::size_t lowerPos = lowerPos_[l];
+                        values_[lowerPos].mmv(v[cols_[lowerPos]], tmp);
+                    }
+                    invDiag_[rowIdx].mv(tmp, v[rowIdx]);
+                    v[rowIdx] *= relaxationFactor_;
+                }
+            }
+        }
+    }
+
+    void applyILU0_(domain_type& v, const range_type& d) const
+    {
+        const long numRows = static_cast<long>(rowColor_.size());
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+            for (long rowIdx = 0; rowIdx < numRows; ++rowIdx)
+                v[static_cast<std::size_t>(rowIdx)] = d[static_cast<std::size_t>(rowIdx)];
+
+            // forward substitution: v = L^-1 d
+            for (std::size_t color = 0; color < numColors(); ++color) {
+                const long colorBegin = static_cast<long>(colorStart_[color]);
+                const long colorEnd = static_cast<long>(colorStart_[color + 1]);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+                for (long i = colorBegin; i < colorEnd; ++i) {
+                    const std::size_t rowIdx = rowsByColor_[static_cast<std::size_t>(i)];
+                    for (std::size_t l = lowerStart_[rowIdx]; l < lowerStart_[rowIdx + 1]; ++l) {
+                        const std::size_t lowerPos = lowerPos_[l];
+                        values_[lowerPos].mmv(v[cols_[lowerPos]], v[rowIdx]);
+                    }
+                }
+            }
+
+            // backward substitution: v = U^-1 v
+            VectorBlock tmp;
+            for (std::size_t color = numColors(); color > 0; --color) {
+                const long colorBegin = static_cast<long>(colorStart_[color - 1]);
+                const long colorEnd = static_cast<long>(colorStart_[color]);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+                for (long i = colorBegin; i < colorEnd; ++i) {
+                    const std::size_t rowIdx = rowsByColor_[static_cast<std::size_t>(i)];
+                    tmp = v[rowIdx];
+                    for (std::size_t u = upperStart_[rowIdx]; u < upperStart_[rowIdx + 1]; ++u) {
+                        const std::size_t upperPos = upperPos_[u];
+                        values_[upperPos].mmv(v[cols_[upperPos]], tmp);
+                    }
+                    invDiag_[rowIdx].mv(tmp, v[rowIdx]);
+                }
+            }
+
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+            for (long rowIdx = 0; rowIdx < numRows; ++rowIdx)
+                v[static_cast<std::size_t>(rowIdx)] *= relaxationFactor_;
+        }
+    }
+
+    Method method_;
+    field_type relaxationFactor_;
+
+    std::vector<unsigned> rowColor_;
+    std::vector<std::size_t> colorStart_;
+    std::vector<std::size_t> rowsByColor_;
+
+    std::vector<std::size_t> rowStart_;
+    std::vector<std::size_t> cols_;
+    std::vector<std::size_t> diagPos_;
+    std::vector<std::size_t> lowerStart_;
+    std::vector<std::size_t> lowerPos_;
+    std::vector<std::size_t> upperStart_;
+    std::vector<std::size_t> upperPos_;
+
+    std::vector<MatrixBlock> values_;
+    std::vector<MatrixBlock> invDiag_;
+};
+
+}} // namespace Linear, Opm
+
+#endif
@@ -263,65 +263,65 @@ public:
     // communicates and adds up the contents of overlapping rows
     void syncAdd()
     {
-        // first, send all entries to the peers
+        // first, exchange the entries with all peers
+        exchangeEntries_();
+
+        // then, add the entries received from the peers
         const PeerSet& peerSet = overlap_->peerSet();
         typename PeerSet::const_iterator peerIt = peerSet.begin();
         typename PeerSet::const_iterator peerEndIt = peerSet.end();
         for (; peerIt != peerEndIt; ++peerIt) {
             ProcessRank peerRank = *peerIt;
 
-            sendEntries_(peerRank);
-        }
-
-        // then, receive entries from the peers
-        peerIt = peerSet.begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank peerRank = *peerIt;
-
             receiveAddEntries_(peerRank);
         }
 
         // finally, make sure that everything which we send was
         // received by the peers
-        peerIt = peerSet.begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank peerRank = *peerIt;
-            entryValuesSendBuff_[peerRank]->wait();
-        }
+        MpiBuffer<block_type>::waitAll(valuesSendBuffs_.begin(), valuesSendBuffs_.end(), requests_);
     }
 
     // communicates and copies the contents of overlapping rows from
     // the master
     void syncCopy()
     {
-        // first, send all entries to the peers
+        // first, exchange the entries with all peers
+        exchangeEntries_();
+
+        // then, copy the entries received from the peers
         const PeerSet& peerSet = overlap_->peerSet();
         typename PeerSet::const_iterator peerIt = peerSet.begin();
         typename PeerSet::const_iterator peerEndIt = peerSet.end();
         for (; peerIt != peerEndIt; ++peerIt) {
             ProcessRank peerRank = *peerIt;
 
-            sendEntries_(peerRank);
-        }
-
-        // then, receive entries from the peers
-        peerIt = peerSet.begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank peerRank = *peerIt;
-
             receiveCopyEntries_(peerRank);
         }
 
         // finally, make sure that everything which we send was
         // received by the peers
-        peerIt = peerSet.begin();
+        MpiBuffer<block_type>::waitAll(valuesSendBuffs_.begin(), valuesSendBuffs_.end(), requests_);
+    }
+
+private:
+    // post the receives for the entries of all peers, send our entries to them and
+    // wait until all entries of the peers have arrived
+    void exchangeEntries_()
+    {
+        MpiBuffer<block_type>::startAll(valuesRecvBuffs_.begin(), valuesRecvBuffs_.end());
+
+        const PeerSet& peerSet = overlap_->peerSet();
+        typename PeerSet::const_iterator peerIt = peerSet.begin();
+        typename PeerSet::const_iterator peerEndIt = peerSet.end();
         for (; peerIt != peerEndIt; ++peerIt) {
             ProcessRank peerRank = *peerIt;
-            entryValuesSendBuff_[peerRank]->wait();
+
+            sendEntries_(peerRank);
         }
+
+        MpiBuffer<block_type>::waitAll(valuesRecvBuffs_.begin(), valuesRecvBuffs_.end(), requests_);
     }
 
-private:
     template <class NativeBCRSMatrix>
     void build_(const NativeBCRSMatrix& nativeMatrix)
     {
@@ -402,6 +402,20 @@ private:
             globalToDomesticBuff_(*entryColIndicesSendBuff_[peerRank]);
         }
 
+#if HAVE_MPI
+        // the values of the matrix entries are exchanged with the same peers each time
+        // the matrix is synchronized, so bind the value buffers to persistent requests
+        peerIt = peerSet.begin();
+        for (; peerIt != peerEndIt; ++peerIt) {
+            ProcessRank peerRank = *peerIt;
+
+            entryValuesSendBuff_[peerRank]->initPersistentSend(peerRank);
+            entryValuesRecvBuff_[peerRank]->initPersistentReceive(peerRank);
+            valuesSendBuffs_.push_back(entryValuesSendBuff_[peerRank]);
+            valuesRecvBuffs_.push_back(entryValuesRecvBuff_[peerRank]);
+        }
+#endif // HAVE_MPI
+
         /////////
         // actually initialize the BCRS matrix structure
         /////////
@@ -603,7 +617,7 @@ private:
             }
         }
 
-        mpiSendBuff.send(peerRank);
+        mpiSendBuff.start();
 #endif // HAVE_MPI
     }
 
@@ -616,8 +630,6 @@ private:
         auto &mpiRowSizesRecvBuff = *rowSizesRecvBuff_[peerRank];
         auto &mpiColIndicesRecvBuff = *entryColIndicesRecvBuff_[peerRank];
 
-        mpiRecvBuff.receive(peerRank);
-
         // retrieve the values from the receive buffer
         unsigned k = 0;
         for (unsigned i = 0; i < mpiRowIndicesRecvBuff.size(); ++i) {
@@ -644,8 +656,6 @@ private:
         MpiBuffer<unsigned> &mpiRowSizesRecvBuff = *rowSizesRecvBuff_[peerRank];
         MpiBuffer<Index> &mpiColIndicesRecvBuff = *entryColIndicesRecvBuff_[peerRank];
 
-        mpiRecvBuff.receive(peerRank);
-
         // retrieve the values from the receive buffer
         unsigned k = 0;
         for (unsigned i = 0; i < mpiRowIndicesRecvBuff.size(); ++i) {
@@ -684,6 +694,12 @@ private:
     std::map<ProcessRank, MpiBuffer<Index> *> rowIndicesRecvBuff_;
     std::map<ProcessRank, MpiBuffer<Index> *> entryColIndicesRecvBuff_;
     std::map<ProcessRank, MpiBuffer<block_type> *> entryValuesRecvBuff_;
+
+    // the buffers for the values of the matrix entries in the order of the peer ranks
+    std::vector<MpiBuffer<block_type> *> valuesSendBuffs_;
+    std::vector<MpiBuffer<block_type> *> valuesRecvBuffs_;
+    // reused by the waits for the buffers
+    typename MpiBuffer<block_type>::RequestStorage requests_;
 };
 
 } // namespace Linear
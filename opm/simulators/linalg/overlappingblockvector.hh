@@ -35,9 +35,10 @@
 #include <dune/istl/bvector.hh>
 #include <dune/common/fvector.hh>
 
-#include <memory>
-#include <map>
 #include <iostream>
+#include <memory>
+#include <tuple>
+#include <vector>
 
 namespace Opm {
 namespace Linear {
@@ -65,11 +66,12 @@ public:
      */
     OverlappingBlockVector(const OverlappingBlockVector& obv)
         : ParentType(obv)
-        , numIndicesSendBuff_(obv.numIndicesSendBuff_)
+        , peerRanks_(obv.peerRanks_)
         , indicesSendBuff_(obv.indicesSendBuff_)
         , indicesRecvBuff_(obv.indicesRecvBuff_)
         , valuesSendBuff_(obv.valuesSendBuff_)
         , valuesRecvBuff_(obv.valuesRecvBuff_)
+        , neighborExchange_(obv.neighborExchange_)
         , overlap_(obv.overlap_)
     {}
 
@@ -92,15 +94,46 @@ public:
     OverlappingBlockVector& operator=(const OverlappingBlockVector& obv)
     {
         ParentType::operator=(obv);
-        numIndicesSendBuff_ = obv.numIndicesSendBuff_;
+        peerRanks_ = obv.peerRanks_;
         indicesSendBuff_ = obv.indicesSendBuff_;
         indicesRecvBuff_ = obv.indicesRecvBuff_;
         valuesSendBuff_ = obv.valuesSendBuff_;
         valuesRecvBuff_ = obv.valuesRecvBuff_;
+        neighborExchange_ = obv.neighborExchange_;
         overlap_ = obv.overlap_;
         return *this;
     }
 
+    /*!
+     * \brief Specify whether the entries of the peer processes are exchanged using MPI-3
+     *        neighborhood collectives.
+     *
+     * If enabled, a distributed graph communicator which connects the process with its
+     * peers is created and all entries are exchanged by a single
+     * MPI_Neighbor_alltoallv() call. This lets the MPI library schedule the messages.
+     * Otherwise, a persistent point-to-point request per peer is used. The setting is
+     * inherited by all copies of the vector which are created afterwards.
+     */
+    void setUseNeighborCollectives(bool yesno)
+    {
+        if (!yesno) {
+            neighborExchange_.reset();
+            return;
+        }
+
+#if HAVE_MPI && MPI_VERSION >= 3
+        if (!neighborExchange_)
+            createNeighborExchange_();
+#endif
+    }
+
+    /*!
+     * \brief Returns true iff the entries of the peer processes are exchanged using
+     *        neighborhood collectives.
+     */
+    bool useNeighborCollectives() const
+    { return neighborExchange_ != nullptr; }
+
     /*!
      * \brief Assign an overlapping block vector from a
      *        non-overlapping one, border entries are added.
@@ -174,13 +207,13 @@ public:
      */
     void sync()
     {
-        // send all entries to all peers
-        for (const auto peerRank: overlap_->peerSet())
-            sendEntries_(peerRank);
+        exchangeEntries_();
 
-        // recieve all entries to the peers
-        for (const auto peerRank: overlap_->peerSet())
-            receiveFromMaster_(peerRank);
+        // copy the values of the peers for which they are master into the block vector
+        for (size_t peerIdx = 0; peerIdx < peerRanks_.size(); ++peerIdx) {
+            const auto& [indices, values, numRows] = receivedEntries_(peerIdx);
+            copyFromMaster_(peerRanks_[peerIdx], indices, values, numRows);
+        }
 
         // wait until we have send everything
         waitSendFinished_();
@@ -192,13 +225,13 @@ public:
      */
     void syncAdd()
     {
-        // send all entries to all peers
-        for (const auto peerRank: overlap_->peerSet())
-            sendEntries_(peerRank);
+        exchangeEntries_();
 
-        // recieve all entries to the peers
-        for (const auto peerRank: overlap_->peerSet())
-            receiveAdd_(peerRank);
+        // add up the values of all peers
+        for (size_t peerIdx = 0; peerIdx < peerRanks_.size(); ++peerIdx) {
+            const auto& [indices, values, numRows] = receivedEntries_(peerIdx);
+            add_(indices, values, numRows);
+        }
 
         // wait until we have send everything
         waitSendFinished_();
@@ -216,39 +249,43 @@ private:
     void createBuffers_()
     {
 #if HAVE_MPI
-        // create array for the front indices
-        typename PeerSet::const_iterator peerIt;
-        typename PeerSet::const_iterator peerEndIt = overlap_->peerSet().end();
+        const PeerSet& peerSet = overlap_->peerSet();
+        peerRanks_.assign(peerSet.begin(), peerSet.end());
+        size_t numPeers = peerRanks_.size();
+
+        std::vector<MpiBuffer<unsigned> > numIndicesSendBuff(numPeers);
+        indicesSendBuff_.resize(numPeers);
+        indicesRecvBuff_.resize(numPeers);
+        valuesSendBuff_.resize(numPeers);
+        valuesRecvBuff_.resize(numPeers);
 
         // send all indices to the peers
-        peerIt = overlap_->peerSet().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank peerRank = *peerIt;
+        for (size_t peerIdx = 0; peerIdx < numPeers; ++peerIdx) {
+            ProcessRank peerRank = peerRanks_[peerIdx];
 
             size_t numEntries = overlap_->foreignOverlapSize(peerRank);
-            numIndicesSendBuff_[peerRank] = std::make_shared<MpiBuffer<unsigned> >(1);
-            indicesSendBuff_[peerRank] = std::make_shared<MpiBuffer<Index> >(numEntries);
-            valuesSendBuff_[peerRank] = std::make_shared<MpiBuffer<FieldVector> >(numEntries);
+            indicesSendBuff_[peerIdx] = std::make_shared<MpiBuffer<Index> >(numEntries);
+            valuesSendBuff_[peerIdx] = std::make_shared<MpiBuffer<FieldVector> >(numEntries);
 
             // fill the indices buffer with global indices
-            MpiBuffer<Index>& indicesSendBuff = *indicesSendBuff_[peerRank];
+            MpiBuffer<Index>& indicesSendBuff = *indicesSendBuff_[peerIdx];
             for (unsigned i = 0; i < numEntries; ++i) {
                 Index domRowIdx = overlap_->foreignOverlapOffsetToDomesticIdx(peerRank, i);
                 indicesSendBuff[i] = overlap_->domesticToGlobal(domRowIdx);
             }
 
             // first, send the number of indices
-            (*numIndicesSendBuff_[peerRank])[0] = static_cast<unsigned>(numEntries);
-            numIndicesSendBuff_[peerRank]->send(peerRank);
+            numIndicesSendBuff[peerIdx].resize(1);
+            numIndicesSendBuff[peerIdx][0] = static_cast<unsigned>(numEntries);
+            numIndicesSendBuff[peerIdx].send(peerRank);
 
             // then, send the indices themselfs
             indicesSendBuff.send(peerRank);
         }
 
         // receive the indices from the peers
-        peerIt = overlap_->peerSet().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank peerRank = *peerIt;
+        for (size_t peerIdx = 0; peerIdx < numPeers; ++peerIdx) {
+            ProcessRank peerRank = peerRanks_[peerIdx];
 
             // receive size of overlap to peer
             MpiBuffer<unsigned> numRowsRecvBuff(1);
@@ -256,11 +293,9 @@ private:
             unsigned numRows = numRowsRecvBuff[0];
 
             // then, create the MPI buffers
-            indicesRecvBuff_[peerRank] = std::shared_ptr<MpiBuffer<Index> >(
-                new MpiBuffer<Index>(numRows));
-            valuesRecvBuff_[peerRank] = std::shared_ptr<MpiBuffer<FieldVector> >(
-                new MpiBuffer<FieldVector>(numRows));
-            MpiBuffer<Index>& indicesRecvBuff = *indicesRecvBuff_[peerRank];
+            indicesRecvBuff_[peerIdx] = std::make_shared<MpiBuffer<Index> >(numRows);
+            valuesRecvBuff_[peerIdx] = std::make_shared<MpiBuffer<FieldVector> >(numRows);
+            MpiBuffer<Index>& indicesRecvBuff = *indicesRecvBuff_[peerIdx];
 
             // next, receive the actual indices
             indicesRecvBuff.receive(peerRank);
@@ -275,56 +310,85 @@ private:
         }
 
         // wait for all send operations to complete
-        peerIt = overlap_->peerSet().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank peerRank = *peerIt;
-            numIndicesSendBuff_[peerRank]->wait();
-            indicesSendBuff_[peerRank]->wait();
+        for (size_t peerIdx = 0; peerIdx < numPeers; ++peerIdx) {
+            numIndicesSendBuff[peerIdx].wait();
+            indicesSendBuff_[peerIdx]->wait();
 
             // convert the global indices of the send buffer to
             // domestic ones
-            MpiBuffer<Index>& indicesSendBuff = *indicesSendBuff_[peerRank];
+            MpiBuffer<Index>& indicesSendBuff = *indicesSendBuff_[peerIdx];
             for (unsigned i = 0; i < indicesSendBuff.size(); ++i) {
                 indicesSendBuff[i] = overlap_->globalToDomestic(indicesSendBuff[i]);
             }
         }
+
+        // the values are exchanged with the same peers each time the vector is
+        // synchronized, so bind the value buffers to persistent requests
+        for (size_t peerIdx = 0; peerIdx < numPeers; ++peerIdx) {
+            valuesSendBuff_[peerIdx]->initPersistentSend(peerRanks_[peerIdx]);
+            valuesRecvBuff_[peerIdx]->initPersistentReceive(peerRanks_[peerIdx]);
+        }
 #endif // HAVE_MPI
     }
 
-    void sendEntries_(ProcessRank peerRank)
+    // start receiving the values of all peers and send our values to them
+    void exchangeEntries_()
     {
-        // copy the values into the send buffer
-        const MpiBuffer<Index>& indices = *indicesSendBuff_[peerRank];
-        MpiBuffer<FieldVector>& values = *valuesSendBuff_[peerRank];
-        for (unsigned i = 0; i < indices.size(); ++i)
-            values[i] = (*this)[static_cast<unsigned>(indices[i])];
+#if HAVE_MPI && MPI_VERSION >= 3
+        if (neighborExchange_) {
+            exchangeNeighborEntries_();
+            return;
+        }
+#endif
+
+        MpiBuffer<FieldVector>::startAll(valuesRecvBuff_.begin(), valuesRecvBuff_.end());
+
+        for (size_t peerIdx = 0; peerIdx < peerRanks_.size(); ++peerIdx) {
+            // copy the values into the send buffer
+            const MpiBuffer<Index>& indices = *indicesSendBuff_[peerIdx];
+            MpiBuffer<FieldVector>& values = *valuesSendBuff_[peerIdx];
+            for (unsigned i = 0; i < indices.size(); ++i)
+                values[i] = (*this)[static_cast<unsigned>(indices[i])];
 
-        values.send(peerRank);
+            values.start();
+        }
+
+        MpiBuffer<FieldVector>::waitAll(valuesRecvBuff_.begin(), valuesRecvBuff_.end(), requests_);
     }
 
     void waitSendFinished_()
     {
-        typename PeerSet::const_iterator peerIt;
-        typename PeerSet::const_iterator peerEndIt = overlap_->peerSet().end();
-
-        // send all entries to all peers
-        peerIt = overlap_->peerSet().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank peerRank = *peerIt;
-            valuesSendBuff_[peerRank]->wait();
-        }
+        // the neighborhood collective is blocking
+        if (neighborExchange_)
+            return;
+
+        MpiBuffer<FieldVector>::waitAll(valuesSendBuff_.begin(), valuesSendBuff_.end(), requests_);
     }
 
-    void receiveFromMaster_(ProcessRank peerRank)
+    // returns the domestic indices, the values and the number of rows received from a
+    // peer by the last exchange
+    std::tuple<const Index*, const FieldVector*, size_t> receivedEntries_(size_t peerIdx) const
     {
-        const MpiBuffer<Index>& indices = *indicesRecvBuff_[peerRank];
-        MpiBuffer<FieldVector>& values = *valuesRecvBuff_[peerRank];
+        if (neighborExchange_) {
+            const auto& ex = *neighborExchange_;
+            size_t offset = ex.recvOffsets[peerIdx];
+            return { ex.recvIndices.data() + offset,
+                     ex.recvValues.data() + offset,
+                     ex.recvOffsets[peerIdx + 1] - offset };
+        }
 
-        // receive the values from the peer
-        values.receive(peerRank);
+        return { indicesRecvBuff_[peerIdx]->data(),
+                 valuesRecvBuff_[peerIdx]->data(),
+                 indicesRecvBuff_[peerIdx]->size() };
+    }
 
+    void copyFromMaster_(ProcessRank peerRank,
+                         const Index* indices,
+                         const FieldVector* values,
+                         size_t numRows)
+    {
         // copy them into the block vector
-        for (unsigned j = 0; j < indices.size(); ++j) {
+        for (size_t j = 0; j < numRows; ++j) {
             Index domRowIdx = indices[j];
             if (overlap_->masterRank(domRowIdx) == peerRank) {
                 (*this)[static_cast<unsigned>(domRowIdx)] = values[j];
@@ -332,26 +396,121 @@ private:
         }
     }
 
-    void receiveAdd_(ProcessRank peerRank)
+    void add_(const Index* indices, const FieldVector* values, size_t numRows)
     {
-        const MpiBuffer<Index>& indices = *indicesRecvBuff_[peerRank];
-        MpiBuffer<FieldVector>& values = *valuesRecvBuff_[peerRank];
-
-        // receive the values from the peer
-        values.receive(peerRank);
-
         // add up the values of rows on the shared boundary
-        for (unsigned j = 0; j < indices.size(); ++j) {
+        for (size_t j = 0; j < numRows; ++j) {
             Index domRowIdx = indices[j];
             (*this)[static_cast<unsigned>(domRowIdx)] += values[j];
         }
     }
 
-    std::map<ProcessRank, std::shared_ptr<MpiBuffer<unsigned> > > numIndicesSendBuff_;
-    std::map<ProcessRank, std::shared_ptr<MpiBuffer<Index> > > indicesSendBuff_;
-    std::map<ProcessRank, std::shared_ptr<MpiBuffer<Index> > > indicesRecvBuff_;
-    std::map<ProcessRank, std::shared_ptr<MpiBuffer<FieldVector> > > valuesSendBuff_;
-    std::map<ProcessRank, std::shared_ptr<MpiBuffer<FieldVector> > > valuesRecvBuff_;
+    // the data required to exchange the entries with all peers using a single
+    // neighborhood collective. the index and value arrays of all peers are packed in
+    // the order of the peer ranks.
+    struct NeighborExchange_
+    {
+        NeighborExchange_() = default;
+        NeighborExchange_(const NeighborExchange_&) = delete;
+
+        ~NeighborExchange_()
+        {
+#if HAVE_MPI
+            int finalized;
+            MPI_Finalized(&finalized);
+            if (!finalized && graphComm != MPI_COMM_NULL)
+                MPI_Comm_free(&graphComm);
+#endif
+        }
+
+#if HAVE_MPI
+        MPI_Comm graphComm{MPI_COMM_NULL};
+#endif
+        // message sizes and offsets in bytes
+        std::vector<int> sendCounts;
+        std::vector<int> sendDispls;
+        std::vector<int> recvCounts;
+        std::vector<int> recvDispls;
+
+        std::vector<size_t> recvOffsets;
+        std::vector<Index> sendIndices;
+        std::vector<Index> recvIndices;
+        std::vector<FieldVector> sendValues;
+        std::vector<FieldVector> recvValues;
+    };
+
+#if HAVE_MPI && MPI_VERSION >= 3
+    void createNeighborExchange_()
+    {
+        auto ex = std::make_shared<NeighborExchange_>();
+        size_t numPeers = peerRanks_.size();
+
+        // the peer relation is symmetric, so the peers are both the sources and the
+        // destinations of the communication graph
+        std::vector<int> neighbors(peerRanks_.begin(), peerRanks_.end());
+        MPI_Dist_graph_create_adjacent(MPI_COMM_WORLD,
+                                       static_cast<int>(numPeers), neighbors.data(), MPI_UNWEIGHTED,
+                                       static_cast<int>(numPeers), neighbors.data(), MPI_UNWEIGHTED,
+                                       MPI_INFO_NULL,
+                                       /*reorder=*/0,
+                                       &ex->graphComm);
+
+        // pack the index lists of all peers
+        ex->sendCounts.resize(numPeers);
+        ex->sendDispls.resize(numPeers);
+        ex->recvCounts.resize(numPeers);
+        ex->recvDispls.resize(numPeers);
+        ex->recvOffsets.resize(numPeers + 1, 0);
+        size_t numSend = 0;
+        for (size_t peerIdx = 0; peerIdx < numPeers; ++peerIdx) {
+            const MpiBuffer<Index>& sendIndices = *indicesSendBuff_[peerIdx];
+            const MpiBuffer<Index>& recvIndices = *indicesRecvBuff_[peerIdx];
+
+            ex->sendDispls[peerIdx] = static_cast<int>(numSend*sizeof(FieldVector));
+            ex->sendCounts[peerIdx] = static_cast<int>(sendIndices.size()*sizeof(FieldVector));
+            ex->sendIndices.insert(ex->sendIndices.end(),
+                                   sendIndices.data(), sendIndices.data() + sendIndices.size());
+            numSend += sendIndices.size();
+
+            size_t recvOffset = ex->recvOffsets[peerIdx];
+            ex->recvDispls[peerIdx] = static_cast<int>(recvOffset*sizeof(FieldVector));
+            ex->recvCounts[peerIdx] = static_cast<int>(recvIndices.size()*sizeof(FieldVector));
+            ex->recvIndices.insert(ex->recvIndices.end(),
+                                   recvIndices.data(), recvIndices.data() + recvIndices.size());
+            ex->recvOffsets[peerIdx + 1] = recvOffset + recvIndices.size();
+        }
+
+        ex->sendValues.resize(numSend);
+        ex->recvValues.resize(ex->recvOffsets[numPeers]);
+
+        neighborExchange_ = ex;
+    }
+
+    void exchangeNeighborEntries_()
+    {
+        auto& ex = *neighborExchange_;
+
+        // copy the values into the send buffer
+        for (size_t i = 0; i < ex.sendIndices.size(); ++i)
+            ex.sendValues[i] = (*this)[static_cast<unsigned>(ex.sendIndices[i])];
+
+        MPI_Neighbor_alltoallv(ex.sendValues.data(), ex.sendCounts.data(), ex.sendDispls.data(), MPI_BYTE,
+                               ex.recvValues.data(), ex.recvCounts.data(), ex.recvDispls.data(), MPI_BYTE,
+                               ex.graphComm);
+    }
+#endif // HAVE_MPI && MPI_VERSION >= 3
+
+    // the ranks of the peer processes. the buffers below are stored in the same order
+    std::vector<ProcessRank> peerRanks_;
+    std::vector<std::shared_ptr<MpiBuffer<Index> > > indicesSendBuff_;
+    std::vector<std::shared_ptr<MpiBuffer<Index> > > indicesRecvBuff_;
+    std::vector<std::shared_ptr<MpiBuffer<FieldVector> > > valuesSendBuff_;
+    std::vector<std::shared_ptr<MpiBuffer<FieldVector> > > valuesRecvBuff_;
+    // reused by the waits for the buffers
+    typename MpiBuffer<FieldVector>::RequestStorage requests_;
+
+    // only set if neighborhood collectives are used for the exchange
+    std::shared_ptr<NeighborExchange_> neighborExchange_;
 
     const Overlap *overlap_;
 };
@@ -35,11 +35,30 @@
 
 #include <dune/common/version.hh>
 
+#include <limits>
+
 namespace Opm {
 namespace Linear {
 
 /*!
  * \brief An overlap aware preconditioner for any ISTL linear solver.
+ *
+ * The sequential preconditioner is applied to the domestic rows of each process, i.e.,
+ * to the local matrix which includes the algebraic overlap. Afterwards the result is
+ * synchronized with the peer processes which copies the value of each row from the
+ * process which is its master. Since every row thus takes the value computed by exactly
+ * one local solve, this is restricted additive Schwarz (RAS) and each application of the
+ * preconditioner needs exactly one exchange of the overlap. No additional exchanges are
+ * required: The right hand side \f$d\f$ handed to apply() is consistent on the overlap
+ * because the OverlappingOperator synchronizes its result and the scalar product only
+ * considers the master rows.
+ *
+ * By default, the processes agree after each application whether the sequential
+ * preconditioner succeeded on all of them, which is an additional global reduction. If
+ * the collective error check is disabled, the result of a failed local application is
+ * set to NaN instead. The NaNs are distributed by the exchange of the overlap and by the
+ * next scalar product so that all processes of the linear solver detect the problem
+ * consistently.
  */
 template <class SeqPreCond, class Overlap>
 class OverlappingPreconditioner
@@ -54,8 +73,12 @@ public:
     Dune::SolverCategory::Category category() const override
     { return Dune::SolverCategory::overlapping; }
 
-    OverlappingPreconditioner(SeqPreCond& seqPreCond, const Overlap& overlap)
-        : seqPreCond_(seqPreCond), overlap_(&overlap)
+    OverlappingPreconditioner(SeqPreCond& seqPreCond,
+                              const Overlap& overlap,
+                              bool collectiveErrorCheck = true)
+        : seqPreCond_(seqPreCond)
+        , overlap_(&overlap)
+        , collectiveErrorCheck_(collectiveErrorCheck)
     {}
 
     void pre(domain_type& x, range_type& y) override
@@ -84,16 +107,14 @@ public:
                           MPI_COMM_WORLD); // communicator
         }
 
-        if (success) {
-            x.sync();
-        }
-        else
+        if (!success)
             throw NumericalProblem("Preconditioner threw an exception in pre() method on some process.");
 #else
         seqPreCond_.pre(x, y);
 #endif
 
-        // communicate the results on the overlap
+        // the sequential preconditioner may have modified both vectors, so communicate
+        // the results on the overlap
         x.sync();
         y.sync();
     }
@@ -102,6 +123,20 @@ public:
     {
 #if HAVE_MPI
         if (overlap_->peerSet().size() > 0) {
+            if (!collectiveErrorCheck_) {
+                try {
+                    seqPreCond_.apply(x, d);
+                }
+                catch (...) {
+                    // poison the result. this makes all processes see the problem at
+                    // the latest in the next scalar product of the linear solver
+                    x = std::numeric_limits<typename domain_type::field_type>::quiet_NaN();
+                }
+
+                x.sync();
+                return;
+            }
+
             // make sure that all processes react the same if the
             // sequential preconditioner on one process throws an
             // exception
@@ -180,6 +215,7 @@ public:
 private:
     SeqPreCond& seqPreCond_;
     const Overlap *overlap_;
+    bool collectiveErrorCheck_;
 };
 
 } // namespace Linear
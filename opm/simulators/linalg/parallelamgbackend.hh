@@ -28,10 +28,13 @@
 #define EWOMS_PARALLEL_AMG_BACKEND_HH
 
 #include "linalgproperties.hh"
+#include "amgcoarsencriterion.hh"
+#include "amgindexset.hh"
 #include "parallelbasebackend.hh"
 #include "bicgstabsolver.hh"
 #include "combinedcriterion.hh"
 #include "istlsparsematrixadapter.hh"
+#include "multicoloramgsmoother.hh"
 
 #include <dune/istl/bcrsmatrix.hh>
 #include <dune/istl/paamg/amg.hh>
@@ -40,6 +43,7 @@
 
 #include <memory>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 
 namespace Opm::Linear {
@@ -54,11 +58,6 @@ namespace TTag {
 struct ParallelAmgLinearSolver { using InheritsFrom = std::tuple<ParallelBaseLinearSolver>; };
 } // end namespace TTag
 
-//! The target number of DOFs per processor for the parallel algebraic
-//! multi-grid solver
-template<class TypeTag>
-struct AmgCoarsenTarget<TypeTag, TTag::ParallelAmgLinearSolver> { static constexpr int value = 5000; };
-
 template<class TypeTag>
 struct LinearSolverMaxError<TypeTag, TTag::ParallelAmgLinearSolver>
 {
@@ -70,6 +69,9 @@ template<class TypeTag>
 struct LinearSolverBackend<TypeTag, TTag::ParallelAmgLinearSolver>
 { using type = Opm::Linear::ParallelAmgBackend<TypeTag>; };
 
+template<class TypeTag>
+struct EnableThreadedAmgSmoother<TypeTag, TTag::ParallelAmgLinearSolver> { static constexpr bool value = false; };
+
 } // namespace Opm::Properties
 
 namespace Opm {
@@ -106,7 +108,10 @@ class ParallelAmgBackend : public ParallelBaseBackend<TypeTag>
 
     // define the smoother used for the AMG and specify its
     // arguments
-    using SequentialSmoother = Dune::SeqSOR<IstlMatrix, Vector, Vector>;
+    using SequentialSmoother =
+        std::conditional_t<getPropValue<TypeTag, Properties::EnableThreadedAmgSmoother>(),
+                           MultiColorAmgSmoother<IstlMatrix, Vector>,
+                           Dune::SeqSOR<IstlMatrix, Vector, Vector> >;
 // using SequentialSmoother = Dune::SeqSSOR<IstlMatrix,Vector,Vector>;
 // using SequentialSmoother = Dune::SeqJac<IstlMatrix,Vector,Vector>;
 // using SequentialSmoother = Dune::SeqILU<IstlMatrix,Vector,Vector>;
@@ -156,6 +161,9 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, int, AmgCoarsenTarget,
                              "The coarsening target for the agglomerations of "
                              "the AMG preconditioner");
+        EWOMS_REGISTER_PARAM(TypeTag, int, AmgHierarchyRefreshInterval,
+                             "The number of linear solves after which the aggregates of "
+                             "the AMG preconditioner are recomputed");
     }
 
 protected:
@@ -163,22 +171,39 @@ protected:
 
     std::shared_ptr<AMG> preparePreconditioner_()
     {
+        // the parallel index set and the fine level operator only depend on the overlap
+        // and are thus kept until the overlapping matrix is recreated
+        if (!fineOperator_) {
 #if HAVE_MPI
-        // create and initialize DUNE's OwnerOverlapCopyCommunication
-        // using the domestic overlap
-        istlComm_ = std::make_shared<OwnerOverlapCopyCommunication>(MPI_COMM_WORLD);
-        setupAmgIndexSet_(this->overlappingMatrix_->overlap(), istlComm_->indexSet());
-        istlComm_->remoteIndices().template rebuild<false>();
+            // create and initialize DUNE's OwnerOverlapCopyCommunication
+            // using the domestic overlap
+            istlComm_ = std::make_shared<OwnerOverlapCopyCommunication>(MPI_COMM_WORLD);
+            setupAmgIndexSet(this->overlappingMatrix_->overlap(), istlComm_->indexSet());
+            istlComm_->remoteIndices().template rebuild<false>();
 #endif
 
-        // create the parallel scalar product and the parallel operator
+            // create the parallel operator
 #if HAVE_MPI
-        fineOperator_ = std::make_shared<FineOperator>(*this->overlappingMatrix_, *istlComm_);
+            fineOperator_ = std::make_shared<FineOperator>(*this->overlappingMatrix_, *istlComm_);
 #else
-        fineOperator_ = std::make_shared<FineOperator>(*this->overlappingMatrix_);
+            fineOperator_ = std::make_shared<FineOperator>(*this->overlappingMatrix_);
 #endif
+        }
 
-        setupAmg_();
+        int refreshInterval = EWOMS_GET_PARAM(TypeTag, int, AmgHierarchyRefreshInterval);
+        if (!amg_ || numSolvesSinceAmgSetup_ >= refreshInterval) {
+            setupAmg_();
+            numSolvesSinceAmgSetup_ = 0;
+        }
+        else
+            // keep the aggregates and only recompute the matrices of the coarse levels.
+            // the smoothers reference these matrices, so they pick up the new values.
+            // the solver of the coarsest level is not set up again, i.e., a direct
+            // solver keeps its factorization. test_amghierarchyreuse checks that this
+            // does not impair the convergence for the Jacobians of consecutive Newton
+            // iterations.
+            amg_->recalculateHierarchy();
+        ++numSolvesSinceAmgSetup_;
 
         return amg_;
     }
@@ -186,6 +211,20 @@ protected:
     void cleanupPreconditioner_()
     { /* nothing to do */ }
 
+    void cleanup_()
+    {
+        // the AMG hierarchy refers to the overlapping matrix which is about to be
+        // deleted
+        amg_.reset();
+        fineOperator_.reset();
+#if HAVE_MPI
+        istlComm_.reset();
+#endif
+        numSolvesSinceAmgSetup_ = 0;
+
+        ParentType::cleanup_();
+    }
+
     std::shared_ptr<RawLinearSolver> prepareSolver_(ParallelOperator& parOperator,
                                                     ParallelScalarProduct& parScalarProduct,
                                                     AMG& parPreCond)
@@ -226,35 +265,6 @@ protected:
     void cleanupSolver_()
     { /* nothing to do */ }
 
-#if HAVE_MPI
-    template <class ParallelIndexSet>
-    void setupAmgIndexSet_(const Overlap& overlap, ParallelIndexSet& istlIndices)
-    {
-        using GridAttributes = Dune::OwnerOverlapCopyAttributeSet;
-        using GridAttributeSet = Dune::OwnerOverlapCopyAttributeSet::AttributeSet;
-
-        // create DUNE's ParallelIndexSet from a domestic overlap
-        istlIndices.beginResize();
-        for (Index curIdx = 0; static_cast<size_t>(curIdx) < overlap.numDomestic(); ++curIdx) {
-            GridAttributeSet gridFlag =
-                overlap.iAmMasterOf(curIdx)
-                ? GridAttributes::owner
-                : GridAttributes::copy;
-
-            // an index is used by other processes if it is in the
-            // domestic or in the foreign overlap.
-            bool isShared = overlap.isInOverlap(curIdx);
-
-            assert(curIdx == overlap.globalToDomestic(overlap.domesticToGlobal(curIdx)));
-            istlIndices.add(/*globalIdx=*/overlap.domesticToGlobal(curIdx),
-                            Dune::ParallelLocalIndex<GridAttributeSet>(static_cast<size_t>(curIdx),
-                                                                       gridFlag,
-                                                                       isShared));
-        }
-        istlIndices.endResize();
-    }
-#endif
-
     void setupAmg_()
     {
         if (amg_)
@@ -270,27 +280,10 @@ protected:
         smootherArgs.iterations = 1;
         smootherArgs.relaxationFactor = 1.0;
 
-        // specify the coarsen criterion:
-        //
-        // using CoarsenCriterion =
-        // Dune::Amg::CoarsenCriterion<Dune::Amg::SymmetricCriterion<IstlMatrix,
-        //                             Dune::Amg::FirstDiagonal>>
-        using CoarsenCriterion = Dune::Amg::
-            CoarsenCriterion<Dune::Amg::SymmetricCriterion<IstlMatrix, Dune::Amg::FrobeniusNorm> >;
-        int coarsenTarget = EWOMS_GET_PARAM(TypeTag, int, AmgCoarsenTarget);
-        CoarsenCriterion coarsenCriterion(/*maxLevel=*/15, coarsenTarget);
-        coarsenCriterion.setDefaultValuesAnisotropic(GridView::dimension,
-                                                     /*aggregateSizePerDim=*/3);
-        if (verbosity > 0)
-            coarsenCriterion.setDebugLevel(1);
-        else
-            coarsenCriterion.setDebugLevel(0); // make the AMG shut up
-
-        // reduce the minium coarsen rate (default is 1.2)
-        coarsenCriterion.setMinCoarsenRate(1.05);
-        // coarsenCriterion.setAccumulate(Dune::Amg::noAccu);
-        coarsenCriterion.setAccumulate(Dune::Amg::atOnceAccu);
-        coarsenCriterion.setSkipIsolated(false);
+        auto coarsenCriterion =
+            amgCoarsenCriterion<IstlMatrix>(EWOMS_GET_PARAM(TypeTag, int, AmgCoarsenTarget),
+                                            GridView::dimension,
+                                            verbosity);
 
 // instantiate the AMG preconditioner
 #if HAVE_MPI
@@ -304,6 +297,7 @@ protected:
 
     std::shared_ptr<FineOperator> fineOperator_;
     std::shared_ptr<AMG> amg_;
+    int numSolvesSinceAmgSetup_ = 0;
 
 #if HAVE_MPI
     std::shared_ptr<OwnerOverlapCopyCommunication> istlComm_;
@@ -41,6 +41,7 @@
 #include <opm/models/utils/genericguard.hh>
 #include <opm/models/utils/propertysystem.hh>
 #include <opm/models/utils/parametersystem.hh>
+#include <opm/models/utils/profiler.hh>
 #include <opm/simulators/linalg/matrixblock.hh>
 #include <opm/simulators/linalg/linalgproperties.hh>
 
@@ -103,6 +104,10 @@ namespace Linear {
  *            that it is computationally cheaper because it does not
  *            need to consider things which are only required for
  *            higher orders
+ * - \c ReorderedILU: An ILU(0) preconditioner which internally permutes the linear
+ *                    system using the reverse Cuthill-McKee ordering to improve memory
+ *                    locality
+ * - \c Runtime: Selects the preconditioner using the "PreconditionerType" parameter
  */
 template <class TypeTag>
 class ParallelBaseBackend
@@ -158,11 +163,17 @@ public:
                              "The maximum accepted error of the norm of the residual");
         EWOMS_REGISTER_PARAM(TypeTag, unsigned, LinearSolverOverlapSize,
                              "The size of the algebraic overlap for the linear solver");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, LinearSolverUseNeighborCollectives,
+                             "Exchange the overlap of vectors using MPI-3 neighborhood collectives");
         EWOMS_REGISTER_PARAM(TypeTag, int, LinearSolverMaxIterations,
                              "The maximum number of iterations of the linear solver");
         EWOMS_REGISTER_PARAM(TypeTag, int, LinearSolverVerbosity,
                              "The verbosity level of the linear solver");
 
+        EWOMS_REGISTER_PARAM(TypeTag, bool, PreconditionerCollectiveErrorCheck,
+                             "Check for failures of the preconditioner on all processes "
+                             "after each of its applications");
+
         PreconditionerWrapper::registerParameters();
     }
 
@@ -171,7 +182,7 @@ public:
      *        equations the next time it is called.
      */
     void eraseMatrix()
-    { cleanup_(); }
+    { asImp_().cleanup_(); }
 
     /*!
      * \brief Set up the internal data structures required for the linear solver.
@@ -204,6 +215,7 @@ public:
         // create the overlapping vectors for the residual and the
         // solution
         overlappingb_ = new OverlappingVector(overlappingMatrix_->overlap());
+        overlappingb_->setUseNeighborCollectives(EWOMS_GET_PARAM(TypeTag, bool, LinearSolverUseNeighborCollectives));
         overlappingx_ = new OverlappingVector(*overlappingb_);
 
         // writeOverlapToVTK_();
@@ -275,6 +287,7 @@ public:
         auto result = asImp_().runSolver_(solver);
         // store number of iterations used
         lastIterations_ = result.second;
+        EWOMS_PROFILE_COUNT("linear iterations", lastIterations_);
 
         // copy the result back to the non-overlapping vector
         overlappingx_->assignTo(x);
@@ -306,6 +319,11 @@ protected:
         overlappingMatrix_ = 0;
         overlappingb_ = 0;
         overlappingx_ = 0;
+
+        // the data which the preconditioner keeps across linear solves belongs to the
+        // overlapping matrix
+        if constexpr (HasPreconditionerInvalidate<PreconditionerWrapper>::value)
+            precWrapper_.invalidate();
     }
 
     std::shared_ptr<ParallelPreconditioner> preparePreconditioner_()
@@ -329,7 +347,9 @@ protected:
             throw NumericalProblem("Creating the preconditioner failed");
 
         // create the parallel preconditioner
-        return std::make_shared<ParallelPreconditioner>(precWrapper_.get(), overlappingMatrix_->overlap());
+        return std::make_shared<ParallelPreconditioner>(precWrapper_.get(),
+                                                        overlappingMatrix_->overlap(),
+                                                        EWOMS_GET_PARAM(TypeTag, bool, PreconditionerCollectiveErrorCheck));
     }
 
     void cleanupPreconditioner_()
@@ -404,6 +424,27 @@ struct PreconditionerRelaxation<TypeTag, TTag::ParallelBaseLinearSolver>
 template<class TypeTag>
 struct PreconditionerOrder<TypeTag, TTag::ParallelBaseLinearSolver> { static constexpr int value = 0; };
 
+//! The target number of DOFs per processor for the algebraic multi-grid
+//! preconditioners
+template<class TypeTag>
+struct AmgCoarsenTarget<TypeTag, TTag::ParallelBaseLinearSolver> { static constexpr int value = 5000; };
+
+//! Recompute the aggregates of the AMG for every linear solve by default
+template<class TypeTag>
+struct AmgHierarchyRefreshInterval<TypeTag, TTag::ParallelBaseLinearSolver> { static constexpr int value = 1; };
+
+//! use ILU(0) if the preconditioner is selected at run time
+template<class TypeTag>
+struct PreconditionerType<TypeTag, TTag::ParallelBaseLinearSolver> { static constexpr auto value = "ilu0"; };
+
+//! use ILU(0) if the multi-color preconditioner is selected
+template<class TypeTag>
+struct PreconditionerMultiColorMethod<TypeTag, TTag::ParallelBaseLinearSolver> { static constexpr auto value = "ilu0"; };
+
+//! check for failures of the preconditioner after each application by default
+template<class TypeTag>
+struct PreconditionerCollectiveErrorCheck<TypeTag, TTag::ParallelBaseLinearSolver> { static constexpr bool value = true; };
+
 //! by default use the same kind of floating point values for the linearization and for
 //! the linear solve
 template<class TypeTag>
@@ -462,6 +503,10 @@ struct PreconditionerWrapper<TypeTag, TTag::ParallelBaseLinearSolver>
 template<class TypeTag>
 struct LinearSolverOverlapSize<TypeTag, TTag::ParallelBaseLinearSolver> { static constexpr int value = 2; };
 
+//! use point-to-point communication for the overlap of vectors by default
+template<class TypeTag>
+struct LinearSolverUseNeighborCollectives<TypeTag, TTag::ParallelBaseLinearSolver> { static constexpr bool value = false; };
+
 //! set the default number of maximum iterations for the linear solver
 template<class TypeTag>
 struct LinearSolverMaxIterations<TypeTag, TTag::ParallelBaseLinearSolver> { static constexpr int value = 1000; };
@@ -0,0 +1,233 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Opm::Linear::ReorderedPreconditioner
+ */
+#ifndef EWOMS_REORDERED_PRECONDITIONER_HH
+#define EWOMS_REORDERED_PRECONDITIONER_HH
+
+#include <dune/istl/preconditioner.hh>
+#include <dune/istl/solvercategory.hh>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace Opm {
+namespace Linear {
+
+/*!
+ * \brief Compute the reverse Cuthill-McKee ordering of the rows of a sparse matrix.
+ *
+ * The ordering reduces the bandwidth of the matrix, i.e., rows which are coupled end up
+ * close to each other. Besides improving the memory locality of the triangular solves of
+ * ILU type preconditioners, this usually also improves the quality of the incomplete
+ * factorization. The sparsity pattern is assumed to be structurally symmetric.
+ *
+ * \return The permutation, i.e., the index of the row of the original matrix for each
+ *         row of the reordered matrix
+ */
+template <class Matrix>
+std::vector<std::size_t> reverseCuthillMcKeeOrdering(const Matrix& matrix)
+{
+    const std::size_t numRows = matrix.N();
+
+    std::vector<std::size_t> degree(numRows);
+    for (std::size_t rowIdx = 0; rowIdx < numRows; ++rowIdx)
+        degree[rowIdx] = matrix[rowIdx].size();
+
+    // each connected component is started at a row of minimal degree, which is a cheap
+    // approximation of a pseudo-peripheral node
+    std::vector<std::size_t> seeds(numRows);
+    for (std::size_t rowIdx = 0; rowIdx < numRows; ++rowIdx)
+        seeds[rowIdx] = rowIdx;
+    std::stable_sort(seeds.begin(), seeds.end(),
+                     [&degree](std::size_t a, std::size_t b)
+                     { return degree[a] < degree[b]; });
+
+    std::vector<std::size_t> ordering;
+    ordering.reserve(numRows);
+    std::vector<bool> visited(numRows, false);
+    std::vector<std::size_t> neighbors;
+    for (std::size_t seedIdx : seeds) {
+        if (visited[seedIdx])
+            continue;
+
+        visited[seedIdx] = true;
+        ordering.push_back(seedIdx);
+        for (std::size_t headIdx = ordering.size() - 1; headIdx < ordering.size(); ++headIdx) {
+            const auto& row = matrix[ordering[headIdx]];
+
+            neighbors.clear();
+            for (auto colIt = row.begin(); colIt != row.end(); ++colIt) {
+                const std::size_t colIdx = colIt.index();
+                if (colIdx < numRows && !visited[colIdx]) {
+                    visited[colIdx] = true;
+                    neighbors.push_back(colIdx);
+                }
+            }
+
+            std::stable_sort(neighbors.begin(), neighbors.end(),
+                             [&degree](std::size_t a, std::size_t b)
+                             { return degree[a] < degree[b]; });
+            ordering.insert(ordering.end(), neighbors.begin(), neighbors.end());
+        }
+    }
+
+    std::reverse(ordering.begin(), ordering.end());
+    return ordering;
+}
+
+/*!
+ * \brief Applies a sequential preconditioner to a permuted version of the linear system
+ *        of equations.
+ *
+ * The permutation is only visible within the preconditioner, i.e., the linear solver and
+ * all code outside of it keep using the original numbering of the degrees of freedom.
+ * The permuted matrix is owned by this object and its sparsity pattern is kept if the
+ * values are updated via updateMatrix().
+ */
+template <class InnerPreconditioner, class Vector>
+class ReorderedPreconditioner : public Dune::Preconditioner<Vector, Vector>
+{
+    using InnerMatrix = typename InnerPreconditioner::matrix_type;
+    using InnerVector = typename InnerPreconditioner::domain_type;
+
+public:
+    using domain_type = Vector;
+    using range_type = Vector;
+    using field_type = typename Vector::field_type;
+
+    /*!
+     * \brief Set the permutation which ought to be used by the preconditioner.
+     *
+     * \param ordering The index of the original row for each row of the permuted matrix
+     */
+    explicit ReorderedPreconditioner(std::vector<std::size_t> ordering)
+        : ordering_(std::move(ordering))
+        , inverseOrdering_(ordering_.size())
+    {
+        for (std::size_t newIdx = 0; newIdx < ordering_.size(); ++newIdx)
+            inverseOrdering_[ordering_[newIdx]] = newIdx;
+    }
+
+    /*!
+     * \brief Returns the number of rows of the matrices which can be handled.
+     */
+    std::size_t size() const
+    { return ordering_.size(); }
+
+    /*!
+     * \brief Copy the entries of the original matrix into the permuted one.
+     *
+     * The sparsity pattern of the permuted matrix is created by the first call. All
+     * subsequent calls must thus pass a matrix which exhibits the same sparsity pattern,
+     * i.e., a new object must be created if the structure of the matrix changes.
+     */
+    template <class Matrix>
+    void updateMatrix(const Matrix& matrix)
+    {
+        const std::size_t numRows = ordering_.size();
+        if (matrix.N() != numRows)
+            throw std::invalid_argument("The matrix does not match the size of the ordering "
+                                        "of the reordered preconditioner");
+
+        if (!patternCreated_) {
+            permutedMatrix_.setBuildMode(InnerMatrix::random);
+            permutedMatrix_.setSize(numRows, numRows);
+            for (std::size_t newRowIdx = 0; newRowIdx < numRows; ++newRowIdx)
+                permutedMatrix_.setrowsize(newRowIdx, matrix[ordering_[newRowIdx]].size());
+            permutedMatrix_.endrowsizes();
+
+            for (std::size_t newRowIdx = 0; newRowIdx < numRows; ++newRowIdx) {
+                const auto& row = matrix[ordering_[newRowIdx]];
+                for (auto colIt = row.begin(); colIt != row.end(); ++colIt)
+                    permutedMatrix_.addindex(newRowIdx, inverseOrdering_[colIt.index()]);
+            }
+            permutedMatrix_.endindices();
+
+            permutedD_.resize(numRows);
+            permutedV_.resize(numRows);
+            patternCreated_ = true;
+        }
+
+        for (std::size_t newRowIdx = 0; newRowIdx < numRows; ++newRowIdx) {
+            const auto& row = matrix[ordering_[newRowIdx]];
+            auto& permutedRow = permutedMatrix_[newRowIdx];
+            for (auto colIt = row.begin(); colIt != row.end(); ++colIt)
+                permutedRow[inverseOrdering_[colIt.index()]] = *colIt;
+        }
+    }
+
+    /*!
+     * \brief Returns the permuted matrix.
+     */
+    const InnerMatrix& permutedMatrix() const
+    { return permutedMatrix_; }
+
+    /*!
+     * \brief Set the preconditioner for the permuted matrix.
+     */
+    void setInnerPreconditioner(std::unique_ptr<InnerPreconditioner> innerPreCond)
+    { innerPreCond_ = std::move(innerPreCond); }
+
+    void pre(domain_type&, range_type&) override
+    {}
+
+    void apply(domain_type& v, const range_type& d) override
+    {
+        const std::size_t numRows = ordering_.size();
+        for (std::size_t newIdx = 0; newIdx < numRows; ++newIdx)
+            permutedD_[newIdx] = d[ordering_[newIdx]];
+
+        permutedV_ = 0.0;
+        innerPreCond_->apply(permutedV_, permutedD_);
+
+        for (std::size_t newIdx = 0; newIdx < numRows; ++newIdx)
+            v[ordering_[newIdx]] = permutedV_[newIdx];
+    }
+
+    void post(domain_type&) override
+    {}
+
+    Dune::SolverCategory::Category category() const override
+    { return Dune::SolverCategory::sequential; }
+
+private:
+    std::vector<std::size_t> ordering_;
+    std::vector<std::size_t> inverseOrdering_;
+
+    InnerMatrix permutedMatrix_;
+    bool patternCreated_ = false;
+    InnerVector permutedD_;
+    InnerVector permutedV_;
+
+    std::unique_ptr<InnerPreconditioner> innerPreCond_;
+};
+
+}} // namespace Linear, Opm
+
+#endif
@@ -0,0 +1,123 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Opm::Linear::SparsityPatternTracker
+ */
+#ifndef EWOMS_SPARSITY_PATTERN_TRACKER_HH
+#define EWOMS_SPARSITY_PATTERN_TRACKER_HH
+
+#include <cstddef>
+#include <vector>
+
+namespace Opm {
+namespace Linear {
+
+/*!
+ * \brief Keeps a copy of the sparsity pattern of a matrix to detect structural changes.
+ *
+ * Preconditioners which reuse data that only depends on the structure of the matrix
+ * (orderings, colorings, the pattern of derived matrices, ...) cannot rely on the number
+ * of rows and non-zero entries to decide whether this data is still valid: Two different
+ * patterns may exhibit the same number of entries. This class thus compares the column
+ * indices of all rows.
+ */
+class SparsityPatternTracker
+{
+public:
+    /*!
+     * \brief Compare the sparsity pattern of a matrix with the one seen last.
+     *
+     * If the patterns differ, the pattern of the matrix is stored for the next call.
+     *
+     * \return true if the pattern of the matrix is different from the one passed to the
+     *         previous call or if no matrix has been passed so far
+     */
+    template <class Matrix>
+    bool update(const Matrix& matrix)
+    {
+        if (!matches_(matrix)) {
+            store_(matrix);
+            return true;
+        }
+
+        return false;
+    }
+
+    /*!
+     * \brief Forget the stored pattern.
+     *
+     * The next call to update() will thus report a change.
+     */
+    void reset()
+    {
+        rowStart_.clear();
+        colIndices_.clear();
+    }
+
+private:
+    template <class Matrix>
+    bool matches_(const Matrix& matrix) const
+    {
+        const std::size_t numRows = matrix.N();
+        if (rowStart_.size() != numRows + 1 || colIndices_.size() != matrix.nonzeroes())
+            return false;
+
+        for (std::size_t rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+            const auto& row = matrix[rowIdx];
+            if (row.size() != rowStart_[rowIdx + 1] - rowStart_[rowIdx])
+                return false;
+
+            std::size_t pos = rowStart_[rowIdx];
+            for (auto colIt = row.begin(); colIt != row.end(); ++colIt, ++pos)
+                if (colIt.index() != colIndices_[pos])
+                    return false;
+        }
+
+        return true;
+    }
+
+    template <class Matrix>
+    void store_(const Matrix& matrix)
+    {
+        const std::size_t numRows = matrix.N();
+        rowStart_.resize(numRows + 1);
+        colIndices_.resize(matrix.nonzeroes());
+
+        std::size_t pos = 0;
+        rowStart_[0] = 0;
+        for (std::size_t rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+            const auto& row = matrix[rowIdx];
+            for (auto colIt = row.begin(); colIt != row.end(); ++colIt, ++pos)
+                colIndices_[pos] = colIt.index();
+            rowStart_[rowIdx + 1] = pos;
+        }
+    }
+
+    std::vector<std::size_t> rowStart_;
+    std::vector<std::size_t> colIndices_;
+};
+
+}} // namespace Linear, Opm
+
+#endif
@@ -97,6 +97,14 @@ public:
     bool solve(Vector& x)
     { return SuperLUSolve_<Scalar, TypeTag, Matrix, Vector>::solve_(*M_, x, *b_); }
 
+    /*!
+     * \brief Return number of iterations used during last solve.
+     *
+     * SuperLU is a direct solver, so this is always one.
+     */
+    size_t iterations() const
+    { return 1; }
+
 private:
     const Matrix* M_;
     Vector* b_;
@@ -0,0 +1,118 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Helpers to create the block-structured linear systems of equations used by the
+ *        tests of the linear solvers and of the local solves of the Newton method.
+ *
+ * The tests only specify which rows are coupled, the values of the matrix and of the
+ * right-hand side are set by the functions of this file.
+ */
+#ifndef EWOMS_TESTS_BLOCK_MATRIX_FIXTURES_HH
+#define EWOMS_TESTS_BLOCK_MATRIX_FIXTURES_HH
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace Opm::Test {
+
+/*!
+ * \brief Create a diagonally dominant block matrix which couples each row with the given
+ *        neighbors.
+ *
+ * The off-diagonal blocks are the negative identity. The equations of a row are coupled
+ * with each other by 0.5 and the diagonal entries are given by a function of the row.
+ *
+ * \param neighbors The indices of the rows which are coupled with each row
+ * \param diagonal A function which returns the diagonal entries of a row
+ */
+template <class Matrix, class DiagonalFn>
+Matrix createCouplingMatrix(const std::vector<std::vector<std::size_t> >& neighbors,
+                            const DiagonalFn& diagonal)
+{
+    const std::size_t numRows = neighbors.size();
+    Matrix matrix(numRows, numRows, Matrix::random);
+
+    for (std::size_t rowIdx = 0; rowIdx < numRows; ++rowIdx)
+        matrix.setrowsize(rowIdx, neighbors[rowIdx].size() + 1);
+    matrix.endrowsizes();
+    for (std::size_t rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+        matrix.addindex(rowIdx, rowIdx);
+        for (std::size_t colIdx : neighbors[rowIdx])
+            matrix.addindex(rowIdx, colIdx);
+    }
+    matrix.endindices();
+
+    for (std::size_t rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+        auto& row = matrix[rowIdx];
+        for (auto colIt = row.begin(); colIt != row.end(); ++colIt) {
+            auto& block = *colIt;
+            block = 0.0;
+            for (std::size_t i = 0; i < block.N(); ++i) {
+                if (colIt.index() != rowIdx) {
+                    block[i][i] = -1.0;
+                    continue;
+                }
+
+                for (std::size_t j = 0; j < block.M(); ++j)
+                    block[i][j] = (i == j) ? diagonal(rowIdx) : 0.5;
+            }
+        }
+    }
+
+    return matrix;
+}
+
+/*!
+ * \brief Create a right-hand side whose entries vary smoothly with the row index.
+ */
+template <class Vector>
+Vector createRhs(std::size_t numRows)
+{
+    Vector b(numRows);
+    for (std::size_t rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+        const auto x = static_cast<typename Vector::field_type>(rowIdx);
+        for (std::size_t i = 0; i < b[rowIdx].size(); ++i)
+            b[rowIdx][i] = (i == 0) ? 1.0 + std::sin(x) : std::cos(i*x);
+    }
+    return b;
+}
+
+/*!
+ * \brief Returns the maximum norm of b - A*x relative to the one of b.
+ */
+template <class Matrix, class Vector>
+typename Vector::field_type relativeResidual(const Matrix& matrix,
+                                             const Vector& x,
+                                             const Vector& b)
+{
+    Vector r(b);
+    matrix.mmv(x, r);
+    return r.infinity_norm()/b.infinity_norm();
+}
+
+} // namespace Opm::Test
+
+#endif
@@ -0,0 +1,55 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief The lens_immiscible_ecfv_ad simulator which selects the preconditioner of the
+ *        linear solver at run time
+ *
+ * The preconditioner is specified using the --preconditioner-type command line
+ * parameter.
+ */
+#include "config.h"
+
+#include "lens_immiscible_ecfv_ad.hh"
+
+#include <opm/models/utils/start.hh>
+#include <opm/simulators/linalg/parallelbicgstabbackend.hh>
+
+namespace Opm::Properties {
+
+namespace TTag {
+struct LensProblemEcfvAdPrecond { using InheritsFrom = std::tuple<LensProblemEcfvAd>; };
+} // end namespace TTag
+
+template<class TypeTag>
+struct PreconditionerWrapper<TypeTag, TTag::LensProblemEcfvAdPrecond>
+{ using type = Opm::Linear::PreconditionerWrapperRuntime<TypeTag>; };
+
+} // namespace Opm::Properties
+
+int main(int argc, char **argv)
+{
+    using ProblemTypeTag = Opm::Properties::TTag::LensProblemEcfvAdPrecond;
+    return Opm::start<ProblemTypeTag>(argc, argv);
+}
@@ -0,0 +1,191 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Test which verifies that the sparse finite difference linearization yields the
+ *        same local Jacobian matrices as the dense one.
+ *
+ * The lens problem is linearized with the vertex centered finite volume method and
+ * two-point gradients for a non-trivial saturation distribution. The test then checks
+ * that the combination of sparse numeric differentiation with P1 finite element
+ * gradients is rejected.
+ */
+#include "config.h"
+
+#include <opm/models/utils/start.hh>
+#include <opm/models/immiscible/immisciblemodel.hh>
+#include <opm/models/discretization/vcfv/vcfvdiscretization.hh>
+#include <opm/simulators/linalg/parallelbicgstabbackend.hh>
+
+#include "problems/lensproblem.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+namespace Opm::Properties {
+
+// Create new type tags
+namespace TTag {
+struct LensProblemVcfvFdSparse { using InheritsFrom = std::tuple<LensBaseProblem, ImmiscibleTwoPhaseModel>; };
+struct LensProblemVcfvFdSparseP1 { using InheritsFrom = std::tuple<LensProblemVcfvFdSparse>; };
+} // end namespace TTag
+
+// use the vertex centered finite volume method and finite differences
+template<class TypeTag>
+struct SpatialDiscretizationSplice<TypeTag, TTag::LensProblemVcfvFdSparse> { using type = TTag::VcfvDiscretization; };
+template<class TypeTag>
+struct LocalLinearizerSplice<TypeTag, TTag::LensProblemVcfvFdSparse> { using type = TTag::FiniteDifferenceLocalLinearizer; };
+
+// sparse numeric differentiation requires two-point gradients
+template<class TypeTag>
+struct UseP1FiniteElementGradients<TypeTag, TTag::LensProblemVcfvFdSparse> { static constexpr bool value = false; };
+template<class TypeTag>
+struct UseP1FiniteElementGradients<TypeTag, TTag::LensProblemVcfvFdSparseP1> { static constexpr bool value = true; };
+
+} // namespace Opm::Properties
+
+template <class TypeTag>
+bool compareLocalJacobians()
+{
+    using Simulator = Opm::GetPropType<TypeTag, Opm::Properties::Simulator>;
+    using ElementContext = Opm::GetPropType<TypeTag, Opm::Properties::ElementContext>;
+    using LocalLinearizer = Opm::GetPropType<TypeTag, Opm::Properties::LocalLinearizer>;
+    using Indices = Opm::GetPropType<TypeTag, Opm::Properties::Indices>;
+    using Scalar = Opm::GetPropType<TypeTag, Opm::Properties::Scalar>;
+
+    enum { numEq = Opm::getPropValue<TypeTag, Opm::Properties::NumEq>() };
+
+    Simulator simulator(/*verbose=*/false);
+    auto& model = simulator.model();
+    model.applyInitialSolution();
+
+    // the initial condition of the lens problem is fully water saturated, so we
+    // prescribe a saturation which varies from one degree of freedom to the next
+    auto& solution = model.solution(/*timeIdx=*/0);
+    for (unsigned globalIdx = 0; globalIdx < solution.size(); ++globalIdx)
+        solution[globalIdx][Indices::saturation0Idx] = 0.2 + 0.6*((globalIdx*7) % 11)/10.0;
+    model.solution(/*timeIdx=*/1) = solution;
+    model.invalidateIntensiveQuantitiesCache(/*timeIdx=*/0);
+    model.invalidateIntensiveQuantitiesCache(/*timeIdx=*/1);
+
+    LocalLinearizer denseLinearizer;
+    denseLinearizer.init(simulator);
+    denseLinearizer.setSparseNumericDifferentiation(/*sparse=*/false, /*coloring=*/false);
+
+    LocalLinearizer sparseLinearizer;
+    sparseLinearizer.init(simulator);
+    sparseLinearizer.setSparseNumericDifferentiation(/*sparse=*/true, /*coloring=*/false);
+
+    LocalLinearizer coloredLinearizer;
+    coloredLinearizer.init(simulator);
+    coloredLinearizer.setSparseNumericDifferentiation(/*sparse=*/true, /*coloring=*/true);
+
+    ElementContext elemCtx(simulator);
+    Scalar maxRelError = 0.0;
+    for (const auto& elem : elements(simulator.gridView())) {
+        elemCtx.updateStencil(elem);
+        const unsigned numDof = elemCtx.numDof(/*timeIdx=*/0);
+        const unsigned numPrimaryDof = elemCtx.numPrimaryDof(/*timeIdx=*/0);
+
+        denseLinearizer.linearize(elem);
+        sparseLinearizer.linearize(elem);
+        coloredLinearizer.linearize(elem);
+
+        // the finite differences amplify the rounding errors, so the entries are
+        // compared relative to the largest entry of the element's Jacobian
+        Scalar maxEntry = 0.0;
+        for (unsigned i = 0; i < numDof; ++i)
+            for (unsigned j = 0; j < numPrimaryDof; ++j)
+                for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
+                    for (unsigned pvIdx = 0; pvIdx < numEq; ++pvIdx)
+                        maxEntry = std::max(maxEntry,
+                                            std::abs(denseLinearizer.jacobian(i, j)[eqIdx][pvIdx]));
+        maxEntry = std::max<Scalar>(maxEntry, 1e-30);
+
+        for (unsigned i = 0; i < numDof; ++i) {
+            for (unsigned j = 0; j < numPrimaryDof; ++j) {
+                for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx) {
+                    for (unsigned pvIdx = 0; pvIdx < numEq; ++pvIdx) {
+                        const Scalar dense = denseLinearizer.jacobian(i, j)[eqIdx][pvIdx];
+                        const Scalar sparse = sparseLinearizer.jacobian(i, j)[eqIdx][pvIdx];
+                        const Scalar colored = coloredLinearizer.jacobian(i, j)[eqIdx][pvIdx];
+                        maxRelError = std::max(maxRelError, std::abs(dense - sparse)/maxEntry);
+                        maxRelError = std::max(maxRelError, std::abs(dense - colored)/maxEntry);
+                    }
+                }
+            }
+        }
+    }
+
+    std::cout << "Maximum relative deviation of the sparse local Jacobians: "
+              << maxRelError << "\n";
+    return maxRelError < 1e-4;
+}
+
+template <class TypeTag>
+bool checkP1GradientsAreRejected()
+{
+    using LocalLinearizer = Opm::GetPropType<TypeTag, Opm::Properties::LocalLinearizer>;
+
+    LocalLinearizer linearizer;
+    try {
+        linearizer.setSparseNumericDifferentiation(/*sparse=*/true, /*coloring=*/true);
+    }
+    catch (const std::invalid_argument&) {
+        return true;
+    }
+
+    std::cout << "Sparse numeric differentiation was not rejected for P1 finite element gradients\n";
+    return false;
+}
+
+int main(int argc, char **argv)
+{
+    using TypeTag = Opm::Properties::TTag::LensProblemVcfvFdSparse;
+    using ThreadManager = Opm::GetPropType<TypeTag, Opm::Properties::ThreadManager>;
+
+    int status = Opm::setupParameters_<TypeTag>(argc, const_cast<const char**>(argv));
+    if (status == 1)
+        return 1;
+    if (status == 2)
+        return 0;
+
+    // MPI must be initialized first, so that the thread manager takes the other
+    // processes on the same machine into account
+    Dune::MPIHelper::instance(argc, argv);
+    ThreadManager::init();
+
+    if (!compareLocalJacobians<TypeTag>())
+        return 1;
+
+#if HAVE_DUNE_LOCALFUNCTIONS
+    using P1TypeTag = Opm::Properties::TTag::LensProblemVcfvFdSparseP1;
+    if (!checkP1GradientsAreRejected<P1TypeTag>())
+        return 1;
+#endif
+
+    return 0;
+}
@@ -62,6 +62,10 @@ namespace TTag {
 struct PowerInjectionBaseProblem {};
 }
 
+// Specifies whether the effort for solving the Forchheimer equation is printed
+template<class TypeTag, class MyTypeTag>
+struct PowerInjectionReportForchheimerSolves { using type = UndefinedProperty; };
+
 // Set the grid implementation to be used
 template<class TypeTag>
 struct Grid<TypeTag, TTag::PowerInjectionBaseProblem> { using type = Dune::YaspGrid</*dim=*/1>; };
@@ -170,6 +174,10 @@ struct InitialTimeStepSize<TypeTag, TTag::PowerInjectionBaseProblem>
     static constexpr type value = 1e-3;
 };
 
+// Do not print the effort for solving the Forchheimer equation by default
+template<class TypeTag>
+struct PowerInjectionReportForchheimerSolves<TypeTag, TTag::PowerInjectionBaseProblem> { static constexpr bool value = false; };
+
 } // namespace Opm::Properties
 
 namespace Opm {
@@ -254,9 +262,23 @@ public:
 
         K_ = this->toDimMatrix_(5.73e-08); // [m^2]
 
+        reportForchheimerSolves_ = EWOMS_GET_PARAM(TypeTag, bool, PowerInjectionReportForchheimerSolves);
+
         setupInitialFluidState_();
     }
 
+    /*!
+     * \copydoc FvBaseMultiPhaseProblem::registerParameters
+     */
+    static void registerParameters()
+    {
+        ParentType::registerParameters();
+
+        EWOMS_REGISTER_PARAM(TypeTag, bool, PowerInjectionReportForchheimerSolves,
+                             "Print the number of solves of the Forchheimer equation and "
+                             "the iterations they required at the end of each time step");
+    }
+
     /*!
      * \name Auxiliary methods
      */
@@ -301,6 +323,17 @@ public:
             std::cout << "Storage: " << storage << std::endl << std::flush;
         }
 #endif // NDEBUG
+
+        if constexpr (std::is_same<GetPropType<TypeTag, Properties::FluxModule>,
+                                   Opm::ForchheimerFluxModule<TypeTag> >::value) {
+            // report the effort for solving the Forchheimer equation of the process
+            std::size_t numSolves = this->numForchheimerSolves();
+            if (reportForchheimerSolves_ && numSolves > 0 && this->gridView().comm().rank() == 0)
+                std::cout << "Forchheimer velocity: " << numSolves << " solves, "
+                          << static_cast<double>(this->numForchheimerIterations())/numSolves
+                          << " iterations per solve\n" << std::flush;
+            this->resetForchheimerStatistics();
+        }
     }
     //! \}
 
@@ -461,6 +494,7 @@ private:
     Opm::ImmiscibleFluidState<Scalar, FluidSystem> initialFluidState_;
     Scalar temperature_;
     Scalar eps_;
+    bool reportForchheimerSolves_;
 };
 
 } // namespace Opm
@@ -0,0 +1,208 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Tests that reusing the hierarchy of the AMG across linear solves does not
+ *        impair the convergence of the linear solver.
+ *
+ * This is what the ParallelAmgBackend does if the AmgHierarchyRefreshInterval parameter
+ * is larger than one: The aggregates, the smoothers and the solver of the coarsest level
+ * are kept and only the Galerkin products of the coarse levels are recomputed for the
+ * new values of the matrix. The matrices of the test stem from consecutive Newton
+ * iterations, i.e., their sparsity pattern is the same while their values change by a
+ * few percent. Both smoothers which can be used by the backend are tested.
+ */
+#include "config.h"
+
+#include <opm/simulators/linalg/amgcoarsencriterion.hh>
+#include <opm/simulators/linalg/multicoloramgsmoother.hh>
+
+#include "blockmatrixfixtures.hh"
+
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/paamg/amg.hh>
+#include <dune/istl/preconditioners.hh>
+#include <dune/istl/solvers.hh>
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using Scalar = double;
+using MatrixBlock = Dune::FieldMatrix<Scalar, 2, 2>;
+using VectorBlock = Dune::FieldVector<Scalar, 2>;
+using Matrix = Dune::BCRSMatrix<MatrixBlock>;
+using Vector = Dune::BlockVector<VectorBlock>;
+using Operator = Dune::MatrixAdapter<Matrix, Vector, Vector>;
+
+constexpr std::size_t nx = 40;
+constexpr std::size_t ny = 40;
+constexpr int numNewtonIterations = 6;
+
+// the five-point stencil of a structured nx times ny grid of cells
+std::vector<std::vector<std::size_t> > gridNeighbors()
+{
+    std::vector<std::vector<std::size_t> > neighbors(nx*ny);
+    for (std::size_t cellIdx = 0; cellIdx < nx*ny; ++cellIdx) {
+        const std::size_t i = cellIdx % nx;
+        const std::size_t j = cellIdx / nx;
+        if (j > 0)
+            neighbors[cellIdx].push_back(cellIdx - nx);
+        if (i > 0)
+            neighbors[cellIdx].push_back(cellIdx - 1);
+        if (i + 1 < nx)
+            neighbors[cellIdx].push_back(cellIdx + 1);
+        if (j + 1 < ny)
+            neighbors[cellIdx].push_back(cellIdx + nx);
+    }
+    return neighbors;
+}
+
+// the Jacobian of a given Newton iteration. the matrix is only weakly diagonally
+// dominant, so the AMG depends on a good correction on the coarse levels. the diagonal
+// changes by up to four percent from one Newton iteration to the next.
+Matrix createJacobian(int newtonIdx)
+{
+    return Opm::Test::createCouplingMatrix<Matrix>(gridNeighbors(),
+                                                   [newtonIdx](std::size_t cellIdx)
+                                                   {
+                                                       const Scalar x = static_cast<Scalar>(cellIdx);
+                                                       return 4.6*(1.0 + 0.02*newtonIdx*(1.0 + std::sin(x)));
+                                                   });
+}
+
+// copy the values of a matrix exhibiting the same sparsity pattern
+void assignValues(Matrix& target, const Matrix& source)
+{
+    for (std::size_t rowIdx = 0; rowIdx < source.N(); ++rowIdx) {
+        auto targetIt = target[rowIdx].begin();
+        for (auto sourceIt = source[rowIdx].begin(); sourceIt != source[rowIdx].end(); ++sourceIt, ++targetIt)
+            *targetIt = *sourceIt;
+    }
+}
+
+template <class Smoother>
+class AmgSolver
+{
+    using Amg = Dune::Amg::AMG<Operator, Vector, Smoother>;
+    using SmootherArgs = typename Dune::Amg::SmootherTraits<Smoother>::Arguments;
+
+public:
+    explicit AmgSolver(Operator& op)
+        : op_(op)
+    {}
+
+    // set the AMG up from scratch
+    void setup()
+    {
+        SmootherArgs smootherArgs;
+        smootherArgs.iterations = 1;
+        smootherArgs.relaxationFactor = 1.0;
+
+        const auto coarsenCriterion =
+            Opm::Linear::amgCoarsenCriterion<Matrix>(/*coarsenTarget=*/50,
+                                                     /*dimension=*/2,
+                                                     /*verbosity=*/0);
+        amg_ = std::make_unique<Amg>(op_, coarsenCriterion, smootherArgs);
+    }
+
+    // keep the aggregates and recompute the coarse level matrices
+    void refresh()
+    { amg_->recalculateHierarchy(); }
+
+    // returns the number of iterations or -1 if the solver did not converge
+    int solve(const Vector& b)
+    {
+        Dune::BiCGSTABSolver<Vector> solver(op_,
+                                            *amg_,
+                                            /*reduction=*/1e-8,
+                                            /*maxIterations=*/200,
+                                            /*verbosity=*/0);
+        Vector x(b.size());
+        x = 0.0;
+        Vector rhs(b);
+        Dune::InverseOperatorResult result;
+        solver.apply(x, rhs, result);
+
+        return result.converged ? result.iterations : -1;
+    }
+
+private:
+    Operator& op_;
+    std::unique_ptr<Amg> amg_;
+};
+
+template <class Smoother>
+bool testHierarchyReuse(const std::string& smootherName)
+{
+    Matrix matrix = createJacobian(/*newtonIdx=*/0);
+    const Vector b = Opm::Test::createRhs<Vector>(matrix.N());
+    Operator op(matrix);
+
+    AmgSolver<Smoother> reusedSolver(op);
+    AmgSolver<Smoother> freshSolver(op);
+    reusedSolver.setup();
+    for (int newtonIdx = 0; newtonIdx < numNewtonIterations; ++newtonIdx) {
+        assignValues(matrix, createJacobian(newtonIdx));
+
+        if (newtonIdx > 0)
+            reusedSolver.refresh();
+        const int reusedIterations = reusedSolver.solve(b);
+
+        freshSolver.setup();
+        const int freshIterations = freshSolver.solve(b);
+
+        std::cout << smootherName << ", Newton iteration " << newtonIdx << ": "
+                  << freshIterations << " linear iterations with a new hierarchy, "
+                  << reusedIterations << " with the reused one\n";
+        if (freshIterations < 0 || reusedIterations < 0) {
+            std::cout << "The linear solver did not converge\n";
+            return false;
+        }
+        else if (reusedIterations > freshIterations + std::max(2, freshIterations/2)) {
+            std::cout << "Reusing the hierarchy of the AMG impairs the convergence\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main()
+{
+    if (!testHierarchyReuse<Dune::SeqSOR<Matrix, Vector, Vector> >("SOR"))
+        return 1;
+    if (!testHierarchyReuse<Opm::Linear::MultiColorAmgSmoother<Matrix, Vector> >("Multi-color Gauss-Seidel"))
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,237 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Tests the building blocks of the local solves of the Newton method.
+ *
+ * The matrices used by this test stem from a two-point discretization on a structured
+ * two-dimensional grid. The test partitions the cells into subdomains and applies
+ * Newton updates to the subdomains in the same way as the Newton method does.
+ */
+#include "config.h"
+
+#include <opm/models/nonlinear/newtonsubdomain.hh>
+
+#include "blockmatrixfixtures.hh"
+
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+using Scalar = double;
+using MatrixBlock = Dune::FieldMatrix<Scalar, 2, 2>;
+using VectorBlock = Dune::FieldVector<Scalar, 2>;
+using Matrix = Dune::BCRSMatrix<MatrixBlock>;
+using Vector = Dune::BlockVector<VectorBlock>;
+
+struct LinearizerWithSubDomains
+{ static constexpr bool linearizesCellSubDomains = true; };
+
+struct LinearizerWithoutSubDomains
+{ static constexpr bool linearizesCellSubDomains = false; };
+
+struct LinearizerWithoutFlag
+{};
+
+static_assert(Opm::LinearizesCellSubDomains<LinearizerWithSubDomains>::value,
+              "The flag of the linearizer must be detected");
+static_assert(!Opm::LinearizesCellSubDomains<LinearizerWithoutSubDomains>::value,
+              "The flag of the linearizer must be detected");
+static_assert(!Opm::LinearizesCellSubDomains<LinearizerWithoutFlag>::value,
+              "Linearizers without the flag must not support subdomains");
+
+constexpr std::size_t nx = 12;
+constexpr std::size_t ny = 9;
+
+// the five-point stencil of a structured nx times ny grid of cells
+std::vector<std::vector<std::size_t> > gridNeighbors()
+{
+    std::vector<std::vector<std::size_t> > neighbors(nx*ny);
+    for (std::size_t cellIdx = 0; cellIdx < nx*ny; ++cellIdx) {
+        const std::size_t i = cellIdx % nx;
+        const std::size_t j = cellIdx / nx;
+        if (j > 0)
+            neighbors[cellIdx].push_back(cellIdx - nx);
+        if (i > 0)
+            neighbors[cellIdx].push_back(cellIdx - 1);
+        if (i + 1 < nx)
+            neighbors[cellIdx].push_back(cellIdx + 1);
+        if (j + 1 < ny)
+            neighbors[cellIdx].push_back(cellIdx + nx);
+    }
+    return neighbors;
+}
+
+// a Jacobian of the grid whose values change from one Newton iteration to the next
+// while its sparsity pattern stays the same
+Matrix createGridMatrix(Scalar diagShift = 0.0)
+{
+    return Opm::Test::createCouplingMatrix<Matrix>(gridNeighbors(),
+                                                   [diagShift](std::size_t cellIdx)
+                                                   { return 5.0 + 0.1*(cellIdx % 7) + diagShift; });
+}
+
+// the last column of the grid is considered to be the overlap of the process
+std::vector<bool> interiorCells()
+{
+    std::vector<bool> isInterior(nx*ny);
+    for (std::size_t cellIdx = 0; cellIdx < nx*ny; ++cellIdx)
+        isInterior[cellIdx] = (cellIdx % nx) + 1 < nx;
+    return isInterior;
+}
+
+bool testPartition()
+{
+    const Matrix matrix = createGridMatrix();
+    const std::vector<bool> isInterior = interiorCells();
+    const auto domains = Opm::partitionNewtonSubDomains(matrix, isInterior, /*domainSize=*/10);
+
+    std::vector<int> domainOfCell(nx*ny, -1);
+    for (std::size_t domainIdx = 0; domainIdx < domains.size(); ++domainIdx) {
+        const auto& domain = domains[domainIdx];
+        if (domain.index != domainIdx || domain.cells.empty()) {
+            std::cout << "Subdomain " << domainIdx << " is malformed\n";
+            return false;
+        }
+
+        for (int cellIdx : domain.cells) {
+            if (!isInterior[cellIdx] || domainOfCell[cellIdx] >= 0) {
+                std::cout << "Cell " << cellIdx << " is assigned to a subdomain erroneously\n";
+                return false;
+            }
+            domainOfCell[cellIdx] = static_cast<int>(domainIdx);
+        }
+    }
+
+    for (std::size_t cellIdx = 0; cellIdx < nx*ny; ++cellIdx) {
+        if (isInterior[cellIdx] && domainOfCell[cellIdx] < 0) {
+            std::cout << "Cell " << cellIdx << " is not part of any subdomain\n";
+            return false;
+        }
+        else if (domainOfCell[cellIdx] < 0)
+            continue;
+
+        const auto& row = matrix[cellIdx];
+        for (auto colIt = row.begin(); colIt != row.end(); ++colIt) {
+            const int nbDomainIdx = domainOfCell[colIt.index()];
+            if (nbDomainIdx < 0 || nbDomainIdx == domainOfCell[cellIdx])
+                continue;
+            else if (domains[nbDomainIdx].color == domains[domainOfCell[cellIdx]].color) {
+                std::cout << "The adjacent subdomains " << nbDomainIdx << " and "
+                          << domainOfCell[cellIdx] << " exhibit the same color\n";
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// returns the maximum norm of the residual A*x - b restricted to the cells of a subdomain
+Scalar domainResidual(const Matrix& matrix,
+                      const Vector& x,
+                      const Vector& b,
+                      const Opm::NewtonSubDomain& domain)
+{
+    Vector residual(b.size());
+    matrix.mv(x, residual);
+    residual -= b;
+
+    Scalar result = 0.0;
+    for (int cellIdx : domain.cells)
+        result = std::max(result, residual[cellIdx].infinity_norm());
+    return result;
+}
+
+// the local solves of a linear problem must reduce the residual of each subdomain. the
+// local matrices are reused for the second matrix which exhibits different values.
+bool testLocalSolves()
+{
+    const std::size_t numCells = nx*ny;
+    const Vector b = Opm::Test::createRhs<Vector>(numCells);
+    const auto domains = Opm::partitionNewtonSubDomains(createGridMatrix(),
+                                                        interiorCells(),
+                                                        /*domainSize=*/10);
+
+    std::vector<Matrix> localMatrices(domains.size());
+    for (Scalar diagShift : { 0.0, 1.0 }) {
+        const Matrix matrix = createGridMatrix(diagShift);
+        Vector x(numCells);
+        x = 0.0;
+
+        for (const auto& domain : domains) {
+            Matrix& localMatrix = localMatrices[domain.index];
+            const MatrixBlock* firstBlock = (localMatrix.N() > 0) ? &localMatrix[0][0] : nullptr;
+
+            Vector residual(numCells);
+            matrix.mv(x, residual);
+            residual -= b;
+
+            Vector localResidual;
+            Opm::extractNewtonSubDomainSystem(matrix, residual, domain, localMatrix, localResidual);
+            if (firstBlock && firstBlock != &localMatrix[0][0]) {
+                std::cout << "The local matrix of subdomain " << domain.index << " was not reused\n";
+                return false;
+            }
+            if (localMatrix[0][0] != matrix[domain.cells[0]][domain.cells[0]]) {
+                std::cout << "The local matrix of subdomain " << domain.index << " was not updated\n";
+                return false;
+            }
+
+            Vector localUpdate;
+            if (!Opm::solveNewtonSubDomainSystem(localMatrix, localResidual, localUpdate, /*reduction=*/1e-8)) {
+                std::cout << "The linear solver did not converge for subdomain " << domain.index << "\n";
+                return false;
+            }
+
+            const Scalar initialError = domainResidual(matrix, x, b, domain);
+            for (std::size_t i = 0; i < domain.cells.size(); ++i)
+                x[domain.cells[i]] -= localUpdate[i];
+            const Scalar error = domainResidual(matrix, x, b, domain);
+            if (!(error < 1e-6*initialError)) {
+                std::cout << "The local solve did not reduce the residual of subdomain "
+                          << domain.index << ": " << initialError << " -> " << error << "\n";
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+int main()
+{
+    if (!testPartition())
+        return 1;
+    if (!testLocalSolves())
+        return 1;
+
+    return 0;
+}
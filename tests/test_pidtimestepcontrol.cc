@@ -0,0 +1,145 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Tests the response of the PID time step control to growing and decaying
+ *        changes of the solution and to failed time steps.
+ */
+#include "config.h"
+
+#include <opm/models/utils/pidtimestepcontrol.hh>
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+using Scalar = double;
+using TimeStepControl = Opm::PidTimeStepControl<Scalar>;
+
+constexpr Scalar tolerance = 1e-1;
+constexpr Scalar dt = 10.0;
+
+// returns the time step size suggested after the given relative solution changes
+Scalar suggestAfter(const std::vector<Scalar>& relChanges)
+{
+    TimeStepControl control(tolerance);
+    for (Scalar relChange : relChanges)
+        control.registerSolutionChange(relChange);
+    return control.suggestTimeStepSize(dt);
+}
+
+bool check(bool condition, const char* msg)
+{
+    if (!condition)
+        std::cout << msg << "\n";
+    return condition;
+}
+
+bool testSuccessfulSteps()
+{
+    bool ok = true;
+
+    ok = check(suggestAfter({}) == dt,
+               "Without any history, the time step size must not be changed") && ok;
+
+    // the solution changes exactly as much as desired
+    ok = check(std::abs(suggestAfter({tolerance, tolerance, tolerance}) - dt) < 1e-12*dt,
+               "The time step size must be kept if the change equals the tolerance") && ok;
+
+    // too large changes reduce the step proportionally, but by at most a factor of five
+    ok = check(std::abs(suggestAfter({2*tolerance}) - dt/2) < 1e-12*dt,
+               "A change twice as large as the tolerance must halve the time step size") && ok;
+    ok = check(std::abs(suggestAfter({1e3*tolerance}) - 0.2*dt) < 1e-12*dt,
+               "The time step size must not be reduced by more than a factor of five") && ok;
+
+    // small changes increase the step, but by at most a factor of three
+    const Scalar grownDt = suggestAfter({0.5*tolerance});
+    ok = check(grownDt > dt && grownDt < 3*dt,
+               "A change below the tolerance must increase the time step size") && ok;
+    ok = check(std::abs(suggestAfter({1e-8*tolerance}) - 3*dt) < 1e-12*dt,
+               "The time step size must not be increased by more than a factor of three") && ok;
+
+    // with the full history, the controller reacts to the trend of the changes: for the
+    // same most recent change, growing changes lead to smaller steps than decaying ones
+    const Scalar growingDt = suggestAfter({0.1*tolerance, 0.2*tolerance, 0.4*tolerance});
+    const Scalar steadyDt = suggestAfter({0.4*tolerance, 0.4*tolerance, 0.4*tolerance});
+    const Scalar decayingDt = suggestAfter({1.6*tolerance, 0.8*tolerance, 0.4*tolerance});
+    ok = check(growingDt < steadyDt && steadyDt < decayingDt,
+               "Growing changes of the solution must lead to smaller time steps than "
+               "decaying ones") && ok;
+    ok = check(growingDt > dt,
+               "Changes below the tolerance must increase the time step size even if they grow") && ok;
+
+    // only the last three changes are considered
+    ok = check(std::abs(suggestAfter({10*tolerance, 0.4*tolerance, 0.4*tolerance, 0.4*tolerance}) - steadyDt) < 1e-12*dt,
+               "Changes older than three time steps must be ignored") && ok;
+
+    TimeStepControl control(tolerance);
+    control.registerSolutionChange(0.01*tolerance);
+    control.reset();
+    ok = check(control.suggestTimeStepSize(dt) == dt,
+               "The history must be discarded by reset()") && ok;
+
+    return ok;
+}
+
+bool testFailedSteps()
+{
+    const TimeStepControl control(tolerance);
+    const Scalar newtonTolerance = 1e-8;
+    const int targetIterations = 6;
+    bool ok = true;
+
+    // no error reduction at all, or a diverging Newton method
+    ok = check(control.suggestRetryTimeStepSize(dt, 1.0, 2.0, newtonTolerance, 10, targetIterations) == 0.1*dt,
+               "A growing Newton error must reduce the time step size by a factor of ten") && ok;
+    ok = check(control.suggestRetryTimeStepSize(dt, 1.0, std::numeric_limits<Scalar>::quiet_NaN(),
+                                                newtonTolerance, 10, targetIterations) == 0.1*dt,
+               "A non-finite Newton error must reduce the time step size by a factor of ten") && ok;
+
+    // the error was reduced by four orders of magnitude in ten iterations, so about 20
+    // iterations would have been required for convergence
+    const Scalar slowDt = control.suggestRetryTimeStepSize(dt, 1.0, 1e-4, newtonTolerance, 10, targetIterations);
+    ok = check(std::abs(slowDt - dt*targetIterations/20.0) < 1e-12*dt,
+               "The retried time step must be scaled by the ratio of the target and the "
+               "estimated number of iterations") && ok;
+
+    // a faster reduction must lead to a larger retry, but the step is at least halved
+    const Scalar fastDt = control.suggestRetryTimeStepSize(dt, 1.0, 1e-7, newtonTolerance, 10, targetIterations);
+    ok = check(fastDt > slowDt && fastDt == 0.5*dt,
+               "The retried time step must be at least halved") && ok;
+
+    return ok;
+}
+
+int main()
+{
+    if (!testSuccessfulSteps())
+        return 1;
+    if (!testFailedSteps())
+        return 1;
+
+    return 0;
+}
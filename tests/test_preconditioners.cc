@@ -0,0 +1,261 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Tests that the preconditioners which keep data derived from the sparsity
+ *        pattern of the matrix react to changes of the pattern.
+ *
+ * The matrices used by this test couple their rows along a path, i.e., they are
+ * tridiagonal if the rows are numbered along the path. Changing the path changes the
+ * sparsity pattern but neither the number of rows nor the number of non-zero entries.
+ */
+#include "config.h"
+
+#include <opm/simulators/linalg/sparsitypatterntracker.hh>
+#include <opm/simulators/linalg/reorderedpreconditioner.hh>
+#include <opm/simulators/linalg/multicolorpreconditioner.hh>
+#include <opm/simulators/linalg/cprpreconditioner.hh>
+
+#include "blockmatrixfixtures.hh"
+
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/preconditioners.hh>
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using Scalar = double;
+using MatrixBlock = Dune::FieldMatrix<Scalar, 2, 2>;
+using VectorBlock = Dune::FieldVector<Scalar, 2>;
+using Matrix = Dune::BCRSMatrix<MatrixBlock>;
+using Vector = Dune::BlockVector<VectorBlock>;
+
+// create a matrix which couples the rows along the given path
+Matrix createPathMatrix(const std::vector<std::size_t>& path, Scalar diagShift = 0.0)
+{
+    std::vector<std::vector<std::size_t> > neighbors(path.size());
+    for (std::size_t i = 0; i + 1 < path.size(); ++i) {
+        neighbors[path[i]].push_back(path[i + 1]);
+        neighbors[path[i + 1]].push_back(path[i]);
+    }
+
+    return Opm::Test::createCouplingMatrix<Matrix>(neighbors,
+                                                   [diagShift](std::size_t rowIdx)
+                                                   { return 4.0 + 0.1*rowIdx + diagShift; });
+}
+
+std::vector<std::size_t> straightPath(std::size_t numRows)
+{
+    std::vector<std::size_t> path(numRows);
+    for (std::size_t i = 0; i < numRows; ++i)
+        path[i] = i;
+    return path;
+}
+
+// visits the even rows in ascending and the odd ones in descending order
+std::vector<std::size_t> zigzagPath(std::size_t numRows)
+{
+    std::vector<std::size_t> path;
+    for (std::size_t i = 0; i < numRows; i += 2)
+        path.push_back(i);
+    for (std::size_t i = numRows; i > 0; --i)
+        if ((i - 1) % 2 == 1)
+            path.push_back(i - 1);
+    return path;
+}
+
+bool testPatternTracker()
+{
+    const std::size_t numRows = 10;
+    const Matrix a = createPathMatrix(straightPath(numRows));
+    const Matrix b = createPathMatrix(zigzagPath(numRows));
+    if (a.nonzeroes() != b.nonzeroes()) {
+        std::cout << "The test matrices must exhibit the same number of non-zeros\n";
+        return false;
+    }
+
+    Opm::Linear::SparsityPatternTracker tracker;
+    if (!tracker.update(a)) {
+        std::cout << "The first pattern was not reported as a change\n";
+        return false;
+    }
+    if (tracker.update(a)) {
+        std::cout << "An unchanged pattern was reported as a change\n";
+        return false;
+    }
+    if (!tracker.update(b)) {
+        std::cout << "A pattern with the same number of non-zeros was not detected as a change\n";
+        return false;
+    }
+
+    return true;
+}
+
+// the reverse Cuthill-McKee ordering renumbers the rows along the path, so ILU(0) of the
+// permuted matrix is an exact factorization
+bool testReorderedIlu()
+{
+    using InnerPreconditioner = Dune::SeqILU<Matrix, Vector, Vector>;
+    using Preconditioner = Opm::Linear::ReorderedPreconditioner<InnerPreconditioner, Vector>;
+
+    const std::size_t numRows = 11;
+    const Vector d = Opm::Test::createRhs<Vector>(numRows);
+
+    Opm::Linear::SparsityPatternTracker pattern;
+    std::unique_ptr<Preconditioner> preCond;
+    for (const auto& path : { straightPath(numRows), zigzagPath(numRows) }) {
+        const Matrix matrix = createPathMatrix(path);
+
+        // this is what the PreconditionerWrapperReorderedILU does
+        if (pattern.update(matrix) || !preCond)
+            preCond = std::make_unique<Preconditioner>(Opm::Linear::reverseCuthillMcKeeOrdering(matrix));
+        preCond->updateMatrix(matrix);
+        preCond->setInnerPreconditioner(std::make_unique<InnerPreconditioner>(preCond->permutedMatrix(), 1.0));
+
+        Vector v(numRows);
+        v = 0.0;
+        preCond->apply(v, d);
+        const Scalar residual = Opm::Test::relativeResidual(matrix, v, d);
+        if (!(residual < 1e-10)) {
+            std::cout << "Reordered ILU(0) is not exact for a path matrix: "
+                      << "relative residual " << residual << "\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// ILU(0) in the order of the colors must be the same as ILU(0) of the matrix which is
+// permuted such that the rows are sorted by their colors. The same preconditioner object
+// is used for both patterns.
+bool testMultiColorIlu()
+{
+    using Preconditioner = Opm::Linear::MultiColorPreconditioner<Matrix, Vector>;
+    using InnerPreconditioner = Dune::SeqILU<Matrix, Vector, Vector>;
+    using ReferencePreconditioner = Opm::Linear::ReorderedPreconditioner<InnerPreconditioner, Vector>;
+
+    const std::size_t numRows = 11;
+    const Vector d = Opm::Test::createRhs<Vector>(numRows);
+
+    Preconditioner preCond(Preconditioner::Method::ILU0, /*relaxationFactor=*/1.0);
+    for (const auto& path : { straightPath(numRows), zigzagPath(numRows) }) {
+        const Matrix matrix = createPathMatrix(path);
+        preCond.updateMatrix(matrix);
+
+        const std::vector<unsigned> rowColor = Opm::Linear::greedyMultiColoring(matrix);
+        std::vector<std::size_t> ordering = straightPath(numRows);
+        std::stable_sort(ordering.begin(), ordering.end(),
+                         [&rowColor](std::size_t a, std::size_t b)
+                         { return rowColor[a] < rowColor[b]; });
+        ReferencePreconditioner reference(ordering);
+        reference.updateMatrix(matrix);
+        reference.setInnerPreconditioner(std::make_unique<InnerPreconditioner>(reference.permutedMatrix(), 1.0));
+
+        Vector v(numRows);
+        v = 0.0;
+        preCond.apply(v, d);
+        Vector vRef(numRows);
+        vRef = 0.0;
+        reference.apply(vRef, d);
+
+        vRef -= v;
+        const Scalar deviation = vRef.infinity_norm()/v.infinity_norm();
+        if (!(deviation < 1e-12)) {
+            std::cout << "Multi-color ILU(0) deviates from ILU(0) in the order of the colors: "
+                      << "relative deviation " << deviation << "\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// an object which is updated for several matrices must yield the same results as an
+// object which is created for each of them
+bool testCpr()
+{
+    using Preconditioner = Opm::Linear::CprPreconditioner<Matrix, Vector>;
+
+    const std::size_t numRows = 11;
+    const Vector d = Opm::Test::createRhs<Vector>(numRows);
+    const auto createPreconditioner = []()
+    {
+        return std::make_unique<Preconditioner>(/*pressureIdx=*/0,
+                                                /*coarsenTarget=*/2,
+                                                /*dimension=*/1,
+                                                /*refreshInterval=*/1,
+                                                /*relaxationFactor=*/1.0);
+    };
+
+    const std::vector<Matrix> matrices = {
+        createPathMatrix(straightPath(numRows)),
+        createPathMatrix(straightPath(numRows), /*diagShift=*/1.0),
+        createPathMatrix(zigzagPath(numRows))
+    };
+
+    auto preCond = createPreconditioner();
+    for (const auto& matrix : matrices) {
+        preCond->updateMatrix(matrix);
+        auto reference = createPreconditioner();
+        reference->updateMatrix(matrix);
+
+        Vector v(numRows);
+        v = 0.0;
+        preCond->apply(v, d);
+        Vector vRef(numRows);
+        vRef = 0.0;
+        reference->apply(vRef, d);
+
+        vRef -= v;
+        const Scalar deviation = vRef.infinity_norm()/v.infinity_norm();
+        if (!(deviation < 1e-12)) {
+            std::cout << "Updating the CPR preconditioner yields a different result than "
+                      << "recreating it: relative deviation " << deviation << "\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main()
+{
+    if (!testPatternTracker())
+        return 1;
+    if (!testReorderedIlu())
+        return 1;
+    if (!testMultiColorIlu())
+        return 1;
+    if (!testCpr())
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,162 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Tests that re-partitioning a grid with weights for the elements balances the
+ *        total weight of the processes and moves the attached data to the new owners.
+ *
+ * The elements in the left quarter of the domain are ten times as expensive as the
+ * other ones, so a partition which balances the number of elements is unbalanced.
+ */
+#include "config.h"
+
+#include <opm/models/parallel/weightedloadbalancing.hh>
+#include <opm/models/parallel/gridcommhandles.hh>
+
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/common/fvector.hh>
+#include <dune/grid/common/mcmgmapper.hh>
+
+#if HAVE_DUNE_ALUGRID
+#include <dune/alugrid/grid.hh>
+#include <dune/alugrid/common/structuredgridfactory.hh>
+#endif
+
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#if HAVE_DUNE_ALUGRID
+using Grid = Dune::ALUGrid</*dim=*/2, /*dimWorld=*/2, Dune::cube, Dune::nonconforming>;
+using GridView = Grid::LeafGridView;
+using Element = Grid::Codim<0>::Entity;
+using ElementMapper = Dune::MultipleCodimMultipleGeomTypeMapper<GridView>;
+using IdSet = Grid::GlobalIdSet;
+using MigrateHandle = Opm::GridCommHandleMigrate<double, IdSet, /*commCodim=*/0>;
+
+double elementCost(const Element& elem)
+{ return (elem.geometry().center()[0] < 0.25) ? 10.0 : 1.0; }
+
+// returns the ratio between the maximum and the average cost of the processes
+double imbalance(const Grid& grid)
+{
+    double localCost = 0.0;
+    for (const auto& elem : elements(grid.leafGridView(), Dune::Partitions::interior))
+        localCost += elementCost(elem);
+
+    const auto& comm = grid.comm();
+    return comm.max(localCost)/(comm.sum(localCost)/comm.size());
+}
+
+int numInteriorElements(const Grid& grid)
+{
+    int n = 0;
+    for ([[maybe_unused]] const auto& elem : elements(grid.leafGridView(), Dune::Partitions::interior))
+        ++n;
+    return grid.comm().sum(n);
+}
+
+bool testWeightedRepartitioning()
+{
+    using GlobalPosition = Dune::FieldVector<Grid::ctype, 2>;
+    const GlobalPosition lowerLeft(0.0);
+    const GlobalPosition upperRight(1.0);
+    const std::array<unsigned, 2> cellRes = {32, 32};
+    auto grid = Dune::StructuredGridFactory<Grid>::createCubeGrid(lowerLeft, upperRight, cellRes);
+    grid->loadBalance();
+
+    const auto& comm = grid->comm();
+    const int numElements = numInteriorElements(*grid);
+    const double imbalanceBefore = imbalance(*grid);
+
+    // the x coordinate of the center of each element is moved along with it
+    const IdSet& idSet = grid->globalIdSet();
+    MigrateHandle::Container values;
+    ElementMapper elementMapper(grid->leafGridView(), Dune::mcmgElementLayout());
+    std::vector<double> weights(static_cast<std::size_t>(grid->leafGridView().size(/*codim=*/0)), 0.0);
+    for (const auto& elem : elements(grid->leafGridView())) {
+        values[idSet.id(elem)] = { elem.geometry().center()[0] };
+        weights[elementMapper.index(elem)] = elementCost(elem);
+    }
+
+    MigrateHandle migrateHandle(values, idSet, /*numValues=*/1);
+    Opm::WeightedLoadBalancing<Grid>::repartition(*grid, elementMapper, weights, migrateHandle);
+
+    const double imbalanceAfter = imbalance(*grid);
+    if (comm.rank() == 0)
+        std::cout << "Cost of the most expensive process relative to the average: "
+                  << imbalanceBefore << " before and "
+                  << imbalanceAfter << " after the re-partitioning\n";
+
+    if (numInteriorElements(*grid) != numElements) {
+        if (comm.rank() == 0)
+            std::cout << "The number of elements changed during the re-partitioning\n";
+        return false;
+    }
+
+    // dune-alugrid does not re-partition the grid if the most expensive process is
+    // less than 20% more expensive than the average
+    if (!(imbalanceAfter < 1.2)) {
+        if (comm.rank() == 0)
+            std::cout << "The weights of the elements were not balanced\n";
+        return false;
+    }
+
+    int numWrongValues = 0;
+    for (const auto& elem : elements(grid->leafGridView(), Dune::Partitions::interior)) {
+        const auto valuesIt = values.find(idSet.id(elem));
+        if (valuesIt == values.end()
+            || valuesIt->second.size() != 1
+            || std::abs(valuesIt->second[0] - elem.geometry().center()[0]) > 1e-12)
+            ++numWrongValues;
+    }
+    numWrongValues = comm.sum(numWrongValues);
+    if (numWrongValues > 0) {
+        if (comm.rank() == 0)
+            std::cout << numWrongValues << " elements did not receive their data\n";
+        return false;
+    }
+
+    return true;
+}
+#endif // HAVE_DUNE_ALUGRID
+
+int main(int argc, char** argv)
+{
+    Dune::MPIHelper::instance(argc, argv);
+
+    static_assert(!Opm::WeightedLoadBalancing<int>::isSupported,
+                  "Only grids with a weighted load balancer may be supported");
+
+#if HAVE_DUNE_ALUGRID
+    static_assert(Opm::WeightedLoadBalancing<Grid>::isSupported,
+                  "The load balancer of dune-alugrid accepts weights");
+
+    if (!testWeightedRepartitioning())
+        return 1;
+#endif
+
+    return 0;
+}